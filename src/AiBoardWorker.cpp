@@ -0,0 +1,104 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "AiBoardWorker.h"
+
+#include <chrono>
+
+#include "AioDevice.h"
+#include "SampleClock.h"
+#include "ScanRing.h"
+
+AiBoardWorker::AiBoardWorker()
+    : m_Dev(nullptr), m_Ring(nullptr), m_Clock(nullptr), m_Channels(0), m_PollSec(0.0)
+    , m_Stop(false), m_Errors(0), m_Restarts(0)
+{
+}
+
+AiBoardWorker::~AiBoardWorker()
+{
+    Stop();
+}
+
+void AiBoardWorker::Start(IAioDevice* dev, ScanRing* ring, SampleClock* clock,
+                          int channels, long chunkScans, double pollSec)
+{
+    Stop();
+    m_Dev      = dev;
+    m_Ring     = ring;
+    m_Clock    = clock;
+    m_Channels = channels;
+    m_PollSec  = (pollSec > 0.001) ? pollSec : 0.001;
+    m_Buf.assign(static_cast<size_t>(chunkScans > 0 ? chunkScans : 1) * channels, 0L);
+    m_Stop     = false;
+    m_Thread   = std::thread(&AiBoardWorker::Loop, this);
+}
+
+void AiBoardWorker::Stop()
+{
+    if (!m_Thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+    m_Thread.join();
+}
+
+void AiBoardWorker::Loop()
+{
+    const auto period = std::chrono::microseconds(static_cast<long long>(m_PollSec * 1e6));
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (!m_Stop) {
+        m_Wake.wait_for(lock, period);
+        if (m_Stop) break;
+        lock.unlock();
+        Poll();
+        lock.lock();
+    }
+}
+
+void AiBoardWorker::Poll()
+{
+    long status = 0;
+    if (m_Dev->GetAiStatus(&status) == 0 && (status & AIO_AIS_ERRORS)) {
+        // Overflow / clock / conversion error: restart and re-anchor
+        m_Dev->StopAi();
+        m_Dev->ResetAiMemory();
+        if (m_Dev->StartAi() != 0) m_Errors.fetch_add(1, std::memory_order_relaxed);
+        m_Clock->Restart(m_Ring->Written());
+        m_Restarts.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const long chunk = long(m_Buf.size() / m_Channels);
+    long pending = 0;
+    long ret = m_Dev->GetAiSamplingCount(&pending);
+    while (ret == 0 && pending > 0) {
+        long n = (pending < chunk) ? pending : chunk;
+        ret = m_Dev->GetAiSamplingData(&n, m_Buf.data());
+        if (ret != 0 || n <= 0) break;
+        const uint64_t next = m_Ring->Written();
+        const size_t stored = m_Ring->Push(m_Buf.data(), static_cast<size_t>(n));
+        if (stored < static_cast<size_t>(n))
+            m_Clock->Skip(next + stored, static_cast<uint64_t>(n) - stored);
+        pending -= n;
+    }
+    if (ret != 0) m_Errors.fetch_add(1, std::memory_order_relaxed);
+    m_Clock->Observe(m_Ring->Written());
+}
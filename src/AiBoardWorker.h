@@ -0,0 +1,83 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AIBOARDWORKER_H_INCLUDE__
+#define __AIBOARDWORKER_H_INCLUDE__
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class IAioDevice;
+class SampleClock;
+class ScanRing;
+
+/**
+ * Acquisition thread for a secondary AD board.
+ *
+ * The clock-master board (AIO000) is read from its AIOM_AIE_DATA_NUM
+ * handler on the UI thread; every further board gets one of these. It
+ * polls the board each period, moves whatever it holds into the board's
+ * own ScanRing and keeps the board's SampleClock (started with
+ * StartFrom(master clock)) up to date, so AD_INPUT() can merge the
+ * boards by time. Board errors (AIO_AIS_ERRORS) restart acquisition
+ * and re-anchor the clock, like RecoverAi() does for the master.
+ */
+class AiBoardWorker
+{
+public:
+    AiBoardWorker();
+    ~AiBoardWorker();
+
+    // The board must already be configured and started (StartAi)
+    void Start(IAioDevice* dev, ScanRing* ring, SampleClock* clock,
+               int channels, long chunkScans, double pollSec);
+    void Stop();
+
+    bool     Running() const  { return m_Thread.joinable(); }
+    uint64_t Errors() const   { return m_Errors.load(std::memory_order_relaxed); }
+    uint64_t Restarts() const { return m_Restarts.load(std::memory_order_relaxed); }
+
+private:
+    AiBoardWorker(const AiBoardWorker&) = delete;
+    AiBoardWorker& operator=(const AiBoardWorker&) = delete;
+
+    void Loop();
+    void Poll();
+
+    IAioDevice*  m_Dev;
+    ScanRing*    m_Ring;
+    SampleClock* m_Clock;
+    int          m_Channels;
+    double       m_PollSec;
+    std::vector<long> m_Buf;           // one chunk of raw scans
+
+    std::thread             m_Thread;
+    std::mutex              m_Mutex;
+    std::condition_variable m_Wake;
+    bool                    m_Stop;
+    std::atomic<uint64_t>   m_Errors;   // failed AIO calls
+    std::atomic<uint64_t>   m_Restarts; // acquisition restarts after a board error
+};
+
+#endif // __AIBOARDWORKER_H_INCLUDE__
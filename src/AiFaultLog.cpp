@@ -0,0 +1,107 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "AiFaultLog.h"
+
+AiFaultLog::AiFaultLog()
+{
+    Reset();
+}
+
+void AiFaultLog::Reset()
+{
+    for (int k = 0; k < AI_FAULT_KINDS; k++) m_Count[k].store(0, std::memory_order_relaxed);
+    m_LostScans.store(0, std::memory_order_relaxed);
+    m_Discarded.store(0, std::memory_order_relaxed);
+    m_Stopped.store(false, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Queue.clear();
+    m_Gaps.clear();
+    m_LostSeconds = 0.0;
+    m_Restarts.clear();
+}
+
+void AiFaultLog::Post(const AiFaultEvent& e)
+{
+    if (e.Kind < 0 || e.Kind >= AI_FAULT_KINDS) return;
+    m_Count[e.Kind].fetch_add(1, std::memory_order_relaxed);
+    m_LostScans.fetch_add(e.Lost, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_Queue.size() >= kQueueDepth) {
+        m_Queue.pop_front();
+        m_Discarded.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_Queue.push_back(e);
+    if (e.GapEnd > e.GapStart) {
+        m_LostSeconds += e.GapEnd - e.GapStart;
+        if (m_Gaps.size() < kQueueDepth) m_Gaps.push_back(e);
+    }
+}
+
+size_t AiFaultLog::TakeGaps(std::vector<AiFaultEvent>* out)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const size_t n = m_Gaps.size();
+    if (out) out->insert(out->end(), m_Gaps.begin(), m_Gaps.end());
+    m_Gaps.clear();
+    return n;
+}
+
+bool AiFaultLog::AllowRestart(double hostNow)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    while (!m_Restarts.empty() && hostNow - m_Restarts.front() > kRestartWindow)
+        m_Restarts.pop_front();
+    if (int(m_Restarts.size()) >= kMaxRestarts) return false;
+    m_Restarts.push_back(hostNow);
+    return true;
+}
+
+uint64_t AiFaultLog::Count(int kind) const
+{
+    if (kind < 0 || kind >= AI_FAULT_KINDS) return 0;
+    return m_Count[kind].load(std::memory_order_relaxed);
+}
+
+uint64_t AiFaultLog::Total() const
+{
+    uint64_t n = 0;
+    for (int k = 0; k < AI_FAULT_KINDS; k++) n += m_Count[k].load(std::memory_order_relaxed);
+    return n;
+}
+
+double AiFaultLog::LostSeconds() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_LostSeconds;
+}
+
+const char* AiFaultLog::KindName(int kind)
+{
+    switch (kind) {
+    case AI_FAULT_OVERFLOW:   return "overflow";
+    case AI_FAULT_SAMPLING:   return "sampling error";
+    case AI_FAULT_CONVERSION: return "A/D error";
+    case AI_FAULT_READ:       return "read error";
+    case AI_FAULT_RING:       return "ring full";
+    case AI_FAULT_END:        return "sampling ended";
+    case AI_FAULT_RETUNE:     return "burst resize";
+    default:                  return "unknown";
+    }
+}
@@ -0,0 +1,118 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AIFAULTLOG_H_INCLUDE__
+#define __AIFAULTLOG_H_INCLUDE__
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+enum AiFaultKind {
+    AI_FAULT_OVERFLOW = 0,  // AIOM_AIE_OFERR: board memory overflowed
+    AI_FAULT_SAMPLING,      // AIOM_AIE_SCERR: sampling clock error
+    AI_FAULT_CONVERSION,    // AIOM_AIE_ADERR: A/D conversion error
+    AI_FAULT_READ,          // AioGetAiSamplingData failed
+    AI_FAULT_RING,          // ai.ring full, scans discarded
+    AI_FAULT_END,           // AIOM_AIE_END: sampling stopped by the board
+    AI_FAULT_RETUNE,        // restart to change the event burst size (BurstTuner)
+    AI_FAULT_KINDS
+};
+
+/**
+ * One acquisition fault. GapStart/GapEnd are ai.clock times [s] of the
+ * interval with no data (equal when nothing was lost).
+ */
+struct AiFaultEvent {
+    int      Kind;
+    long     Code;          // AIO return code, 0 if none
+    uint64_t Scan;          // first scan index after the fault
+    uint64_t Lost;          // scans missing (estimated for restarts)
+    double   GapStart;
+    double   GapEnd;
+    bool     Recovered;     // acquisition restarted automatically
+};
+
+/**
+ * Acquisition faults, posted by the AD event handler without blocking.
+ *
+ * Keeps per-kind counters, a bounded queue of events for the UI (Drain)
+ * and a separate list of data gaps for the loggers (TakeGaps), so the
+ * handler can recover and return to the message pump immediately.
+ * Restarts are rate-limited: AllowRestart() refuses once kMaxRestarts
+ * have been attempted within kRestartWindow seconds.
+ */
+class AiFaultLog
+{
+public:
+    AiFaultLog();
+
+    void Reset();
+    void Post(const AiFaultEvent& e);
+
+    // Consumer side (UI thread)
+    template <typename F> size_t Drain(F fn);
+    size_t   TakeGaps(std::vector<AiFaultEvent>* out);
+
+    bool     AllowRestart(double hostNow);
+    void     SetStopped(bool stopped) { m_Stopped.store(stopped, std::memory_order_relaxed); }
+    bool     Stopped() const          { return m_Stopped.load(std::memory_order_relaxed); }
+
+    uint64_t Count(int kind) const;
+    uint64_t Total() const;
+    uint64_t LostScans() const        { return m_LostScans.load(std::memory_order_relaxed); }
+    double   LostSeconds() const;
+    uint64_t Discarded() const        { return m_Discarded.load(std::memory_order_relaxed); }
+
+    static const char* KindName(int kind);
+
+    static const size_t kQueueDepth    = 256;
+    static const int    kMaxRestarts   = 5;
+    static const int    kRestartWindow = 10;
+
+private:
+    std::atomic<uint64_t> m_Count[AI_FAULT_KINDS];
+    std::atomic<uint64_t> m_LostScans;
+    std::atomic<uint64_t> m_Discarded;     // events dropped from a full queue
+    std::atomic<bool>     m_Stopped;       // recovery given up
+
+    mutable std::mutex       m_Mutex;
+    std::deque<AiFaultEvent> m_Queue;
+    std::vector<AiFaultEvent> m_Gaps;
+    double                   m_LostSeconds;
+    std::deque<double>       m_Restarts;   // host times of recent restarts
+};
+
+template <typename F>
+size_t AiFaultLog::Drain(F fn)
+{
+    std::deque<AiFaultEvent> batch;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        batch.swap(m_Queue);
+    }
+    for (const AiFaultEvent& e : batch) fn(e);
+    return batch.size();
+}
+
+#endif // __AIFAULTLOG_H_INCLUDE__
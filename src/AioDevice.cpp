@@ -0,0 +1,153 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "AioDevice.h"
+#include "AioSimDevice.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "caio.h"
+
+namespace {
+
+// ============================================================
+// CONTEC API-AIO backend: thin forwarding to caio.lib
+// ============================================================
+class CAioContecDevice : public IAioDevice
+{
+public:
+    CAioContecDevice() : m_Id(-1) {}
+    virtual ~CAioContecDevice() { if (m_Id >= 0) AioExit(m_Id); }
+
+    virtual const char* BackendName() const { return "contec"; }
+
+    virtual long Init(const char* deviceName)
+    {
+        return AioInit(const_cast<char*>(deviceName), &m_Id);
+    }
+    virtual long Exit()
+    {
+        const long ret = AioExit(m_Id);
+        m_Id = -1;
+        return ret;
+    }
+    virtual long ResetDevice()                                    { return AioResetDevice(m_Id); }
+    virtual long GetErrorString(long errorCode, char* errorString) { return AioGetErrorString(errorCode, errorString); }
+
+    virtual long GetAiInputMethod(short* inputMethod)             { return AioGetAiInputMethod(m_Id, inputMethod); }
+    virtual long GetAiResolution(short* resolution)               { return AioGetAiResolution(m_Id, resolution); }
+    virtual long GetAiMaxChannels(short* maxChannels)             { return AioGetAiMaxChannels(m_Id, maxChannels); }
+    virtual long SetAiChannels(short channels)                    { return AioSetAiChannels(m_Id, channels); }
+    virtual long SetAiRangeAll(short range)                       { return AioSetAiRangeAll(m_Id, range); }
+    virtual long GetAiRange(short channel, short* range)          { return AioGetAiRange(m_Id, channel, range); }
+    virtual long GetAiMemoryType(short* memoryType)               { return AioGetAiMemoryType(m_Id, memoryType); }
+    virtual long SetAiScanClock(float scanClock)                  { return AioSetAiScanClock(m_Id, scanClock); }
+    virtual long GetAiScanClock(float* scanClock)                 { return AioGetAiScanClock(m_Id, scanClock); }
+    virtual long SetAiSamplingClock(float samplingClock)          { return AioSetAiSamplingClock(m_Id, samplingClock); }
+    virtual long GetAiSamplingClock(float* samplingClock)         { return AioGetAiSamplingClock(m_Id, samplingClock); }
+    virtual long SetAiEventSamplingTimes(long samplingTimes)      { return AioSetAiEventSamplingTimes(m_Id, samplingTimes); }
+    virtual long GetAiEventSamplingTimes(long* samplingTimes)     { return AioGetAiEventSamplingTimes(m_Id, samplingTimes); }
+    virtual long SetAiStopTrigger(short stopTrigger)              { return AioSetAiStopTrigger(m_Id, stopTrigger); }
+    virtual long SetAiEvent(void* hWnd, long aiEvent)             { return AioSetAiEvent(m_Id, static_cast<HWND>(hWnd), aiEvent); }
+    virtual long StartAi()                                        { return AioStartAi(m_Id); }
+    virtual long StopAi()                                         { return AioStopAi(m_Id); }
+    virtual long ResetAiMemory()                                  { return AioResetAiMemory(m_Id); }
+    virtual long GetAiSamplingCount(long* samplingCount)          { return AioGetAiSamplingCount(m_Id, samplingCount); }
+    virtual long GetAiSamplingData(long* samplingTimes, long* data) { return AioGetAiSamplingData(m_Id, samplingTimes, data); }
+    virtual long GetAiStatus(long* aiStatus)                      { return AioGetAiStatus(m_Id, aiStatus); }
+
+    virtual long GetAoResolution(short* resolution)               { return AioGetAoResolution(m_Id, resolution); }
+    virtual long GetAoMaxChannels(short* maxChannels)             { return AioGetAoMaxChannels(m_Id, maxChannels); }
+    virtual long SetAoRangeAll(short range)                       { return AioSetAoRangeAll(m_Id, range); }
+    virtual long GetAoRange(short channel, short* range)          { return AioGetAoRange(m_Id, channel, range); }
+    virtual long MultiAo(short channels, long* data)              { return AioMultiAo(m_Id, channels, data); }
+    virtual long SetAoChannels(short channels)                    { return AioSetAoChannels(m_Id, channels); }
+    virtual long SetAoMemoryType(short memoryType)                { return AioSetAoMemoryType(m_Id, memoryType); }
+    virtual long SetAoSamplingClock(float samplingClock)          { return AioSetAoSamplingClock(m_Id, samplingClock); }
+    virtual long SetAoStopTrigger(short stopTrigger)              { return AioSetAoStopTrigger(m_Id, stopTrigger); }
+    virtual long SetAoSamplingData(long samplingTimes, long* data) { return AioSetAoSamplingData(m_Id, samplingTimes, data); }
+    virtual long GetAoSamplingTimes(long* samplingTimes)          { return AioGetAoSamplingTimes(m_Id, samplingTimes); }
+    virtual long StartAo()                                        { return AioStartAo(m_Id); }
+    virtual long StopAo()                                         { return AioStopAo(m_Id); }
+    virtual long ResetAoMemory()                                  { return AioResetAoMemory(m_Id); }
+    virtual long GetAoStatus(long* aoStatus)                      { return AioGetAoStatus(m_Id, aoStatus); }
+
+private:
+    short m_Id;
+};
+
+} // namespace
+#endif // _WIN32
+
+std::unique_ptr<IAioDevice> CreateAioDevice(const char* spec)
+{
+    const std::string s = (spec != nullptr) ? spec : "";
+
+    if (s.empty() || s == "contec") {
+#ifdef _WIN32
+        return std::unique_ptr<IAioDevice>(new CAioContecDevice());
+#else
+        return nullptr;
+#endif
+    }
+    if (s == "sim")      return std::unique_ptr<IAioDevice>(new CAioSimDevice(1.0));
+    if (s == "sim-fast") return std::unique_ptr<IAioDevice>(new CAioSimDevice(0.0));
+    if (s == "plant")      return std::unique_ptr<IAioDevice>(new CAioPlantDevice(1.0));
+    if (s == "plant-fast") return std::unique_ptr<IAioDevice>(new CAioPlantDevice(0.0));
+
+    const std::string plant = "plant:";
+    if (s.compare(0, plant.size(), plant) == 0) {
+        char* end = nullptr;
+        const double speed = std::strtod(s.c_str() + plant.size(), &end);
+        if (end == s.c_str() + plant.size() || *end != '\0' || !(speed > 0.0)) return nullptr;
+        return std::unique_ptr<IAioDevice>(new CAioPlantDevice(speed));
+    }
+
+    const std::string replay     = "replay:";
+    const std::string replayFast = "replay-fast:";
+    if (s.compare(0, replay.size(), replay) == 0)
+        return std::unique_ptr<IAioDevice>(new CAioReplayDevice(s.substr(replay.size()), 1.0));
+    if (s.compare(0, replayFast.size(), replayFast) == 0)
+        return std::unique_ptr<IAioDevice>(new CAioReplayDevice(s.substr(replayFast.size()), 0.0));
+
+    return nullptr;
+}
+
+const char* GetAioBackendSpec()
+{
+    static std::string spec;
+    if (spec.empty()) {
+#ifdef _MSC_VER
+        char*  buf = nullptr;
+        size_t len = 0;
+        if (_dupenv_s(&buf, &len, "DIGITSHOW_AIO") == 0 && buf != nullptr) {
+            spec = buf;
+            free(buf);
+        }
+#else
+        const char* env = std::getenv("DIGITSHOW_AIO");
+        if (env != nullptr) spec = env;
+#endif
+        if (spec.empty()) spec = "contec";
+    }
+    return spec.c_str();
+}
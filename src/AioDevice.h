@@ -0,0 +1,118 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AIODEVICE_H_INCLUDE__
+#define __AIODEVICE_H_INCLUDE__
+
+#pragma once
+
+#include <memory>
+
+// AioGetAiStatus error bits (AIS_OFERR | AIS_SCERR | AIS_AIERR in CAIO.H)
+#define AIO_AIS_ERRORS  0x00070000L
+// AioGetAoStatus: output running (AOS_BUSY in CAIO.H)
+#define AIO_AOS_BUSY    0x00000001L
+
+/**
+ * Device abstraction over the CONTEC API-AIO calls used by DigitShowBasic.
+ *
+ * Method names follow the Aio* functions they replace (AioGetAiSamplingData
+ * -> GetAiSamplingData, ...) with the board Id held by the device object.
+ * Return values are API-AIO error codes (0 = success) for every backend so
+ * callers keep their existing error handling.
+ *
+ * Backends:
+ *   contec               CONTEC board through caio.lib (Windows only)
+ *   sim                  synthetic 16-ch signal, paced in real time
+ *   sim-fast             synthetic signal, as fast as the consumer reads
+ *   replay:<file>        recorded raw code stream, paced in real time
+ *   replay-fast:<file>   recorded raw code stream, as fast as possible
+ *   plant                rig simulator (PlantModel) driven by the DA outputs, real time
+ *   plant:<speed>        rig simulator, <speed> times real time
+ *   plant-fast           rig simulator, as fast as the consumer reads
+ */
+class IAioDevice
+{
+public:
+    virtual ~IAioDevice() {}
+
+    virtual const char* BackendName() const = 0;
+
+    // ── Device ───────────────────────────────────────────────
+    virtual long Init(const char* deviceName) = 0;
+    virtual long Exit() = 0;
+    virtual long ResetDevice() = 0;
+    virtual long GetErrorString(long errorCode, char* errorString) = 0;
+
+    // ── Analog input ─────────────────────────────────────────
+    virtual long GetAiInputMethod(short* inputMethod) = 0;
+    virtual long GetAiResolution(short* resolution) = 0;
+    virtual long GetAiMaxChannels(short* maxChannels) = 0;
+    virtual long SetAiChannels(short channels) = 0;
+    virtual long SetAiRangeAll(short range) = 0;
+    virtual long GetAiRange(short channel, short* range) = 0;
+    virtual long GetAiMemoryType(short* memoryType) = 0;
+    virtual long SetAiScanClock(float scanClock) = 0;              // µs
+    virtual long GetAiScanClock(float* scanClock) = 0;
+    virtual long SetAiSamplingClock(float samplingClock) = 0;      // µs
+    virtual long GetAiSamplingClock(float* samplingClock) = 0;
+    virtual long SetAiEventSamplingTimes(long samplingTimes) = 0;
+    virtual long GetAiEventSamplingTimes(long* samplingTimes) = 0;
+    virtual long SetAiStopTrigger(short stopTrigger) = 0;
+    virtual long SetAiEvent(void* hWnd, long aiEvent) = 0;         // hWnd = HWND, NULL when headless
+    virtual long StartAi() = 0;
+    virtual long StopAi() = 0;
+    virtual long ResetAiMemory() = 0;
+    virtual long GetAiSamplingCount(long* samplingCount) = 0;
+    virtual long GetAiSamplingData(long* samplingTimes, long* data) = 0;
+    virtual long GetAiStatus(long* aiStatus) = 0;                  // AIS_* bits
+
+    // ── Analog output ────────────────────────────────────────
+    virtual long GetAoResolution(short* resolution) = 0;
+    virtual long GetAoMaxChannels(short* maxChannels) = 0;
+    virtual long SetAoRangeAll(short range) = 0;
+    virtual long GetAoRange(short channel, short* range) = 0;
+    virtual long MultiAo(short channels, long* data) = 0;
+
+    // Buffered output: frames of the first SetAoChannels() channels, one
+    // per sampling clock, from device memory (FIFO, refilled while running)
+    virtual long SetAoChannels(short channels) = 0;
+    virtual long SetAoMemoryType(short memoryType) = 0;            // 0 = FIFO
+    virtual long SetAoSamplingClock(float samplingClock) = 0;      // µs
+    virtual long SetAoStopTrigger(short stopTrigger) = 0;          // 0 = end of data
+    virtual long SetAoSamplingData(long samplingTimes, long* data) = 0;   // append frames
+    virtual long GetAoSamplingTimes(long* samplingTimes) = 0;     // frames not yet output
+    virtual long StartAo() = 0;
+    virtual long StopAo() = 0;
+    virtual long ResetAoMemory() = 0;
+    virtual long GetAoStatus(long* aoStatus) = 0;                  // AOS_* bits
+};
+
+/**
+ * Create a device for the given backend spec (see list above).
+ * NULL or "" selects "contec". Returns nullptr for an unknown spec.
+ */
+std::unique_ptr<IAioDevice> CreateAioDevice(const char* spec);
+
+/**
+ * Backend spec for this process: the DIGITSHOW_AIO environment variable
+ * if set, otherwise "contec".
+ */
+const char* GetAioBackendSpec();
+
+#endif // __AIODEVICE_H_INCLUDE__
@@ -0,0 +1,708 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "AioSimDevice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "caio.h"
+#endif
+
+namespace {
+
+// Error codes of the board-less backends (outside the API-AIO ranges)
+const long kErrNotStarted  = 30001;
+const long kErrFile        = 30002;
+const long kErrBadArgument = 30003;
+const long kErrPlantConfig = 30004;
+const long kErrAoBusy      = 30005;
+
+const double kPi = 3.14159265358979323846;
+
+// 64-bit file positions (replay files may exceed 2 GB)
+int FileSeek(FILE* fp, long long offset, int origin)
+{
+#ifdef _MSC_VER
+    return _fseeki64(fp, offset, origin);
+#else
+    return fseeko(fp, static_cast<off_t>(offset), origin);
+#endif
+}
+
+long long FileTell(FILE* fp)
+{
+#ifdef _MSC_VER
+    return _ftelli64(fp);
+#else
+    return static_cast<long long>(ftello(fp));
+#endif
+}
+
+} // namespace
+
+// ============================================================
+// AoStream
+// ============================================================
+
+uint64_t AoStream::Position(double t) const
+{
+    if (!Running || t < Start) return 0;
+    const double k = std::floor((t - Start) / Clock) + 1.0;
+    return (k >= double(Total())) ? Total() : static_cast<uint64_t>(k);
+}
+
+// ============================================================
+// CAioVirtualDevice
+// ============================================================
+
+CAioVirtualDevice::CAioVirtualDevice(double speed)
+    : m_Channels(kAiChannels)
+    , m_ScanClock(10.0f)
+    , m_SamplingClock(1000.0f)
+    , m_EventTimes(1000)
+    , m_AoData()
+    , m_AoStream(std::make_shared<AoStream>())
+    , m_Speed(speed > 0.0 ? speed : 0.0)
+    , m_Running(false)
+    , m_Failed(false)
+    , m_ScansRead(0)
+    , m_StartScan(0)
+    , m_hWnd(nullptr)
+    , m_EventMask(0)
+    , m_NotifierStop(false)
+    , m_NotifyPending(false)
+    , m_Created(std::chrono::steady_clock::now())
+{
+}
+
+CAioVirtualDevice::~CAioVirtualDevice()
+{
+    StopNotifier();
+}
+
+long CAioVirtualDevice::Init(const char*)
+{
+    return ResetDevice();
+}
+
+long CAioVirtualDevice::Exit()
+{
+    StopNotifier();
+    m_Running = false;
+    return 0;
+}
+
+long CAioVirtualDevice::ResetDevice()
+{
+    StopNotifier();
+    m_Running       = false;
+    m_Failed        = false;
+    m_Channels      = kAiChannels;
+    m_ScanClock     = 10.0f;
+    m_SamplingClock = 1000.0f;
+    m_EventTimes    = 1000;
+    m_ScansRead     = 0;
+    m_StartScan     = 0;
+    m_hWnd          = nullptr;
+    m_EventMask     = 0;
+    std::fill(m_AoData, m_AoData + kAoChannels, 0L);
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    m_AoStream->Running = false;
+    m_AoStream->Data.clear();
+    m_AoStream->Base = 0;
+    m_AoStream->Next = 0;
+    return 0;
+}
+
+long CAioVirtualDevice::GetErrorString(long errorCode, char* errorString)
+{
+    const char* text = "Unknown error";
+    switch (errorCode) {
+    case 0:               text = "Normal completed";                   break;
+    case kErrNotStarted:  text = "Sampling is not running";            break;
+    case kErrFile:        text = "Cannot read the replay file";        break;
+    case kErrBadArgument: text = "Invalid argument";                   break;
+    case kErrPlantConfig: text = "Invalid plant configuration";        break;
+    case kErrAoBusy:      text = "Analog output is running";           break;
+    }
+    std::strcpy(errorString, text);
+    return 0;
+}
+
+// ── Analog input ─────────────────────────────────────────────
+
+long CAioVirtualDevice::GetAiInputMethod(short* inputMethod) { *inputMethod = 0; return 0; }   // single-ended
+long CAioVirtualDevice::GetAiResolution(short* resolution)   { *resolution = 16; return 0; }
+long CAioVirtualDevice::GetAiMaxChannels(short* maxChannels) { *maxChannels = kAiChannels; return 0; }
+long CAioVirtualDevice::GetAiMemoryType(short* memoryType)   { *memoryType = 0; return 0; }    // FIFO
+
+long CAioVirtualDevice::SetAiChannels(short channels)
+{
+    if (channels < 1 || channels > kAiChannels) return kErrBadArgument;
+    m_Channels = channels;
+    return 0;
+}
+
+long CAioVirtualDevice::SetAiRangeAll(short range)
+{
+    return (range == 1) ? 0 : kErrBadArgument;   // only ±5 V is modelled
+}
+
+long CAioVirtualDevice::GetAiRange(short, short* range) { *range = 1; return 0; }
+
+long CAioVirtualDevice::SetAiScanClock(float scanClock)
+{
+    if (scanClock <= 0.0f) return kErrBadArgument;
+    m_ScanClock = scanClock;
+    return 0;
+}
+
+long CAioVirtualDevice::GetAiScanClock(float* scanClock) { *scanClock = m_ScanClock; return 0; }
+
+long CAioVirtualDevice::SetAiSamplingClock(float samplingClock)
+{
+    if (samplingClock <= 0.0f) return kErrBadArgument;
+    m_SamplingClock = samplingClock;
+    return 0;
+}
+
+long CAioVirtualDevice::GetAiSamplingClock(float* samplingClock) { *samplingClock = m_SamplingClock; return 0; }
+
+long CAioVirtualDevice::SetAiEventSamplingTimes(long samplingTimes)
+{
+    if (samplingTimes < 1) return kErrBadArgument;
+    m_EventTimes = samplingTimes;
+    return 0;
+}
+
+long CAioVirtualDevice::GetAiEventSamplingTimes(long* samplingTimes) { *samplingTimes = m_EventTimes; return 0; }
+long CAioVirtualDevice::SetAiStopTrigger(short) { return 0; }
+
+long CAioVirtualDevice::SetAiEvent(void* hWnd, long aiEvent)
+{
+    m_hWnd      = hWnd;
+    m_EventMask = aiEvent;
+    return 0;
+}
+
+long CAioVirtualDevice::StartAi()
+{
+    StopNotifier();
+    m_Failed        = false;
+    m_StartScan     = m_ScansRead;
+    m_StartTime     = std::chrono::steady_clock::now();
+    m_NotifyPending = false;
+    m_Running       = true;
+#ifdef _WIN32
+    if (m_hWnd != nullptr && m_EventMask != 0) {
+        m_NotifierStop = false;
+        m_Notifier = std::thread(&CAioVirtualDevice::NotifyLoop, this);
+    }
+#endif
+    return 0;
+}
+
+long CAioVirtualDevice::StopAi()
+{
+    StopNotifier();
+    m_Running = false;
+    return 0;
+}
+
+long CAioVirtualDevice::ResetAiMemory()
+{
+    // Discard what has been "acquired" but not read yet
+    if (m_Running) m_ScansRead = ScansDue();
+    return 0;
+}
+
+uint64_t CAioVirtualDevice::ScansDue() const
+{
+    const uint64_t read  = m_ScansRead;
+    const uint64_t total = TotalScans();
+    uint64_t due;
+    if (m_Speed <= 0.0) {
+        // Unpaced: one full event burst is always waiting
+        due = read + static_cast<uint64_t>(m_EventTimes);
+    }
+    else {
+        const double elapsed_us = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - m_StartTime).count();
+        due = m_StartScan + static_cast<uint64_t>(elapsed_us * m_Speed / m_SamplingClock);
+    }
+    return std::min(due, total);
+}
+
+long CAioVirtualDevice::GetAiStatus(long* aiStatus)
+{
+    *aiStatus = m_Running ? 0x00000001L : 0;   // AIS_BUSY; the virtual board never overflows
+    return 0;
+}
+
+long CAioVirtualDevice::GetAiSamplingCount(long* samplingCount)
+{
+    *samplingCount = 0;
+    if (!m_Running || m_Failed) return 0;
+    const uint64_t due  = ScansDue();
+    const uint64_t read = m_ScansRead;
+    if (due > read) {
+        const uint64_t n = due - read;
+        *samplingCount = (n > 0x7fffffffULL) ? 0x7fffffffL : static_cast<long>(n);
+    }
+    return 0;
+}
+
+long CAioVirtualDevice::GetAiSamplingData(long* samplingTimes, long* data)
+{
+    if (!m_Running) { *samplingTimes = 0; return kErrNotStarted; }
+
+    long available = 0;
+    GetAiSamplingCount(&available);
+    const long n = std::min(*samplingTimes, available);
+
+    uint64_t scan = m_ScansRead;
+    long done = 0;
+    for (; done < n; ++done, ++scan) {
+        if (!GenerateScan(scan, data + static_cast<size_t>(done) * m_Channels)) {
+            m_Failed = true;
+            break;
+        }
+    }
+    m_ScansRead     = scan;
+    m_NotifyPending = false;
+    *samplingTimes  = done;
+    return (m_Failed && done == 0) ? kErrFile : 0;
+}
+
+// ── Analog output ────────────────────────────────────────────
+
+long CAioVirtualDevice::GetAoResolution(short* resolution)   { *resolution = 16; return 0; }
+long CAioVirtualDevice::GetAoMaxChannels(short* maxChannels) { *maxChannels = kAoChannels; return 0; }
+
+long CAioVirtualDevice::SetAoRangeAll(short range)
+{
+    return (range == 50) ? 0 : kErrBadArgument;   // only 0–10 V is modelled
+}
+
+long CAioVirtualDevice::GetAoRange(short, short* range) { *range = 50; return 0; }
+
+long CAioVirtualDevice::MultiAo(short channels, long* data)
+{
+    if (channels < 1 || channels > kAoChannels) return kErrBadArgument;
+    long status = 0;
+    GetAoStatus(&status);
+    if (status & AIO_AOS_BUSY) return kErrAoBusy;
+    std::copy(data, data + channels, m_AoData);
+    return 0;
+}
+
+// ── Buffered analog output ───────────────────────────────────
+
+long CAioVirtualDevice::SetAoChannels(short channels)
+{
+    if (channels < 1 || channels > kAoChannels) return kErrBadArgument;
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    if (m_AoStream->Running) return kErrAoBusy;
+    m_AoStream->Channels = channels;
+    m_AoStream->Data.clear();
+    m_AoStream->Base = 0;
+    return 0;
+}
+
+long CAioVirtualDevice::SetAoMemoryType(short memoryType)
+{
+    return (memoryType == 0) ? 0 : kErrBadArgument;   // only FIFO is modelled
+}
+
+long CAioVirtualDevice::SetAoSamplingClock(float samplingClock)
+{
+    if (samplingClock <= 0.0f) return kErrBadArgument;
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    if (m_AoStream->Running) return kErrAoBusy;
+    m_AoStream->Clock = samplingClock * 1e-6;
+    return 0;
+}
+
+long CAioVirtualDevice::SetAoStopTrigger(short stopTrigger)
+{
+    return (stopTrigger == 0) ? 0 : kErrBadArgument;  // end of data
+}
+
+long CAioVirtualDevice::SetAoSamplingData(long samplingTimes, long* data)
+{
+    if (samplingTimes < 1) return kErrBadArgument;
+    const double t = AoTime();
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    AoStream& ao = *m_AoStream;
+    // Drop the frames already output, except the one on the outputs now
+    const uint64_t pos = ao.Position(t);
+    if (pos > ao.Base + 1) {
+        const size_t drop = size_t(pos - 1 - ao.Base) * ao.Channels;
+        ao.Data.erase(ao.Data.begin(), ao.Data.begin() + drop);
+        ao.Base = pos - 1;
+    }
+    ao.Data.insert(ao.Data.end(), data, data + size_t(samplingTimes) * ao.Channels);
+    return 0;
+}
+
+long CAioVirtualDevice::GetAoSamplingTimes(long* samplingTimes)
+{
+    const double t = AoTime();
+    UpdateAoOutput(t);
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    const AoStream& ao = *m_AoStream;
+    const uint64_t pos = ao.Running ? ao.Position(t) : ao.Base;
+    *samplingTimes = long(ao.Total() - pos);
+    return 0;
+}
+
+long CAioVirtualDevice::StartAo()
+{
+    const double t = AoTime();
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    AoStream& ao = *m_AoStream;
+    if (ao.Running) return kErrAoBusy;
+    if (ao.Data.empty()) return kErrBadArgument;
+    ao.Base    = 0;
+    ao.Next    = 0;
+    ao.Start   = t;
+    ao.Running = true;
+    return 0;
+}
+
+long CAioVirtualDevice::StopAo()
+{
+    UpdateAoOutput(AoTime());
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    AoStream& ao = *m_AoStream;
+    ao.Running = false;
+    ao.Data.clear();
+    ao.Base = 0;
+    ao.Next = 0;
+    return 0;
+}
+
+long CAioVirtualDevice::ResetAoMemory()
+{
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    if (m_AoStream->Running) return kErrAoBusy;
+    m_AoStream->Data.clear();
+    m_AoStream->Base = 0;
+    return 0;
+}
+
+long CAioVirtualDevice::GetAoStatus(long* aoStatus)
+{
+    const double t = AoTime();
+    UpdateAoOutput(t);
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    const AoStream& ao = *m_AoStream;
+    const bool busy = ao.Running && t - ao.Start < double(ao.Total()) * ao.Clock;
+    *aoStatus = busy ? AIO_AOS_BUSY : 0;
+    return 0;
+}
+
+// ── Helpers ──────────────────────────────────────────────────
+
+double CAioVirtualDevice::AoTime()
+{
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Created).count();
+    return (m_Speed > 0.0) ? s * m_Speed : s;
+}
+
+// m_AoData <- the buffered frame on the outputs at time t
+void CAioVirtualDevice::UpdateAoOutput(double t)
+{
+    std::lock_guard<std::mutex> lock(m_AoStream->Mutex);
+    const AoStream& ao = *m_AoStream;
+    const uint64_t pos = ao.Position(t);
+    if (pos == 0 || pos <= ao.Base) return;
+    const long* frame = ao.Frame(pos - 1);
+    std::copy(frame, frame + ao.Channels, m_AoData);
+}
+
+long CAioVirtualDevice::VoltToCode(double volt)
+{
+    const double code = std::floor((volt + 5.0) * 65535.0 / 10.0 + 0.5);
+    if (code < 0.0)     return 0;
+    if (code > 65535.0) return 65535;
+    return static_cast<long>(code);
+}
+
+void CAioVirtualDevice::StopNotifier()
+{
+    if (!m_Notifier.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_NotifierMutex);
+        m_NotifierStop = true;
+    }
+    m_NotifierWake.notify_all();
+    m_Notifier.join();
+}
+
+// Emulates the driver's window messages. One DATA_NUM at a time is kept
+// outstanding so an unpaced device cannot flood the message queue.
+void CAioVirtualDevice::NotifyLoop()
+{
+#ifdef _WIN32
+    const HWND hWnd = static_cast<HWND>(m_hWnd);
+    double period_us = double(m_EventTimes) * m_SamplingClock;
+    if (m_Speed > 0.0) period_us /= m_Speed;
+    else               period_us  = 1000.0;
+    const auto period = std::chrono::microseconds(
+        static_cast<long long>(std::max(period_us, 1000.0)));
+
+    std::unique_lock<std::mutex> lock(m_NotifierMutex);
+    while (!m_NotifierStop) {
+        m_NotifierWake.wait_for(lock, period);
+        if (m_NotifierStop) break;
+
+        long count = 0;
+        GetAiSamplingCount(&count);
+        if (count >= m_EventTimes && (m_EventMask & AIE_DATA_NUM) && !m_NotifyPending) {
+            m_NotifyPending = true;
+            ::PostMessage(hWnd, AIOM_AIE_DATA_NUM, 0, count);
+        }
+        if (count == 0 && (m_Failed || m_ScansRead >= TotalScans())) {
+            m_Running = false;
+            if (m_EventMask & AIE_END)
+                ::PostMessage(hWnd, AIOM_AIE_END, 0, 0);
+            break;
+        }
+    }
+#endif
+}
+
+// ============================================================
+// CAioSimDevice
+// ============================================================
+
+CAioSimDevice::CAioSimDevice(double speed)
+    : CAioVirtualDevice(speed)
+    , m_Noise(0x2545F491u)
+{
+}
+
+bool CAioSimDevice::GenerateScan(uint64_t n, long* codes)
+{
+    const double t_scan = double(n) * m_SamplingClock * 1e-6;
+    for (int ch = 0; ch < m_Channels; ++ch) {
+        const double t = t_scan + ch * m_ScanClock * 1e-6;
+
+        // Distinct DC level and slow drift per channel
+        double v = -3.5 + 0.45 * ch;
+        v += 0.5 * std::sin(2.0 * kPi * t / (60.0 + 10.0 * ch));
+
+        // Mains pickup (both regions) that MA5×MA6 should remove
+        v += 0.05 * std::sin(2.0 * kPi * 50.0 * t + ch);
+        v += 0.02 * std::sin(2.0 * kPi * 60.0 * t + 0.5 * ch);
+
+        // ±2 mV white noise
+        m_Noise ^= m_Noise << 13;
+        m_Noise ^= m_Noise >> 17;
+        m_Noise ^= m_Noise << 5;
+        v += 0.004 * (double(m_Noise) / 4294967295.0 - 0.5);
+
+        codes[ch] = VoltToCode(v);
+    }
+    return true;
+}
+
+// ============================================================
+// CAioReplayDevice
+// ============================================================
+
+CAioReplayDevice::CAioReplayDevice(const std::string& path, double speed)
+    : CAioVirtualDevice(speed)
+    , m_Path(path)
+    , m_FirstChannel(0)
+    , m_File(nullptr)
+    , m_FileBytes(0)
+    , m_NextScan(0)
+{
+}
+
+CAioReplayDevice::~CAioReplayDevice()
+{
+    Exit();
+}
+
+long CAioReplayDevice::Init(const char* deviceName)
+{
+    const long ret = CAioVirtualDevice::Init(deviceName);
+    if (ret != 0) return ret;
+    if (m_File == nullptr) {
+#ifdef _MSC_VER
+        if (fopen_s(&m_File, m_Path.c_str(), "rb") != 0) m_File = nullptr;
+#else
+        m_File = std::fopen(m_Path.c_str(), "rb");
+#endif
+        if (m_File == nullptr) return kErrFile;
+    }
+    if (RawCaptureReader::IsCapture(m_File)) {
+        m_Capture.reset(new RawCaptureReader);
+        if (!m_Capture->Open(m_Path.c_str(), nullptr)) return kErrFile;
+        m_Scan.resize(static_cast<size_t>(m_Capture->Header().Channels));
+        return 0;
+    }
+    m_FileBytes = 0;
+    if (FileSeek(m_File, 0, SEEK_END) == 0) {
+        const long long bytes = FileTell(m_File);
+        if (bytes > 0) m_FileBytes = static_cast<uint64_t>(bytes);
+    }
+    m_NextScan = UINT64_MAX;   // force a seek on first read
+    return 0;
+}
+
+long CAioReplayDevice::Exit()
+{
+    CAioVirtualDevice::Exit();
+    if (m_File != nullptr) {
+        std::fclose(m_File);
+        m_File = nullptr;
+    }
+    m_Capture.reset();
+    return 0;
+}
+
+uint64_t CAioReplayDevice::TotalScans() const
+{
+    if (m_Capture) return m_Capture->TotalScans();
+    // Channel count may change after Init(), so derive it here
+    return m_FileBytes / (sizeof(int32_t) * static_cast<size_t>(m_Channels));
+}
+
+bool CAioReplayDevice::GenerateScan(uint64_t n, long* codes)
+{
+    if (m_File == nullptr) return false;
+    const size_t nch = static_cast<size_t>(m_Channels);
+    if (m_Capture) {
+        if (!m_Capture->Read(n, m_Scan.data())) return false;
+        for (size_t ch = 0; ch < nch; ++ch) {
+            const size_t col = static_cast<size_t>(m_FirstChannel) + ch;
+            codes[ch] = (col < m_Scan.size()) ? m_Scan[col] : 0;
+        }
+        return true;
+    }
+    if (n != m_NextScan) {
+        const uint64_t offset = n * nch * sizeof(int32_t);
+        if (FileSeek(m_File, static_cast<long long>(offset), SEEK_SET) != 0) return false;
+    }
+    m_Scan.resize(nch);
+    if (std::fread(m_Scan.data(), sizeof(int32_t), nch, m_File) != nch) return false;
+    for (size_t ch = 0; ch < nch; ++ch) codes[ch] = m_Scan[ch];
+    m_NextScan = n + 1;
+    return true;
+}
+
+// ============================================================
+// CAioPlantDevice
+// ============================================================
+
+CAioPlantDevice::CAioPlantDevice(double speed)
+    : CAioVirtualDevice(speed)
+    , m_Plant(std::make_shared<PlantLink>())
+    , m_Owner(true)
+{
+}
+
+CAioPlantDevice::CAioPlantDevice(const std::shared_ptr<PlantLink>& plant, double speed)
+    : CAioVirtualDevice(speed)
+    , m_Plant(plant)
+    , m_Owner(false)
+{
+    m_AoStream = plant->Ao;
+}
+
+long CAioPlantDevice::Init(const char* deviceName)
+{
+    const long ret = CAioVirtualDevice::Init(deviceName);
+    if (ret != 0 || !m_Owner) return ret;
+
+    PlantConfig cfg;
+    SetDefaultPlantConfig(&cfg);
+    m_ConfigError.clear();
+    if (!LoadPlantConfig(GetPlantConfigPath(), &cfg, &m_ConfigError)) return kErrPlantConfig;
+
+    std::lock_guard<std::mutex> lock(m_Plant->Mutex);
+    m_Plant->Model.Configure(cfg);
+    return 0;
+}
+
+long CAioPlantDevice::GetErrorString(long errorCode, char* errorString)
+{
+    if (errorCode == kErrPlantConfig && !m_ConfigError.empty()) {
+        std::strcpy(errorString, m_ConfigError.substr(0, 255).c_str());
+        return 0;
+    }
+    return CAioVirtualDevice::GetErrorString(errorCode, errorString);
+}
+
+long CAioPlantDevice::MultiAo(short channels, long* data)
+{
+    const long ret = CAioVirtualDevice::MultiAo(channels, data);
+    if (ret != 0) return ret;
+
+    double volts[PLANT_AO_CHANNELS];
+    for (int j = 0; j < PLANT_AO_CHANNELS; ++j)
+        volts[j] = m_AoData[j] * 10.0 / 65535.0;    // 0–10 V / 16 bit
+    std::lock_guard<std::mutex> lock(m_Plant->Mutex);
+    m_Plant->Model.SetAo(volts);
+    return 0;
+}
+
+double CAioPlantDevice::AoTime()
+{
+    std::lock_guard<std::mutex> lock(m_Plant->Mutex);
+    return m_Plant->Model.Time();
+}
+
+bool CAioPlantDevice::GenerateScan(uint64_t n, long* codes)
+{
+    const double t = double(n) * m_SamplingClock * 1e-6;
+    double volts[PLANT_AI_CHANNELS];
+    {
+        std::lock_guard<std::mutex> lock(m_Plant->Mutex);
+        PlantModel& model = m_Plant->Model;
+        {
+            // Buffered DA frames due before this scan, each at its own time
+            AoStream& ao = *m_Plant->Ao;
+            std::lock_guard<std::mutex> aoLock(ao.Mutex);
+            while (ao.Running && ao.Next < ao.Total()) {
+                if (ao.Next < ao.Base) ao.Next = ao.Base;
+                const double tk = ao.Start + double(ao.Next) * ao.Clock;
+                if (tk > t) break;
+                model.AdvanceTo(tk);
+                const long* frame = ao.Frame(ao.Next);
+                double ao_v[PLANT_AO_CHANNELS];
+                for (int j = 0; j < ao.Channels; ++j) ao_v[j] = frame[j] * 10.0 / 65535.0;
+                model.SetAo(ao_v, ao.Channels);
+                ao.Next++;
+            }
+        }
+        model.AdvanceTo(t);
+        model.Sensors(volts);
+    }
+    for (int ch = 0; ch < m_Channels; ++ch)
+        codes[ch] = VoltToCode(volts[ch]);
+    return true;
+}
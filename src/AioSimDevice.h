@@ -0,0 +1,265 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AIOSIMDEVICE_H_INCLUDE__
+#define __AIOSIMDEVICE_H_INCLUDE__
+
+#pragma once
+
+#include "AioDevice.h"
+#include "PlantModel.h"
+#include "RawCapture.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Buffered analog output of a board-less DA device: frames appended by
+ * SetAoSamplingData(), frame k output at Start + k × Clock on the
+ * device's output time base. The last frame stays on the outputs.
+ */
+struct AoStream {
+    std::mutex Mutex;
+    short    Channels = 1;
+    double   Clock = 1e-3;          // s/frame
+    bool     Running = false;
+    double   Start = 0.0;           // output time of frame 0 [s]
+    uint64_t Base = 0;              // index of the frame in Data[0]
+    uint64_t Next = 0;              // next frame handed to a model (plant)
+    std::vector<long> Data;         // frames Base.., Channels codes each
+
+    uint64_t Total() const { return Base + Data.size() / Channels; }
+    // Frames started by output time t (at most Total())
+    uint64_t Position(double t) const;
+    const long* Frame(uint64_t k) const { return &Data[size_t(k - Base) * Channels]; }
+};
+
+/**
+ * Common part of the board-less backends.
+ *
+ * Behaves like a 16 ch / 16 bit / ±5 V AD board plus an 8 ch / 16 bit /
+ * 0–10 V DA board. Scans become available according to the programmed
+ * sampling clock multiplied by the speed factor (1.0 = real time).
+ * Speed 0 means unpaced: a full event burst is always available and the
+ * pipeline runs as fast as the consumer reads (meant for headless runs;
+ * in the GUI the scan ring fills faster than the timers drain it).
+ *
+ * When SetAiEvent() was given a window handle, a pacing thread posts
+ * AIOM_AIE_DATA_NUM / AIOM_AIE_END to it like the CONTEC driver (Windows).
+ * Headless callers poll GetAiSamplingCount() instead.
+ */
+class CAioVirtualDevice : public IAioDevice
+{
+public:
+    explicit CAioVirtualDevice(double speed);
+    virtual ~CAioVirtualDevice();
+
+    double Speed() const { return m_Speed; }
+    const long* AoData() const { return m_AoData; }     // last MultiAo() codes
+
+    virtual long Init(const char* deviceName);
+    virtual long Exit();
+    virtual long ResetDevice();
+    virtual long GetErrorString(long errorCode, char* errorString);
+
+    virtual long GetAiInputMethod(short* inputMethod);
+    virtual long GetAiResolution(short* resolution);
+    virtual long GetAiMaxChannels(short* maxChannels);
+    virtual long SetAiChannels(short channels);
+    virtual long SetAiRangeAll(short range);
+    virtual long GetAiRange(short channel, short* range);
+    virtual long GetAiMemoryType(short* memoryType);
+    virtual long SetAiScanClock(float scanClock);
+    virtual long GetAiScanClock(float* scanClock);
+    virtual long SetAiSamplingClock(float samplingClock);
+    virtual long GetAiSamplingClock(float* samplingClock);
+    virtual long SetAiEventSamplingTimes(long samplingTimes);
+    virtual long GetAiEventSamplingTimes(long* samplingTimes);
+    virtual long SetAiStopTrigger(short stopTrigger);
+    virtual long SetAiEvent(void* hWnd, long aiEvent);
+    virtual long StartAi();
+    virtual long StopAi();
+    virtual long ResetAiMemory();
+    virtual long GetAiSamplingCount(long* samplingCount);
+    virtual long GetAiStatus(long* aiStatus);
+    virtual long GetAiSamplingData(long* samplingTimes, long* data);
+
+    virtual long GetAoResolution(short* resolution);
+    virtual long GetAoMaxChannels(short* maxChannels);
+    virtual long SetAoRangeAll(short range);
+    virtual long GetAoRange(short channel, short* range);
+    virtual long MultiAo(short channels, long* data);
+    virtual long SetAoChannels(short channels);
+    virtual long SetAoMemoryType(short memoryType);
+    virtual long SetAoSamplingClock(float samplingClock);
+    virtual long SetAoStopTrigger(short stopTrigger);
+    virtual long SetAoSamplingData(long samplingTimes, long* data);
+    virtual long GetAoSamplingTimes(long* samplingTimes);
+    virtual long StartAo();
+    virtual long StopAo();
+    virtual long ResetAoMemory();
+    virtual long GetAoStatus(long* aoStatus);
+
+protected:
+    // Fill one scan (m_Channels codes) for absolute scan index n.
+    // Return false on a read error; acquisition then ends.
+    virtual bool GenerateScan(uint64_t n, long* codes) = 0;
+
+    // Number of scans the source can deliver (replay file length)
+    virtual uint64_t TotalScans() const { return UINT64_MAX; }
+
+    // AI voltage -> raw code in the ±5 V / 16 bit range (clamped)
+    static long VoltToCode(double volt);
+
+    // Time base of the buffered output [s]: wall clock × speed (real time
+    // when unpaced); the plant uses its model time
+    virtual double AoTime();
+
+    enum { kAiChannels = 16, kAoChannels = 8 };
+
+    short   m_Channels;
+    float   m_ScanClock;        // µs/ch
+    float   m_SamplingClock;    // µs/scan
+    long    m_EventTimes;       // scans per AIOM_AIE_DATA_NUM
+    long    m_AoData[kAoChannels];
+    std::shared_ptr<AoStream> m_AoStream;
+
+private:
+    uint64_t ScansDue() const;
+    void     StopNotifier();
+    void     NotifyLoop();
+    void     UpdateAoOutput(double t);
+
+    const double m_Speed;
+    std::atomic<bool>     m_Running;
+    std::atomic<bool>     m_Failed;       // GenerateScan() error
+    std::atomic<uint64_t> m_ScansRead;    // absolute index of the next scan handed out
+    uint64_t              m_StartScan;    // scan index at StartAi()
+    std::chrono::steady_clock::time_point m_StartTime;
+
+    void*    m_hWnd;
+    long     m_EventMask;
+    std::thread             m_Notifier;
+    std::mutex              m_NotifierMutex;
+    std::condition_variable m_NotifierWake;
+    bool                    m_NotifierStop;
+    std::atomic<bool>       m_NotifyPending;  // DATA_NUM posted, not yet read
+    std::chrono::steady_clock::time_point m_Created;
+};
+
+/**
+ * Synthetic signal: per channel a DC level, a slow sine and 50/60 Hz
+ * mains pickup plus white noise, so the MA5×MA6 notches are exercised.
+ */
+class CAioSimDevice : public CAioVirtualDevice
+{
+public:
+    explicit CAioSimDevice(double speed);
+    virtual const char* BackendName() const { return Speed() > 0.0 ? "sim" : "sim-fast"; }
+
+protected:
+    virtual bool GenerateScan(uint64_t n, long* codes);
+
+private:
+    uint32_t m_Noise;   // xorshift32 state
+};
+
+/**
+ * Replays a recorded raw code stream: little-endian int32 codes,
+ * scan-major [scan][channel] with the configured channel count (the
+ * layout of Data0), or a raw capture file (*.dsraw, RawCapture.h) with
+ * its gaps closed up; missing channels read as code 0. AIOM_AIE_END is
+ * posted at end of file.
+ */
+class CAioReplayDevice : public CAioVirtualDevice
+{
+public:
+    CAioReplayDevice(const std::string& path, double speed);
+    virtual ~CAioReplayDevice();
+    virtual const char* BackendName() const { return Speed() > 0.0 ? "replay" : "replay-fast"; }
+
+    virtual long Init(const char* deviceName);
+    virtual long Exit();
+
+    // First channel of a *.dsraw scan this device replays: a capture of
+    // several boards holds board b at 16·b, so each board replays its own.
+    void SetFirstChannel(int channel) { m_FirstChannel = channel; }
+
+protected:
+    virtual bool GenerateScan(uint64_t n, long* codes);
+    virtual uint64_t TotalScans() const;
+
+private:
+    std::string m_Path;
+    int         m_FirstChannel;
+    FILE*       m_File;
+    uint64_t    m_FileBytes;
+    uint64_t    m_NextScan;     // scan index at the current file position
+    std::vector<int32_t> m_Scan;
+    std::unique_ptr<RawCaptureReader> m_Capture;    // *.dsraw instead of int32 codes
+};
+
+/**
+ * Closed-loop rig simulator: the AD side samples a PlantModel, the DA
+ * side drives it. Plant time is the scan time (scan index × sampling
+ * clock), so at speed N the rig runs N times faster than real time and
+ * the control code sees exactly the time base it would see on a board.
+ *
+ * The AD device owns the model and loads its configuration on Init();
+ * the DA device is created from it with Plant() and shares the model.
+ * Buffered DA output runs on plant time: the AD side applies each frame
+ * at its time while it integrates the model.
+ */
+struct PlantLink {
+    std::mutex Mutex;
+    PlantModel Model;
+    std::shared_ptr<AoStream> Ao = std::make_shared<AoStream>();   // DA side buffered output
+};
+
+class CAioPlantDevice : public CAioVirtualDevice
+{
+public:
+    explicit CAioPlantDevice(double speed);
+    CAioPlantDevice(const std::shared_ptr<PlantLink>& plant, double speed);   // DA side
+    virtual const char* BackendName() const { return Speed() > 0.0 ? "plant" : "plant-fast"; }
+
+    const std::shared_ptr<PlantLink>& Plant() const { return m_Plant; }
+
+    virtual long Init(const char* deviceName);
+    virtual long GetErrorString(long errorCode, char* errorString);
+    virtual long MultiAo(short channels, long* data);
+
+protected:
+    virtual bool GenerateScan(uint64_t n, long* codes);
+    virtual double AoTime();
+
+private:
+    std::shared_ptr<PlantLink> m_Plant;
+    bool        m_Owner;        // AD side: configures and resets the model
+    std::string m_ConfigError;
+};
+
+#endif // __AIOSIMDEVICE_H_INCLUDE__
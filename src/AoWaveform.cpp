@@ -0,0 +1,83 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "AoWaveform.h"
+
+#include <cmath>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// DA channels (DA_CH_* in DigitShowContext.h)
+enum { kChMotor = 0, kChClutch = 1, kChSpeed = 2, kChCell = 3 };
+
+} // namespace
+
+double AoWaveShapeValue(int shape, const std::vector<double>& table, double phase)
+{
+    phase -= std::floor(phase);
+    switch (shape) {
+    case AO_WAVE_SINE:
+        return std::sin(2.0 * kPi * phase);
+    case AO_WAVE_TRIANGLE:
+        if (phase < 0.25) return 4.0 * phase;
+        if (phase < 0.75) return 2.0 - 4.0 * phase;
+        return 4.0 * phase - 4.0;
+    default:
+        if (table.empty()) return 0.0;
+        {
+            // Points equally spaced over the cycle, wrapping to the first
+            const double x = phase * double(table.size());
+            const size_t i = size_t(x);
+            const double f = x - double(i);
+            const double y0 = table[i % table.size()];
+            const double y1 = table[(i + 1) % table.size()];
+            return y0 + (y1 - y0) * f;
+        }
+    }
+}
+
+int AoWaveFramesPerCycle(double period)
+{
+    const double n = std::floor(period / AO_WAVE_CLOCK_MIN);
+    if (n < 50.0)   return 50;
+    if (n > 5000.0) return 5000;
+    return int(n);
+}
+
+void AoWaveCycle(const AoWaveSpec& spec, double amplitude, const float* base,
+                 std::vector<float>* volts)
+{
+    const int frames = AoWaveFramesPerCycle(spec.Period);
+    volts->resize(size_t(frames) * AO_WAVE_CHANNELS);
+    for (int k = 0; k < frames; k++) {
+        float* f = &(*volts)[size_t(k) * AO_WAVE_CHANNELS];
+        for (int j = 0; j < AO_WAVE_CHANNELS; j++) f[j] = base[j];
+
+        const double x = amplitude * AoWaveShapeValue(spec.Shape, spec.Table, double(k) / frames);
+        if (spec.Target == AO_WAVE_MOTOR) {
+            f[kChMotor]  = 5.0f;
+            f[kChClutch] = (x < 0.0) ? 5.0f : 0.0f;
+            f[kChSpeed]  = (x != 0.0) ? float(spec.Gain * std::fabs(x) + spec.Offset) : 0.0f;
+        }
+        else {
+            f[kChCell] = float(spec.Gain * (spec.Center + x) + spec.Offset);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AOWAVEFORM_H_INCLUDE__
+#define __AOWAVEFORM_H_INCLUDE__
+
+#pragma once
+
+#include <vector>
+
+#define AO_WAVE_CHANNELS   4    // DA ch 0-3 are streamed (DA_CH_MOTOR .. DA_CH_EP_CELL)
+#define AO_WAVE_TABLES     8    // user shapes ("wave <n>" in the filter config)
+#define AO_WAVE_CLOCK_MIN  2e-3 // s, shortest frame period
+
+enum AoWaveShape {
+    AO_WAVE_SINE     = 0,
+    AO_WAVE_TRIANGLE = 1,
+    AO_WAVE_USER     = 2,       // user table n: AO_WAVE_USER + n
+};
+
+enum AoWaveTarget {
+    AO_WAVE_MOTOR = 0,          // signed motor speed [rpm], > 0 loads (clutch down)
+    AO_WAVE_CELL  = 1,          // cell pressure [kPa] around Center
+};
+
+/**
+ * Setpoint waveform streamed to the DA board by DaOutputStage.
+ *
+ * A cycle is Period seconds of FramesPerCycle() frames; each frame holds
+ * DA ch 0..AO_WAVE_CHANNELS-1. The driven quantity is
+ *   motor: rpm = A·w(phase) -> ch 0 on, ch 1 clutch from the sign,
+ *          ch 2 = Gain·|rpm| + Offset (0 V at rpm = 0)
+ *   cell:  kPa = Center + A·w(phase) -> ch 3 = Gain·kPa + Offset
+ * with w one of the shapes below, in [-1, 1], w(0) = 0; the other
+ * channels hold their static voltages.
+ */
+struct AoWaveSpec {
+    int    Shape;               // AoWaveShape
+    int    Target;              // AoWaveTarget
+    double Amplitude;           // rpm or kPa
+    double Center;              // kPa (cell)
+    double Period;              // s
+    int    Cycles;
+    double Gain, Offset;        // DA calibration of the driven channel
+    std::vector<double> Table;  // user shape: one cycle, linearly interpolated
+};
+
+// w(phase), phase in [0, 1): sine, triangle (0 -> 1 -> -1 -> 0) or the table
+double AoWaveShapeValue(int shape, const std::vector<double>& table, double phase);
+
+// Frames per cycle: about AO_WAVE_CLOCK_MIN apart, 50 to 5000 per cycle
+int AoWaveFramesPerCycle(double period);
+
+// One cycle at the given amplitude: frames × AO_WAVE_CHANNELS volts in *volts.
+// base: static voltages of ch 0..AO_WAVE_CHANNELS-1
+void AoWaveCycle(const AoWaveSpec& spec, double amplitude, const float* base,
+                 std::vector<float>* volts);
+
+#endif // __AOWAVEFORM_H_INCLUDE__
@@ -0,0 +1,104 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BurstTuner.h"
+
+#include <algorithm>
+#include <cmath>
+
+const double BurstTuner::kMinMargin      = 4.0;
+const double BurstTuner::kResizeRatio    = 0.25;
+const double BurstTuner::kSettleSec      = 5.0;
+const double BurstTuner::kMinIntervalSec = 60.0;
+
+namespace {
+
+const double kSmoothing = 0.05;   // EWMA weight of a new observation
+const double kMaxBurstSec = 1.0;  // never wait longer than this for an event
+
+} // namespace
+
+BurstTuner::BurstTuner()
+    : m_Period(0.0), m_Budget(0.0), m_Auto(false), m_Burst(1), m_MaxBurst(1)
+    , m_Handler(0.0), m_Latency(0.0), m_LatencyMax(0.0), m_AppliedAt(0.0), m_Samples(0)
+{
+}
+
+void BurstTuner::Configure(double scanPeriodSec, double budgetSec, bool autoTune)
+{
+    m_Period   = scanPeriodSec;
+    m_Budget   = budgetSec;
+    m_Auto     = autoTune;
+    m_MaxBurst = (m_Period > 0.0) ? std::max(1L, long(kMaxBurstSec / m_Period)) : 1;
+}
+
+void BurstTuner::Applied(long burst, double hostNow)
+{
+    m_Burst      = std::max(1L, burst);
+    m_AppliedAt  = hostNow;
+    m_LatencyMax = 0.0;
+    m_Samples    = 0;
+}
+
+void BurstTuner::Observe(double handlerSec, double latencySec)
+{
+    if (m_Samples == 0 && m_Handler == 0.0) {
+        m_Handler = handlerSec;
+        m_Latency = latencySec;
+    }
+    else {
+        m_Handler += kSmoothing * (handlerSec - m_Handler);
+        m_Latency += kSmoothing * (latencySec - m_Latency);
+    }
+    m_LatencyMax = std::max(m_LatencyMax, latencySec);
+    m_Samples++;
+}
+
+long BurstTuner::Initial() const
+{
+    if (m_Period <= 0.0) return 1;
+    return std::min(m_MaxBurst, std::max(1L, long(m_Budget / m_Period)));
+}
+
+long BurstTuner::Target() const
+{
+    if (m_Period <= 0.0) return m_Burst;
+    const long fromBudget = long((m_Budget - m_Handler) / m_Period);
+    const long floorN     = long(std::ceil(kMinMargin * m_Handler / m_Period));
+    return std::min(m_MaxBurst, std::max(std::max(1L, fromBudget), floorN));
+}
+
+// allowGap: resizing restarts the board (a gap of a few ms). Without it a
+// resize is only proposed when the margin is short, or kMinIntervalSec
+// after the previous one.
+bool BurstTuner::Propose(double hostNow, bool allowGap, long* burst) const
+{
+    if (!m_Auto || m_Period <= 0.0) return false;
+    if (hostNow - m_AppliedAt < kSettleSec) return false;
+    const long n = Target();
+    if (std::fabs(double(n - m_Burst)) < kResizeRatio * m_Burst) return false;
+    const bool urgent = Margin() < kMinMargin;
+    if (!allowGap && !urgent && hostNow - m_AppliedAt < kMinIntervalSec) return false;
+    *burst = n;
+    return true;
+}
+
+double BurstTuner::Margin() const
+{
+    return (m_Handler > 0.0) ? BurstPeriod() / m_Handler : 0.0;
+}
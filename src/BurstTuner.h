@@ -0,0 +1,82 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BURSTTUNER_H_INCLUDE__
+#define __BURSTTUNER_H_INCLUDE__
+
+#pragma once
+
+/**
+ * Event burst size (AioSetAiEventSamplingTimes) from a latency budget.
+ *
+ * A burst of N scans reaches ai.ring about N × ScanPeriod + handler cost
+ * after its first scan was taken, so the budget gives
+ *     N = (Budget - HandlerCost) / ScanPeriod.
+ * The handler must also keep up with the board: each burst period has to
+ * be at least kMinMargin × the handler cost, otherwise a slow PC backs
+ * the board memory up into an overflow. That floor wins over the budget.
+ *
+ * Observe() is fed from the AD event handler with the measured handler
+ * cost and the delivery latency of the newest scan. Propose() returns a
+ * new burst size once the estimate has settled and differs enough from
+ * the current one; the caller applies it and reports back with Applied().
+ */
+class BurstTuner
+{
+public:
+    BurstTuner();
+
+    void Configure(double scanPeriodSec, double budgetSec, bool autoTune);
+    void Applied(long burst, double hostNow);
+
+    // Per AD event: handler cost and newest-scan latency [s]
+    void Observe(double handlerSec, double latencySec);
+
+    // Size for the budget alone (initial setting, before any measurement)
+    long Initial() const;
+    bool Propose(double hostNow, bool allowGap, long* burst) const;
+
+    long   Burst() const        { return m_Burst; }
+    double BurstPeriod() const  { return m_Burst * m_Period; }
+    double Budget() const       { return m_Budget; }
+    double HandlerCost() const  { return m_Handler; }     // smoothed [s]
+    double Latency() const      { return m_Latency; }     // smoothed [s]
+    double LatencyMax() const   { return m_LatencyMax; }  // since the last resize [s]
+    double Margin() const;                                // burst period / handler cost
+
+    static const double kMinMargin;      // required burst period / handler cost
+    static const double kResizeRatio;    // relative change worth a resize
+    static const double kSettleSec;      // observation time after a resize
+    static const double kMinIntervalSec; // between resizes while logging
+
+private:
+    long   Target() const;
+
+    double m_Period;
+    double m_Budget;
+    bool   m_Auto;
+    long   m_Burst;
+    long   m_MaxBurst;
+    double m_Handler;
+    double m_Latency;
+    double m_LatencyMax;
+    double m_AppliedAt;
+    long   m_Samples;
+};
+
+#endif // __BURSTTUNER_H_INCLUDE__
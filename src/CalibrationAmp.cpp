@@ -78,8 +78,12 @@ void CCalibrationAmp::OnBUTTONAmpUpdate()
     }
     else {
         DigitShowContext* ctx = GetContext();
-        ctx->ai.cal.b[ctx->AmpID] = (m_AmpPO - m_AmpPB) / (m_AmpVO - m_AmpVB);
-        ctx->ai.cal.c[ctx->AmpID] = m_AmpPB - ctx->ai.cal.b[ctx->AmpID] * m_AmpVB;
+        {
+            // Cal_Physical() on the control thread reads ai.cal under the same lock
+            std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+            ctx->ai.cal.b[ctx->AmpID] = (m_AmpPO - m_AmpPB) / (m_AmpVO - m_AmpVB);
+            ctx->ai.cal.c[ctx->AmpID] = m_AmpPB - ctx->ai.cal.b[ctx->AmpID] * m_AmpVB;
+        }
         AfxMessageBox("Get calibration factors!", MB_ICONEXCLAMATION | MB_OK);
     }
 }
@@ -349,6 +349,8 @@ void CCalibrationFactor::OnBUTTONCFUpdate()
 {
     DigitShowContext* ctx = GetContext();
     UpdateData(TRUE);
+    // Cal_Physical() on the control thread reads ai.cal under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->ai.cal.a[0] = m_CFA00;
     ctx->ai.cal.b[0] = m_CFB00;
     ctx->ai.cal.c[0] = m_CFC00;
@@ -404,7 +406,10 @@ void CCalibrationFactor::OnBUTTONZero00()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[0] = ctx->ai.cal.c[0]-ctx->ai.phy[0];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[0] = ctx->ai.cal.c[0]-ctx->ai.phy[0];
+    }
     CF_Load();
 }
 
@@ -412,7 +417,10 @@ void CCalibrationFactor::OnBUTTONZero01()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[1] = ctx->ai.cal.c[1]-ctx->ai.phy[1];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[1] = ctx->ai.cal.c[1]-ctx->ai.phy[1];
+    }
     CF_Load();
 }
 
@@ -420,7 +428,10 @@ void CCalibrationFactor::OnBUTTONZero02()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[2] = ctx->ai.cal.c[2]-ctx->ai.phy[2];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[2] = ctx->ai.cal.c[2]-ctx->ai.phy[2];
+    }
     CF_Load();
 }
 
@@ -428,7 +439,10 @@ void CCalibrationFactor::OnBUTTONZero03()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[3] = ctx->ai.cal.c[3]-ctx->ai.phy[3];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[3] = ctx->ai.cal.c[3]-ctx->ai.phy[3];
+    }
     CF_Load();    
 }
 
@@ -436,7 +450,10 @@ void CCalibrationFactor::OnBUTTONZero04()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[4] = ctx->ai.cal.c[4]-ctx->ai.phy[4];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[4] = ctx->ai.cal.c[4]-ctx->ai.phy[4];
+    }
     CF_Load();    
 }
 
@@ -444,7 +461,10 @@ void CCalibrationFactor::OnBUTTONZero05()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[5] = ctx->ai.cal.c[5]-ctx->ai.phy[5];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[5] = ctx->ai.cal.c[5]-ctx->ai.phy[5];
+    }
     CF_Load();
 }
 
@@ -452,7 +472,10 @@ void CCalibrationFactor::OnBUTTONZero06()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[6] = ctx->ai.cal.c[6]-ctx->ai.phy[6];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[6] = ctx->ai.cal.c[6]-ctx->ai.phy[6];
+    }
     CF_Load();
 }
 
@@ -460,7 +483,10 @@ void CCalibrationFactor::OnBUTTONZero07()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[7] = ctx->ai.cal.c[7]-ctx->ai.phy[7];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[7] = ctx->ai.cal.c[7]-ctx->ai.phy[7];
+    }
     CF_Load();
 }
 
@@ -468,7 +494,10 @@ void CCalibrationFactor::OnBUTTONZero08()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[8] = ctx->ai.cal.c[8]-ctx->ai.phy[8];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[8] = ctx->ai.cal.c[8]-ctx->ai.phy[8];
+    }
     CF_Load();
 }
 
@@ -476,7 +505,10 @@ void CCalibrationFactor::OnBUTTONZero09()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[9] = ctx->ai.cal.c[9]-ctx->ai.phy[9];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[9] = ctx->ai.cal.c[9]-ctx->ai.phy[9];
+    }
     CF_Load();
 }
 
@@ -484,7 +516,10 @@ void CCalibrationFactor::OnBUTTONZero10()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[10] = ctx->ai.cal.c[10]-ctx->ai.phy[10];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[10] = ctx->ai.cal.c[10]-ctx->ai.phy[10];
+    }
     CF_Load();
 }
 
@@ -492,7 +527,10 @@ void CCalibrationFactor::OnBUTTONZero11()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[11] = ctx->ai.cal.c[11]-ctx->ai.phy[11];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[11] = ctx->ai.cal.c[11]-ctx->ai.phy[11];
+    }
     CF_Load();    
 }
 
@@ -500,7 +538,10 @@ void CCalibrationFactor::OnBUTTONZero12()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[12] = ctx->ai.cal.c[12]-ctx->ai.phy[12];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[12] = ctx->ai.cal.c[12]-ctx->ai.phy[12];
+    }
     CF_Load();    
 }
 
@@ -508,7 +549,10 @@ void CCalibrationFactor::OnBUTTONZero13()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[13] = ctx->ai.cal.c[13]-ctx->ai.phy[13];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[13] = ctx->ai.cal.c[13]-ctx->ai.phy[13];
+    }
     CF_Load();    
 }
 
@@ -516,7 +560,10 @@ void CCalibrationFactor::OnBUTTONZero14()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[14] = ctx->ai.cal.c[14]-ctx->ai.phy[14];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[14] = ctx->ai.cal.c[14]-ctx->ai.phy[14];
+    }
     CF_Load();    
 }
 
@@ -524,7 +571,10 @@ void CCalibrationFactor::OnBUTTONZero15()
 {
     DigitShowContext* ctx = GetContext();
     OnBUTTONCFUpdate();
-    ctx->ai.cal.c[15] = ctx->ai.cal.c[15]-ctx->ai.phy[15];
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        ctx->ai.cal.c[15] = ctx->ai.cal.c[15]-ctx->ai.phy[15];
+    }
     CF_Load();
 }
 
@@ -770,8 +820,8 @@ void CCalibrationFactor::OnBUTTONCFSave()
         pFileName = CalSaveFile_dlg.GetPathName();    
         if((err = fopen_s(&FileCalData,(LPCSTR)pFileName , _T("w"))) == 0)
         {
-            fprintf(FileCalData,"%d \n", NUM_PARAM_MAX);
-            for(i = 0;i<NUM_PARAM_MAX;i++){
+            fprintf(FileCalData,"%d \n", ctx->ai.channels);
+            for(i = 0;i<ctx->ai.channels;i++){
                 fprintf(FileCalData,"%d    %lf    %lf    %lf\n",i,ctx->ai.cal.a[i],ctx->ai.cal.b[i],ctx->ai.cal.c[i]);
             }
             fclose(FileCalData);
@@ -795,9 +845,15 @@ void CCalibrationFactor::OnBUTTONCFLoadFile()
         pFileName = CalLoadFile_dlg.GetPathName();    
         if((err = fopen_s(&FileCalData,(LPCSTR)pFileName , _T("r"))) == 0)
         {
-            fscanf_s(FileCalData,_T("%d"),&j);
-            for(i = 0;i<NUM_PARAM_MAX;i++){
-                fscanf_s(FileCalData,_T("%d%lf%lf%lf"),&j,&ctx->ai.cal.a[i],&ctx->ai.cal.b[i],&ctx->ai.cal.c[i]);
+            // First line = number of channels (16 per AD board)
+            int n = NUM_PARAM_MAX;
+            fscanf_s(FileCalData,_T("%d"),&n);
+            if(n < 0 || n > AI_MAX_CHANNELS) n = NUM_PARAM_MAX;
+            {
+                std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+                for(i = 0;i<n;i++){
+                    fscanf_s(FileCalData,_T("%d%lf%lf%lf"),&j,&ctx->ai.cal.a[i],&ctx->ai.cal.b[i],&ctx->ai.cal.c[i]);
+                }
             }
             fclose(FileCalData);
             CF_Load();
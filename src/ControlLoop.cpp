@@ -0,0 +1,185 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ControlLoop.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+namespace {
+
+// Lateness bins [µs]: <50, <100, <200, <500, <1000, <2000, <5000, <10000, <20000, ≥20000
+const double kBinEdgeUs[ControlLoop::kJitterBins - 1] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000
+};
+
+} // namespace
+
+ControlLoop::ControlLoop()
+    : m_Stop(false), m_Timer(nullptr), m_StopEvent(nullptr), m_LateSum(0.0)
+{
+    std::memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+ControlLoop::~ControlLoop()
+{
+    Stop();
+}
+
+void ControlLoop::Start(double period, InitFn threadInit, StepFn step)
+{
+    Stop();
+    {
+        std::lock_guard<std::mutex> lock(m_StatsLock);
+        std::memset(&m_Stats, 0, sizeof(m_Stats));
+        m_Stats.Period = period;
+        m_LateSum = 0.0;
+    }
+    m_Stop = false;
+#ifdef _WIN32
+    m_StopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+#endif
+    m_Thread = std::thread(&ControlLoop::Loop, this, period, threadInit, step);
+}
+
+void ControlLoop::Stop()
+{
+    if (!m_Thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+#ifdef _WIN32
+    SetEvent(static_cast<HANDLE>(m_StopEvent));
+#endif
+    m_Thread.join();
+#ifdef _WIN32
+    CloseHandle(static_cast<HANDLE>(m_StopEvent));
+    m_StopEvent = nullptr;
+#endif
+}
+
+ControlLoop::Stats ControlLoop::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_StatsLock);
+    Stats s = m_Stats;
+    s.LateMean = (s.Ticks > 0) ? m_LateSum / double(s.Ticks) : 0.0;
+    return s;
+}
+
+double ControlLoop::JitterBinEdge(int i)
+{
+    if (i < 0) return 0.0;
+    if (i >= kJitterBins - 1) return HUGE_VAL;
+    return kBinEdgeUs[i] * 1e-6;
+}
+
+double ControlLoop::LatePercentile(const Stats& s, double p)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < kJitterBins; i++) total += s.Hist[i];
+    if (total == 0) return 0.0;
+    const double want = p * double(total);
+    uint64_t acc = 0;
+    for (int i = 0; i < kJitterBins - 1; i++) {
+        acc += s.Hist[i];
+        if (double(acc) >= want) return JitterBinEdge(i);
+    }
+    return s.LateMax;
+}
+
+void ControlLoop::Record(double late, uint64_t missed, double step)
+{
+    std::lock_guard<std::mutex> lock(m_StatsLock);
+    int bin = 0;
+    const double us = late * 1e6;
+    while (bin < kJitterBins - 1 && us >= kBinEdgeUs[bin]) bin++;
+    m_Stats.Hist[bin]++;
+    m_Stats.Ticks++;
+    m_Stats.Missed += missed;
+    m_LateSum += late;
+    m_Stats.LateMax = std::max(m_Stats.LateMax, late);
+    m_Stats.StepMax = std::max(m_Stats.StepMax, step);
+}
+
+bool ControlLoop::WaitUntil(Clock::time_point deadline)
+{
+#ifdef _WIN32
+    const auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now());
+    if (left.count() > 0) {
+        LARGE_INTEGER due;
+        due.QuadPart = -LONGLONG(left.count() / 100);   // relative, 100 ns units
+        HANDLE h[2] = { static_cast<HANDLE>(m_StopEvent), static_cast<HANDLE>(m_Timer) };
+        if (SetWaitableTimer(h[1], &due, 0, NULL, NULL, FALSE))
+            WaitForMultipleObjects(2, h, FALSE, INFINITE);
+    }
+    std::lock_guard<std::mutex> lock(m_WakeMutex);
+    return !m_Stop;
+#else
+    std::unique_lock<std::mutex> lock(m_WakeMutex);
+    m_Wake.wait_until(lock, deadline, [this]() { return m_Stop; });
+    return !m_Stop;
+#endif
+}
+
+void ControlLoop::Loop(double period, InitFn threadInit, StepFn step)
+{
+    if (threadInit) threadInit();
+#ifdef _WIN32
+    bool coarse = false;
+    m_Timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (m_Timer == NULL) {
+        // Before Windows 10 1803: ordinary timer at 1 ms system resolution
+        timeBeginPeriod(1);
+        coarse = true;
+        m_Timer = CreateWaitableTimer(NULL, FALSE, NULL);
+    }
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#endif
+    const auto   tick  = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+    const auto   start = Clock::now();
+    uint64_t     k     = 1;
+    while (WaitUntil(start + tick * k)) {
+        const Clock::time_point woke = Clock::now();
+        const double late = std::chrono::duration<double>(woke - (start + tick * k)).count();
+        // Deadlines already passed are skipped, and their time is handed
+        // to the step as whole periods
+        uint64_t missed = (late >= period) ? uint64_t(late / period) : 0;
+        k += missed;
+        step(period * double(1 + missed));
+        const double run = std::chrono::duration<double>(Clock::now() - woke).count();
+        Record(std::max(late - period * double(missed), 0.0), missed, run);
+        k++;
+    }
+#ifdef _WIN32
+    if (m_Timer) CloseHandle(static_cast<HANDLE>(m_Timer));
+    m_Timer = nullptr;
+    if (coarse) timeEndPeriod(1);
+#endif
+}
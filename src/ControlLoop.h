@@ -0,0 +1,98 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CONTROLLOOP_H_INCLUDE__
+#define __CONTROLLOOP_H_INCLUDE__
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Periodic control thread with absolute deadlines.
+ *
+ * Tick k is due at start + k × period, so the period does not drift with
+ * the time the control law takes. On Windows the thread sleeps on a
+ * high-resolution waitable timer (CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+ * falling back to timeBeginPeriod(1)); elsewhere on a steady-clock wait.
+ *
+ * The step receives a deterministic dt: the nominal period, or a whole
+ * multiple of it when ticks were missed — never the measured wake-up
+ * interval. The lateness of every wake-up is kept in a histogram.
+ */
+class ControlLoop
+{
+public:
+    typedef std::function<void()>         InitFn;
+    typedef std::function<void(double)>   StepFn;   // dt [s]
+
+    enum { kJitterBins = 10 };
+
+    struct Stats {
+        double   Period;                   // s
+        uint64_t Ticks;                    // steps run
+        uint64_t Missed;                   // deadlines skipped (overruns)
+        double   LateMean;                 // s, wake-up after the deadline
+        double   LateMax;                  // s
+        double   StepMax;                  // s, longest step
+        uint64_t Hist[kJitterBins];        // lateness, bins of JitterBinEdge()
+    };
+
+    ControlLoop();
+    ~ControlLoop();
+
+    // threadInit runs first on the new thread (binds the rig context)
+    void Start(double period, InitFn threadInit, StepFn step);
+    void Stop();
+    bool Running() const { return m_Thread.joinable(); }
+
+    Stats GetStats() const;
+
+    // Upper edge of lateness bin i [s] (the last bin is open)
+    static double JitterBinEdge(int i);
+    // Lateness below which a fraction p of the wake-ups fall (bin edge) [s]
+    static double LatePercentile(const Stats& s, double p);
+
+private:
+    ControlLoop(const ControlLoop&) = delete;
+    ControlLoop& operator=(const ControlLoop&) = delete;
+
+    typedef std::chrono::steady_clock Clock;
+
+    void Loop(double period, InitFn threadInit, StepFn step);
+    bool WaitUntil(Clock::time_point deadline);   // false when stopping
+    void Record(double late, uint64_t missed, double step);
+
+    std::thread             m_Thread;
+    std::mutex              m_WakeMutex;
+    std::condition_variable m_Wake;
+    bool                    m_Stop;
+    void*                   m_Timer;      // HANDLE of the waitable timer (Windows)
+    void*                   m_StopEvent;  // HANDLE signalled by Stop() (Windows)
+
+    mutable std::mutex      m_StatsLock;
+    Stats                   m_Stats;
+    double                  m_LateSum;
+};
+
+#endif // __CONTROLLOOP_H_INCLUDE__
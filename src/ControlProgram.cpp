@@ -0,0 +1,427 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ControlProgram.h"
+#include "AoWaveform.h"
+#include "StrainRate.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+// Script step keywords and the names of their parameters (Para index order)
+struct StepDef {
+    const char* Name;
+    int         Num;
+    const char* Para[CONTROL_FILE_PARAS];
+};
+
+const StepDef kStepDefs[CTL_STEP_TYPES] = {
+    { "off",           CTL_STEP_MOTOR_OFF,       { 0 } },
+    { "load_stress",   CTL_STEP_MLOADING_STRESS, { "dir", "rpm", "q" } },
+    { "load_strain",   CTL_STEP_MLOADING_STRAIN, { "dir", "rpm", "ea" } },
+    { "cyclic_stress", CTL_STEP_CLOADING_STRESS, { "dir", "rpm", "q_min", "q_max", "cycles" } },
+    { "cyclic_strain", CTL_STEP_CLOADING_STRAIN, { "dir", "rpm", "ea_min", "ea_max", "cycles" } },
+    { "creep",         CTL_STEP_CREEP,           { "rpm", "q", "minutes" } },
+    { "path",          CTL_STEP_LINEAR_PATH,     { "e_sa0", "e_sr0", "e_sa1", "e_sr1", "rpm", "rate" } },
+    { "creep2",        CTL_STEP_CREEP2,          { "rpm", "q", "minutes" } },
+    { "wave",          CTL_STEP_WAVE,            { "shape", "on", "amp", "period", "cycles", "q_amp" } },
+    { "rate",          CTL_STEP_STRAIN_RATE,     { "dir", "rate", "ea", "rpm", "rpm_max", "window" } },
+};
+
+// Step PID gains, any step type
+const char* const kPidParas[4] = { "kp", "ki", "kd", "kff" };
+
+const char* const kQuantityNames[CTL_QUANTITIES] = {
+    "sa", "e_sa", "sr", "e_sr", "p", "e_p", "q", "u",
+    "ea", "er", "ev", "eLDT", "time", "elapsed", "cycle",
+    "da", "ru", "esec", "damping",
+};
+
+bool StepError(std::string* err, const ControlStepSource& src, int step, const char* what)
+{
+    if (err && err->empty()) {
+        char buf[160];
+        if (src.Line > 0) std::snprintf(buf, sizeof(buf), "line %d: %s", src.Line, what);
+        else              std::snprintf(buf, sizeof(buf), "step %d: %s", step, what);
+        *err = buf;
+    }
+    return false;
+}
+
+bool CompileStep(int i, const ControlStepSource& src, const ControlDaCal& cal,
+                 ControlFileStep* s, std::string* err)
+{
+    const double* P = src.Para;
+    *s = ControlFileStep();
+    s->Type = src.Num;
+    s->Until = src.Until;
+    switch (src.Num) {
+    case CTL_STEP_MOTOR_OFF:
+        return true;
+
+    case CTL_STEP_MLOADING_STRESS:
+    case CTL_STEP_MLOADING_STRAIN:
+    case CTL_STEP_CLOADING_STRESS:
+    case CTL_STEP_CLOADING_STRAIN:
+        if (P[0] != 0.0 && P[0] != 1.0) return StepError(err, src, i, "direction (Para 0) must be 0 or 1");
+        s->Direction = int(P[0]);
+        s->Rpm    = P[1];
+        s->Target = P[2];
+        s->Lower  = P[2];
+        s->Upper  = P[3];
+        if (src.Num == CTL_STEP_CLOADING_STRESS || src.Num == CTL_STEP_CLOADING_STRAIN) {
+            if (P[2] > P[3]) return StepError(err, src, i, "lower bound (Para 2) above upper bound (Para 3)");
+            if (P[4] < 0.0)  return StepError(err, src, i, "negative number of cycles (Para 4)");
+            s->Cycles = int(std::floor(P[4]));
+        }
+        break;
+
+    case CTL_STEP_CREEP:
+    case CTL_STEP_CREEP2:
+        s->Rpm      = P[0];
+        s->Target   = P[1];
+        s->Duration = P[2];
+        if (P[2] < 0.0) return StepError(err, src, i, "negative duration (Para 2)");
+        break;
+
+    case CTL_STEP_LINEAR_PATH:
+        s->Sa0 = P[0];
+        s->Sr0 = P[1];
+        s->Sa1 = P[2];
+        s->Sr1 = P[3];
+        s->Rpm = P[4];
+        s->ConstSr  = (P[1] == P[3]);
+        s->Slope    = s->ConstSr ? 0.0 : (P[2] - P[0]) / (P[3] - P[1]);
+        s->CellRate = std::fabs(P[5]);
+        s->CellVoltsPerSec = float(cal.CellGain * s->CellRate / 60.0);
+        if (!s->ConstSr && s->CellRate == 0.0) return StepError(err, src, i, "zero cell pressure rate (Para 5)");
+        break;
+
+    case CTL_STEP_WAVE:
+        if (P[0] != std::floor(P[0]) || P[0] < 0.0 || P[0] >= AO_WAVE_USER + AO_WAVE_TABLES)
+            return StepError(err, src, i, "unknown waveform shape (Para 0)");
+        if (P[1] != AO_WAVE_MOTOR && P[1] != AO_WAVE_CELL)
+            return StepError(err, src, i, "waveform target (Para 1) must be 0 (motor) or 1 (cell)");
+        if (P[2] < 0.0)  return StepError(err, src, i, "negative amplitude (Para 2)");
+        if (P[3] < 0.1)  return StepError(err, src, i, "waveform period (Para 3) below 0.1 s");
+        if (P[4] < 1.0)  return StepError(err, src, i, "number of cycles (Para 4) below 1");
+        if (P[5] < 0.0)  return StepError(err, src, i, "negative q amplitude (Para 5)");
+        s->WaveShape  = int(P[0]);
+        s->WaveTarget = int(P[1]);
+        s->Amplitude  = P[2];
+        s->Period     = P[3];
+        s->Cycles     = int(std::floor(P[4]));
+        s->QAmp       = (s->WaveTarget == AO_WAVE_MOTOR) ? P[5] : 0.0;
+        break;
+
+    case CTL_STEP_STRAIN_RATE:
+        if (P[0] != 0.0 && P[0] != 1.0) return StepError(err, src, i, "direction (Para 0) must be 0 or 1");
+        if (P[1] <= 0.0) return StepError(err, src, i, "strain rate (Para 1) must be positive");
+        if (P[3] <= 0.0) return StepError(err, src, i, "starting motor speed (Para 3) must be positive");
+        if (P[4] != 0.0 && P[4] < P[3]) return StepError(err, src, i, "highest motor speed (Para 4) below the starting speed");
+        if (P[5] != 0.0 && P[5] < 2.0)  return StepError(err, src, i, "regression window (Para 5) below 2 s");
+        s->Direction  = int(P[0]);
+        s->StrainRate = P[1];
+        s->Target     = P[2];
+        s->Rpm        = P[3];
+        s->RpmMax     = (P[4] > 0.0) ? P[4] : 4.0 * P[3];
+        s->Window     = (P[5] > 0.0) ? P[5] : STRAIN_RATE_WINDOW;
+        break;
+
+    default:
+        return StepError(err, src, i, "unknown step type");
+    }
+    if (s->Rpm < 0.0) return StepError(err, src, i, "negative motor speed");
+    s->SpeedVolts = float(cal.SpeedGain * s->Rpm + cal.SpeedOffset);
+    s->HasPid = (P[6] != 0.0 || P[7] != 0.0 || P[8] != 0.0 || P[9] != 0.0);
+    s->PidScript = (src.Line > 0);
+    s->Kp  = P[6];
+    s->Ki  = P[7];
+    s->Kd  = P[8];
+    s->Kff = P[9];
+    return true;
+}
+
+// "name=value" of a step line
+bool ParseStepParam(const std::string& tok, const StepDef& def, double para[CONTROL_FILE_PARAS])
+{
+    const size_t eq = tok.find('=');
+    if (eq == std::string::npos) return false;
+    const std::string key = tok.substr(0, eq);
+    char* end = nullptr;
+    const double v = std::strtod(tok.c_str() + eq + 1, &end);
+    if (end == tok.c_str() + eq + 1 || *end != '\0') return false;
+    for (int k = 0; k < 6; k++) {
+        if (def.Para[k] && key == def.Para[k]) { para[k] = v; return true; }
+    }
+    for (int k = 0; k < 4; k++) {
+        if (key == kPidParas[k]) { para[6 + k] = v; return true; }
+    }
+    return false;
+}
+
+// "ev>=1.5", "time>600", ...
+bool ParseCondition(const std::string& tok, ControlCondition* c)
+{
+    const size_t op = tok.find_first_of("<>");
+    if (op == std::string::npos || op == 0) return false;
+    const bool eq = (op + 1 < tok.size() && tok[op + 1] == '=');
+    c->Op = (tok[op] == '<') ? (eq ? -1 : -2) : (eq ? 1 : 2);
+    const std::string name = tok.substr(0, op);
+    c->Quantity = -1;
+    for (int q = 0; q < CTL_QUANTITIES; q++) {
+        if (name == kQuantityNames[q]) c->Quantity = q;
+    }
+    const char* num = tok.c_str() + op + (eq ? 2 : 1);
+    char* end = nullptr;
+    c->Value = std::strtod(num, &end);
+    return c->Quantity >= 0 && end != num && *end == '\0';
+}
+
+} // namespace
+
+int ControlFileSteps(const ControlFileData& file)
+{
+    return file.Script.empty() ? CONTROL_FILE_STEPS : int(file.Script.size());
+}
+
+void GetControlFileStep(const ControlFileData& file, int i, int* num, double para[CONTROL_FILE_PARAS])
+{
+    *num = 0;
+    for (int j = 0; j < CONTROL_FILE_PARAS; j++) para[j] = 0.0;
+    if (i < 0 || i >= ControlFileSteps(file)) return;
+    const int*    n = file.Script.empty() ? &file.Num[i] : &file.Script[i].Num;
+    const double* p = file.Script.empty() ? file.Para[i] : file.Script[i].Para;
+    *num = *n;
+    for (int j = 0; j < CONTROL_FILE_PARAS; j++) para[j] = p[j];
+}
+
+void SetControlFileStep(ControlFileData* file, int i, int num, const double para[CONTROL_FILE_PARAS])
+{
+    if (i < 0 || i >= ControlFileSteps(*file)) return;
+    int*    n = file->Script.empty() ? &file->Num[i] : &file->Script[i].Num;
+    double* p = file->Script.empty() ? file->Para[i] : file->Script[i].Para;
+    *n = num;
+    for (int j = 0; j < CONTROL_FILE_PARAS; j++) p[j] = para[j];
+    file->Revision++;
+}
+
+bool CompileControlProgram(const ControlFileData& file, const ControlDaCal& cal,
+                           ControlProgram* prog, std::string* err)
+{
+    bool ok = true;
+    const int steps = ControlFileSteps(file);
+    if (err) err->clear();
+    prog->Steps.resize(steps);
+    for (int i = 0; i < steps; i++) {
+        ControlStepSource table;
+        const ControlStepSource* src = &table;
+        if (file.Script.empty()) {
+            table.Num  = file.Num[i];
+            table.Line = 0;
+            for (int j = 0; j < CONTROL_FILE_PARAS; j++) table.Para[j] = file.Para[i][j];
+        }
+        else {
+            src = &file.Script[i];
+        }
+        if (!CompileStep(i, *src, cal, &prog->Steps[i], err)) {
+            prog->Steps[i] = ControlFileStep();
+            prog->Steps[i].Type = CTL_STEP_MOTOR_OFF;
+            ok = false;
+        }
+    }
+    prog->Revision = file.Revision;
+    return ok;
+}
+
+/*
+ * Control script (*.dsc): one step per line, '#' starts a comment.
+ *
+ *   <type> name=value ... [until <cond> ...]
+ *   repeat N {              the steps up to the matching "}" N times
+ *   }                       (blocks nest)
+ *
+ * Types and parameter names (unnamed parameters are 0):
+ *   off
+ *   load_stress   dir rpm q                  dir 0: load to q, 1: unload to q
+ *   load_strain   dir rpm ea
+ *   cyclic_stress dir rpm q_min q_max cycles dir 0: unload first, 1: load first
+ *   cyclic_strain dir rpm ea_min ea_max cycles
+ *   creep         rpm q minutes
+ *   creep2        rpm q minutes
+ *   path          e_sa0 e_sr0 e_sa1 e_sr1 rpm rate
+ *   wave          shape on amp period cycles q_amp
+ *                   shape 0 sine, 1 triangle, 2+n user shape n ("wave n" in
+ *                   the filter config); on 0: motor speed ±amp [rpm], 1: cell
+ *                   pressure ±amp [kPa] around its present value; period [s];
+ *                   q_amp > 0 (motor): amplitude corrected each cycle toward
+ *                   this q single amplitude [kPa]
+ *   rate          dir rate ea rpm rpm_max window
+ *                   load (dir 0) or unload (1) to ea at rate [%/min]: the
+ *                   motor starts at rpm and is corrected from the slope of
+ *                   ea over the last window seconds (default 30) of the
+ *                   filtered displacement, up to rpm_max (default 4 × rpm)
+ * and on any step kp ki kd kff (step PID gains, see DigitShowBasicDoc::SetupPid).
+ *
+ * "until" conditions end the step early when any one of them holds:
+ * <quantity><op><value>, op one of < <= >= >, quantity one of
+ * sa e_sa sr e_sr p e_p q u ea er ev eLDT, time (minutes in the step),
+ * elapsed (seconds since logging started), cycle, or from the hysteresis
+ * analysis of cyclic steps (CycleAnalyzer.h): da (double amplitude axial
+ * strain [%]), ru (excess pore pressure ratio), esec (secant modulus [MPa])
+ * and damping of the last cycle.
+ *
+ * Example: 20 cycles of load / unload / creep, each ended early by ev
+ *   repeat 20 {
+ *     load_stress   dir=0 rpm=300 q=150
+ *     load_stress   dir=1 rpm=300 q=20
+ *     creep         rpm=100 q=20 minutes=10 until ev>=2.5
+ *   }
+ * Liquefaction: load until DA = 5 % or ru = 0.95
+ *   cyclic_stress dir=1 rpm=500 q_min=-30 q_max=30 cycles=200 until da>=5 ru>=0.95
+ *
+ * A motor-off step is appended unless the script ends with one.
+ */
+bool LoadControlScript(const char* path, std::vector<ControlStepSource>* steps, std::string* err)
+{
+    FILE* fp = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&fp, path, "r") != 0) fp = nullptr;
+#else
+    fp = std::fopen(path, "r");
+#endif
+    if (fp == nullptr) {
+        *err = std::string(path) + ": cannot open";
+        return false;
+    }
+
+    struct Block { size_t First; long Count; };
+    std::vector<ControlStepSource> out;
+    std::vector<Block> blocks;
+    char line[1024];
+    int  lineNo = 0;
+    const char* what = nullptr;
+    while (what == nullptr && std::fgets(line, sizeof(line), fp) != nullptr) {
+        lineNo++;
+        if (char* hash = std::strchr(line, '#')) *hash = '\0';
+        std::istringstream in(line);
+        std::string cmd, tok;
+        if (!(in >> cmd)) continue;
+
+        if (cmd == "repeat") {
+            Block b = { out.size(), 0 };
+            if (!(in >> b.Count >> tok) || b.Count < 0 || tok != "{" || (in >> tok)) what = "expected: repeat N {";
+            else blocks.push_back(b);
+            continue;
+        }
+        if (cmd == "}") {
+            if (blocks.empty() || (in >> tok)) { what = "unmatched }"; continue; }
+            const Block b = blocks.back();
+            blocks.pop_back();
+            const size_t len = out.size() - b.First;
+            if (b.Count == 0) { out.resize(b.First); continue; }
+            if (double(len) * double(b.Count) + double(b.First) > CONTROL_SCRIPT_MAX_STEPS) { what = "too many steps"; continue; }
+            for (long k = 1; k < b.Count; k++) {
+                for (size_t j = 0; j < len; j++) out.push_back(out[b.First + j]);
+            }
+            continue;
+        }
+
+        const StepDef* def = nullptr;
+        for (int t = 0; t < CTL_STEP_TYPES; t++) {
+            if (cmd == kStepDefs[t].Name) def = &kStepDefs[t];
+        }
+        if (def == nullptr) { what = "unknown step type"; continue; }
+
+        ControlStepSource src;
+        src.Num  = def->Num;
+        src.Line = lineNo;
+        for (int j = 0; j < CONTROL_FILE_PARAS; j++) src.Para[j] = 0.0;
+        bool until = false;
+        while (what == nullptr && (in >> tok)) {
+            if (tok == "until") { until = true; continue; }
+            if (until) {
+                ControlCondition c;
+                if (ParseCondition(tok, &c)) src.Until.push_back(c);
+                else what = "invalid until condition";
+            }
+            else if (!ParseStepParam(tok, *def, src.Para)) {
+                what = "invalid parameter";
+            }
+        }
+        if (until && src.Until.empty() && what == nullptr) what = "until without a condition";
+        if (out.size() >= CONTROL_SCRIPT_MAX_STEPS) what = "too many steps";
+        if (what == nullptr) out.push_back(src);
+    }
+    std::fclose(fp);
+    if (what == nullptr && !blocks.empty()) what = "missing }";
+
+    if (what != nullptr) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%s(%d): ", path, lineNo);
+        *err = std::string(buf) + what;
+        return false;
+    }
+    if (out.empty() || out.back().Num != CTL_STEP_MOTOR_OFF) {
+        ControlStepSource off;
+        off.Num  = CTL_STEP_MOTOR_OFF;
+        off.Line = lineNo + 1;
+        for (int j = 0; j < CONTROL_FILE_PARAS; j++) off.Para[j] = 0.0;
+        out.push_back(off);
+    }
+    steps->swap(out);
+    return true;
+}
+
+// Writes the expanded steps (repeat blocks are not reconstructed)
+bool SaveControlScript(const char* path, const std::vector<ControlStepSource>& steps)
+{
+    FILE* fp = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&fp, path, "w") != 0) fp = nullptr;
+#else
+    fp = std::fopen(path, "w");
+#endif
+    if (fp == nullptr) return false;
+
+    for (size_t i = 0; i < steps.size(); i++) {
+        const ControlStepSource& s = steps[i];
+        if (s.Num < 0 || s.Num >= CTL_STEP_TYPES) continue;
+        const StepDef& def = kStepDefs[s.Num];
+        std::fprintf(fp, "%s", def.Name);
+        for (int k = 0; k < 6; k++) {
+            if (def.Para[k]) std::fprintf(fp, " %s=%.10g", def.Para[k], s.Para[k]);
+        }
+        for (int k = 0; k < 4; k++) {
+            if (s.Para[6 + k] != 0.0) std::fprintf(fp, " %s=%.10g", kPidParas[k], s.Para[6 + k]);
+        }
+        if (!s.Until.empty()) std::fprintf(fp, " until");
+        for (size_t c = 0; c < s.Until.size(); c++) {
+            const ControlCondition& u = s.Until[c];
+            const char* op = (u.Op == -2) ? "<" : (u.Op == -1) ? "<=" : (u.Op == 1) ? ">=" : ">";
+            std::fprintf(fp, " %s%s%.10g", kQuantityNames[u.Quantity], op, u.Value);
+        }
+        std::fprintf(fp, "\n");
+    }
+    return std::fclose(fp) == 0;
+}
@@ -0,0 +1,183 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CONTROLPROGRAM_H_INCLUDE__
+#define __CONTROLPROGRAM_H_INCLUDE__
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#define CONTROL_FILE_STEPS 128      // steps in a control file (*.ctl)
+#define CONTROL_FILE_PARAS  10      // parameters per step
+#define CONTROL_SCRIPT_MAX_STEPS 1000000   // after expanding repeat blocks
+
+/**
+ * Quantities a step can end on ("until" in a control script)
+ */
+enum ControlQuantity {
+    CTL_Q_SA, CTL_Q_E_SA, CTL_Q_SR, CTL_Q_E_SR, CTL_Q_P, CTL_Q_E_P, CTL_Q_Q, CTL_Q_U,
+    CTL_Q_EA, CTL_Q_ER, CTL_Q_EV, CTL_Q_ELDT,
+    CTL_Q_TIME,         // minutes in the step (TotalStepTime)
+    CTL_Q_ELAPSED,      // seconds since logging started (SequentTime2)
+    CTL_Q_CYCLE,        // cycle of a cyclic step (NumCyclic)
+    CTL_Q_DA,           // double amplitude axial strain [%] (CycleAnalyzer)
+    CTL_Q_RU,           // excess pore pressure ratio
+    CTL_Q_ESEC,         // secant modulus of the last cycle [MPa]
+    CTL_Q_DAMPING,      // damping ratio of the last cycle
+    CTL_QUANTITIES
+};
+
+struct ControlCondition {
+    int    Quantity;    // ControlQuantity
+    int    Op;          // -2 <, -1 <=, 1 >=, 2 >
+    double Value;
+
+    bool Met(double x) const
+    {
+        return (Op == -2) ? x <  Value : (Op == -1) ? x <= Value
+             : (Op ==  1) ? x >= Value : x > Value;
+    }
+};
+
+/**
+ * One step as written: a *.ctl line or a control-script step
+ */
+struct ControlStepSource {
+    int    Num;                             // ControlStepType
+    double Para[CONTROL_FILE_PARAS];
+    std::vector<ControlCondition> Until;    // any one met ends the step
+    int    Line;                            // script line, 0 = *.ctl step
+};
+
+/**
+ * Control file data (control mode 15). Either the fixed *.ctl table, one
+ * line per step "Num Para[0] ... Para[9]", or a control script (*.dsc)
+ * of any length, which then replaces the table.
+ */
+struct ControlFileData {
+    int    CurrentNum;
+    int    Num[CONTROL_FILE_STEPS];
+    double Para[CONTROL_FILE_STEPS][CONTROL_FILE_PARAS];
+    std::vector<ControlStepSource> Script;  // control script steps, empty = use Num / Para
+    int    Revision;                        // bumped whenever the steps change
+};
+
+// Steps of the file (table or script), and access to step i as numbers
+int  ControlFileSteps(const ControlFileData& file);
+void GetControlFileStep(const ControlFileData& file, int i, int* num, double para[CONTROL_FILE_PARAS]);
+void SetControlFileStep(ControlFileData* file, int i, int num, const double para[CONTROL_FILE_PARAS]);
+
+// Read a control script (see ControlProgram.cpp for the syntax) line by
+// line, expanding repeat blocks. On a syntax error returns false and names
+// the offending line in *err.
+bool LoadControlScript(const char* path, std::vector<ControlStepSource>* steps, std::string* err);
+bool SaveControlScript(const char* path, const std::vector<ControlStepSource>& steps);
+
+/**
+ * Step types (ControlFileData::Num)
+ */
+enum ControlStepType {
+    CTL_STEP_MOTOR_OFF       = 0,
+    CTL_STEP_MLOADING_STRESS = 1,   // monotonic loading to q
+    CTL_STEP_MLOADING_STRAIN = 2,   // monotonic loading to ea
+    CTL_STEP_CLOADING_STRESS = 3,   // cyclic loading between q bounds
+    CTL_STEP_CLOADING_STRAIN = 4,   // cyclic loading between ea bounds
+    CTL_STEP_CREEP           = 5,   // hold q for a time
+    CTL_STEP_LINEAR_PATH     = 6,   // linear effective stress path
+    CTL_STEP_CREEP2          = 7,   // hold q (loading side only) for a time
+    CTL_STEP_WAVE            = 8,   // board-buffered motor speed / cell pressure waveform
+    CTL_STEP_STRAIN_RATE     = 9,   // monotonic loading to ea at a constant strain rate
+    CTL_STEP_TYPES
+};
+
+/**
+ * One control-file step, validated and with its constants precomputed.
+ * Only the fields of its Type are meaningful.
+ */
+struct ControlFileStep {
+    int    Type;            // ControlStepType; invalid steps become CTL_STEP_MOTOR_OFF
+
+    // Motor
+    double Rpm;             // motor speed [rpm]
+    float  SpeedVolts;      // Rpm on DA_CH_MOTOR_SPEED [V]
+
+    // Loading (1-4): Para[0] direction, [2]/[3] bounds, [4] cycles
+    int    Direction;       // 1, 2, 9: 0 = load to Target, 1 = unload to it;
+                            // 3, 4: 0 = unload first, 1 = load first
+    double Target;          // 1, 2, 9: end value; 5, 7: creep q [kPa]
+    double Lower;           // 3, 4: lower bound of a cycle
+    double Upper;           // 3, 4: upper bound of a cycle
+    int    Cycles;          // 3, 4, 8
+    double Duration;        // 5, 7: [min]
+
+    // Waveform (8): Para[0] shape, [1] target, [2] amplitude, [3] period,
+    // [4] cycles, [5] q single amplitude the motor amplitude is corrected to
+    int    WaveShape;       // AoWaveShape
+    int    WaveTarget;      // AoWaveTarget
+    double Amplitude;       // rpm or kPa
+    double Period;          // s
+    double QAmp;            // kPa, 0 = no correction
+
+    // Strain rate (9): Para[0] direction, [1] rate, [2] ea, [3] starting rpm,
+    // [4] highest rpm, [5] regression window
+    double StrainRate;      // %/min
+    double RpmMax;          // rpm
+    double Window;          // s
+
+    // Linear effective stress path (6): (e_sr, e_sa) from (Sr0, Sa0) to (Sr1, Sa1)
+    double Sa0, Sr0, Sa1, Sr1;
+    bool   ConstSr;         // Sr0 == Sr1: e_sa moves at constant e_sr
+    double Slope;           // dSa/dSr of the path (ConstSr: 0)
+    double CellRate;        // |Para[5]| [kPa/min]
+    float  CellVoltsPerSec; // CellRate on DA_CH_EP_CELL [V/s]
+
+    // Step PID gains, Para[6..9] (5, 7: motor, 6: cell). Written as kp= ..
+    // on a script line they enable the step PID; *.ctl columns 6-9 (free
+    // in older files) only count with "pid motor|cell 15" in the filter config.
+    bool   HasPid;
+    bool   PidScript;       // gains from a script line
+    double Kp, Ki, Kd, Kff;
+
+    std::vector<ControlCondition> Until;    // any one met ends the step
+
+    // e_sa on the path at e_sr (6)
+    double PathSa(double e_sr) const { return ConstSr ? Sa1 : Slope * (e_sr - Sr0) + Sa0; }
+};
+
+/**
+ * Control file compiled for the control thread: Steps[i] is file step i.
+ */
+struct ControlProgram {
+    int Revision;                   // ControlFileData::Revision compiled, -1 = none
+    std::vector<ControlFileStep> Steps;
+};
+
+// DA calibration used for the precomputed voltages
+struct ControlDaCal {
+    double SpeedGain, SpeedOffset;  // DA_CH_MOTOR_SPEED
+    double CellGain;                // DA_CH_EP_CELL
+};
+
+// Compile every step of *file (its script if any). Invalid steps are replaced by CTL_STEP_MOTOR_OFF;
+// returns false if there were any and names the first one in *err.
+bool CompileControlProgram(const ControlFileData& file, const ControlDaCal& cal,
+                           ControlProgram* prog, std::string* err);
+
+#endif // __CONTROLPROGRAM_H_INCLUDE__
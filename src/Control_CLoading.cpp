@@ -62,6 +62,8 @@ void CControl_CLoading::OnBUTTONUpdate()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control thread of this rig reads control[] under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->control[5].flag[0] = (m_flag0 != 0);
     ctx->control[5].MotorSpeed = m_MotorSpeed;
     ctx->control[5].sigma[0] = m_q_lower;
@@ -75,6 +77,7 @@ void CControl_CLoading::OnBUTTONUpdate()
 void CControl_CLoading::OnBUTTONReflesh()
 {
     DigitShowContext* ctx = GetContext();
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     if (ctx->ControlID == 6) {
         ctx->control[5] = ctx->control[6];
     }
@@ -55,6 +55,8 @@ void CControl_Consolidation::OnBUTTONUpdate()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control thread of this rig reads control[] under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->control[2].e_sigma[0] = m_MotorESa;
     ctx->control[2].K0 = m_MotorK0;
     ctx->control[2].sigmaRate[2] = m_MotorSrRate;
@@ -21,31 +21,55 @@
 #include "Control_File.h"
 #include "DigitShowContext.h"
 
+#include <cstring>
+
 #ifdef _DEBUG
 #define new DEBUG_NEW
 #undef THIS_FILE
 static char THIS_FILE[] = __FILE__;
 #endif
 
+// Validate the control file after a change; the control thread recompiles
+// it (ControlProgram) at its next step. The control thread reads and
+// advances controlFile under the rig lock, so every handler here that
+// writes it takes runner.Mutex(); the check compiles a copy, outside it.
+static void CheckControlFile(DigitShowContext* ctx)
+{
+    ControlFileData file;
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        file = ctx->controlFile;
+    }
+    ControlDaCal cal = { 1.0, 0.0, 1.0 };
+    ControlProgram prog;
+    std::string err;
+    if (!CompileControlProgram(file, cal, &prog, &err)) {
+        CString msg;
+        msg.Format("Control file: %s\nInvalid steps stop the motor.", err.c_str());
+        AfxMessageBox(msg, MB_ICONWARNING | MB_OK);
+    }
+}
+
 CControl_File::CControl_File(CWnd* pParent)
     : CDialog(CControl_File::IDD, pParent)
 {
     DigitShowContext* ctx = GetContext();
     int curNum = ctx->controlFile.CurrentNum;
+    double para[CONTROL_FILE_PARAS];
+    GetControlFileStep(ctx->controlFile, curNum, &m_SCFNum, para);
     m_CurNum = curNum;
-    m_CFNum = ctx->controlFile.Num[curNum];
+    m_CFNum = m_SCFNum;
     m_StepNum = curNum;
-    m_SCFNum = ctx->controlFile.Num[curNum];
-    m_CFPARA0 = ctx->controlFile.Para[curNum][0];
-    m_CFPARA1 = ctx->controlFile.Para[curNum][1];
-    m_CFPARA2 = ctx->controlFile.Para[curNum][2];
-    m_CFPARA3 = ctx->controlFile.Para[curNum][3];
-    m_CFPARA4 = ctx->controlFile.Para[curNum][4];
-    m_CFPARA5 = ctx->controlFile.Para[curNum][5];
-    m_CFPARA6 = ctx->controlFile.Para[curNum][6];
-    m_CFPARA7 = ctx->controlFile.Para[curNum][7];
-    m_CFPARA8 = ctx->controlFile.Para[curNum][8];
-    m_CFPARA9 = ctx->controlFile.Para[curNum][9];
+    m_CFPARA0 = para[0];
+    m_CFPARA1 = para[1];
+    m_CFPARA2 = para[2];
+    m_CFPARA3 = para[3];
+    m_CFPARA4 = para[4];
+    m_CFPARA5 = para[5];
+    m_CFPARA6 = para[6];
+    m_CFPARA7 = para[7];
+    m_CFPARA8 = para[8];
+    m_CFPARA9 = para[9];
 }
 
 void CControl_File::DoDataExchange(CDataExchange* pDX)
@@ -62,7 +86,7 @@ void CControl_File::DoDataExchange(CDataExchange* pDX)
     DDX_Text(pDX, IDC_EDIT_CFPARA8, m_CFPARA8);
     DDX_Text(pDX, IDC_EDIT_CFPARA9, m_CFPARA9);
     DDX_Text(pDX, IDC_EDIT_StepNum, m_StepNum);
-    DDV_MinMaxInt(pDX, m_StepNum, 0, 127);
+    DDV_MinMaxInt(pDX, m_StepNum, 0, ControlFileSteps(GetContext()->controlFile)-1);
     DDX_Text(pDX, IDC_EDIT_SCFNum, m_SCFNum);
     DDX_Text(pDX, IDC_EDIT_CurNum, m_CurNum);
     DDX_Text(pDX, IDC_EDIT_CFNum, m_CFNum);
@@ -95,17 +119,18 @@ void CControl_File::OnBUTTONLoad()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
-    m_SCFNum = ctx->controlFile.Num[m_StepNum];
-    m_CFPARA0 = ctx->controlFile.Para[m_StepNum][0];
-    m_CFPARA1 = ctx->controlFile.Para[m_StepNum][1];
-    m_CFPARA2 = ctx->controlFile.Para[m_StepNum][2];
-    m_CFPARA3 = ctx->controlFile.Para[m_StepNum][3];
-    m_CFPARA4 = ctx->controlFile.Para[m_StepNum][4];
-    m_CFPARA5 = ctx->controlFile.Para[m_StepNum][5];
-    m_CFPARA6 = ctx->controlFile.Para[m_StepNum][6];
-    m_CFPARA7 = ctx->controlFile.Para[m_StepNum][7];
-    m_CFPARA8 = ctx->controlFile.Para[m_StepNum][8];
-    m_CFPARA9 = ctx->controlFile.Para[m_StepNum][9];
+    double para[CONTROL_FILE_PARAS];
+    GetControlFileStep(ctx->controlFile, m_StepNum, &m_SCFNum, para);
+    m_CFPARA0 = para[0];
+    m_CFPARA1 = para[1];
+    m_CFPARA2 = para[2];
+    m_CFPARA3 = para[3];
+    m_CFPARA4 = para[4];
+    m_CFPARA5 = para[5];
+    m_CFPARA6 = para[6];
+    m_CFPARA7 = para[7];
+    m_CFPARA8 = para[8];
+    m_CFPARA9 = para[9];
     UpdateData(FALSE);
 }
 
@@ -113,44 +138,79 @@ void CControl_File::OnBUTTONUpdate()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
-    ctx->controlFile.Num[m_StepNum] = m_SCFNum;
-    ctx->controlFile.Para[m_StepNum][0] = m_CFPARA0;
-    ctx->controlFile.Para[m_StepNum][1] = m_CFPARA1;
-    ctx->controlFile.Para[m_StepNum][2] = m_CFPARA2;
-    ctx->controlFile.Para[m_StepNum][3] = m_CFPARA3;
-    ctx->controlFile.Para[m_StepNum][4] = m_CFPARA4;
-    ctx->controlFile.Para[m_StepNum][5] = m_CFPARA5;
-    ctx->controlFile.Para[m_StepNum][6] = m_CFPARA6;
-    ctx->controlFile.Para[m_StepNum][7] = m_CFPARA7;
-    ctx->controlFile.Para[m_StepNum][8] = m_CFPARA8;
-    ctx->controlFile.Para[m_StepNum][9] = m_CFPARA9;
+    const double para[CONTROL_FILE_PARAS] = {
+        m_CFPARA0, m_CFPARA1, m_CFPARA2, m_CFPARA3, m_CFPARA4,
+        m_CFPARA5, m_CFPARA6, m_CFPARA7, m_CFPARA8, m_CFPARA9 };
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        SetControlFileStep(&ctx->controlFile, m_StepNum, m_SCFNum, para);
+    }
+    CheckControlFile(ctx);
     UpdateData(FALSE);
 }
 
 void CControl_File::OnBUTTONReadFile()
 {
     DigitShowContext* ctx = GetContext();
-    ctx->controlFile.CurrentNum = 0;
     CString pFileName;
     FILE* FileCtlData;
     errno_t err;
 
     CFileDialog CtlLoadFile_dlg(TRUE, NULL, "*.ctl", OFN_FILEMUSTEXIST | OFN_HIDEREADONLY,
-        "Control Files(*.ctl)|*.ctl| All Files(*.*)|*.*| |", NULL);
+        "Control Files(*.ctl)|*.ctl| Control Scripts(*.dsc)|*.dsc| All Files(*.*)|*.*| |", NULL);
 
+    // The file is parsed first; the steps are replaced, and the program
+    // restarts from step 0, in one section under the rig lock, so the
+    // control thread never compiles a script that is being replaced
     if (CtlLoadFile_dlg.DoModal() == IDOK) {
         pFileName = CtlLoadFile_dlg.GetPathName();
-        if ((err = fopen_s(&FileCtlData, (LPCSTR)pFileName, _T("r"))) == 0) {
-            for (int i = 0; i < 128; i++) {
-                fscanf_s(FileCtlData, _T("%d"), &ctx->controlFile.Num[i]);
-                for (int j = 0; j < 10; j++) {
-                    fscanf_s(FileCtlData, _T("%lf"), &ctx->controlFile.Para[i][j]);
+        if (CtlLoadFile_dlg.GetFileExt().CompareNoCase("dsc") == 0) {
+            // Control script: any number of steps, replaces the table
+            std::vector<ControlStepSource> steps;
+            std::string scriptErr;
+            if (LoadControlScript((LPCSTR)pFileName, &steps, &scriptErr)) {
+                {
+                    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+                    ctx->controlFile.Script.swap(steps);
+                    ctx->controlFile.Revision++;
+                    ctx->controlFile.CurrentNum = 0;
+                }
+                CheckControlFile(ctx);
+            }
+            else {
+                AfxMessageBox(scriptErr.c_str(), MB_ICONSTOP | MB_OK);
+            }
+        }
+        else if ((err = fopen_s(&FileCtlData, (LPCSTR)pFileName, _T("r"))) == 0) {
+            // values a short file does not give keep their current ones
+            int    num[CONTROL_FILE_STEPS];
+            double para[CONTROL_FILE_STEPS][CONTROL_FILE_PARAS];
+            {
+                std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+                std::memcpy(num, ctx->controlFile.Num, sizeof(num));
+                std::memcpy(para, ctx->controlFile.Para, sizeof(para));
+            }
+            for (int i = 0; i < CONTROL_FILE_STEPS; i++) {
+                fscanf_s(FileCtlData, _T("%d"), &num[i]);
+                for (int j = 0; j < CONTROL_FILE_PARAS; j++) {
+                    fscanf_s(FileCtlData, _T("%lf"), &para[i][j]);
                 }
             }
             fclose(FileCtlData);
+            {
+                std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+                ctx->controlFile.Script.clear();
+                std::memcpy(ctx->controlFile.Num, num, sizeof(num));
+                std::memcpy(ctx->controlFile.Para, para, sizeof(para));
+                ctx->controlFile.Revision++;
+                ctx->controlFile.CurrentNum = 0;
+            }
+            CheckControlFile(ctx);
         }
     }
-    m_CFNum = ctx->controlFile.Num[ctx->controlFile.CurrentNum];
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+    double para[CONTROL_FILE_PARAS];
+    GetControlFileStep(ctx->controlFile, ctx->controlFile.CurrentNum, &m_CFNum, para);
     UpdateData(FALSE);
 }
 
@@ -161,15 +221,23 @@ void CControl_File::OnBUTTONSaveFile()
     FILE* FileCtlData;
     errno_t err;
 
-    CFileDialog CtlSaveFile_dlg(FALSE, NULL, "*.ctl", OFN_OVERWRITEPROMPT,
-        "Control Files(*.ctl)|*.ctl| All Files(*.*)|*.*| |", NULL);
+    const bool script = !ctx->controlFile.Script.empty();
+    CFileDialog CtlSaveFile_dlg(FALSE, NULL, script ? "*.dsc" : "*.ctl", OFN_OVERWRITEPROMPT,
+        script ? "Control Scripts(*.dsc)|*.dsc| All Files(*.*)|*.*| |"
+               : "Control Files(*.ctl)|*.ctl| All Files(*.*)|*.*| |", NULL);
 
     if (CtlSaveFile_dlg.DoModal() == IDOK) {
         pFileName = CtlSaveFile_dlg.GetPathName();
-        if ((err = fopen_s(&FileCtlData, (LPCSTR)pFileName, _T("w"))) == 0) {
-            for (int i = 0; i < 128; i++) {
+        if (script) {
+            // repeat blocks are written expanded
+            if (!SaveControlScript((LPCSTR)pFileName, ctx->controlFile.Script)) {
+                AfxMessageBox("Cannot write the control script", MB_ICONSTOP | MB_OK);
+            }
+        }
+        else if ((err = fopen_s(&FileCtlData, (LPCSTR)pFileName, _T("w"))) == 0) {
+            for (int i = 0; i < CONTROL_FILE_STEPS; i++) {
                 fprintf(FileCtlData, "%d    ", ctx->controlFile.Num[i]);
-                for (int j = 0; j < 10; j++) {
+                for (int j = 0; j < CONTROL_FILE_PARAS; j++) {
                     fprintf(FileCtlData, "%lf    ", ctx->controlFile.Para[i][j]);
                 }
                 fprintf(FileCtlData, "\n");
@@ -189,7 +257,7 @@ void CControl_File::OnCHECKChangeNo()
         if (ctx->controlFile.CurrentNum > 0) {
             myBTN1->EnableWindow(TRUE);
         }
-        if (ctx->controlFile.CurrentNum < 127) {
+        if (ctx->controlFile.CurrentNum < ControlFileSteps(ctx->controlFile)-1) {
             myBTN2->EnableWindow(TRUE);
         }
     }
@@ -202,29 +270,33 @@ void CControl_File::OnCHECKChangeNo()
 void CControl_File::OnBUTTONStepDec()
 {
     DigitShowContext* ctx = GetContext();
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->controlFile.CurrentNum--;
     ctx->NumCyclic = 0;
     ctx->TotalStepTime = 0.0;
     m_CurNum = ctx->controlFile.CurrentNum;
-    m_CFNum = ctx->controlFile.Num[ctx->controlFile.CurrentNum];
+    double para[CONTROL_FILE_PARAS];
+    GetControlFileStep(ctx->controlFile, ctx->controlFile.CurrentNum, &m_CFNum, para);
     CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_StepDec);
     CButton* myBTN2 = (CButton*)GetDlgItem(IDC_BUTTON_StepInc);
     myBTN1->EnableWindow(ctx->controlFile.CurrentNum > 0);
-    myBTN2->EnableWindow(ctx->controlFile.CurrentNum < 127);
+    myBTN2->EnableWindow(ctx->controlFile.CurrentNum < ControlFileSteps(ctx->controlFile)-1);
     UpdateData(FALSE);
 }
 
 void CControl_File::OnBUTTONStepInc()
 {
     DigitShowContext* ctx = GetContext();
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->controlFile.CurrentNum++;
     ctx->NumCyclic = 0;
     ctx->TotalStepTime = 0.0;
     m_CurNum = ctx->controlFile.CurrentNum;
-    m_CFNum = ctx->controlFile.Num[ctx->controlFile.CurrentNum];
+    double para[CONTROL_FILE_PARAS];
+    GetControlFileStep(ctx->controlFile, ctx->controlFile.CurrentNum, &m_CFNum, para);
     CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_StepDec);
     CButton* myBTN2 = (CButton*)GetDlgItem(IDC_BUTTON_StepInc);
     myBTN1->EnableWindow(ctx->controlFile.CurrentNum > 0);
-    myBTN2->EnableWindow(ctx->controlFile.CurrentNum < 127);
+    myBTN2->EnableWindow(ctx->controlFile.CurrentNum < ControlFileSteps(ctx->controlFile)-1);
     UpdateData(FALSE);
 }
@@ -199,6 +199,8 @@ void CControl_ID::OnBUTTONUpdate()
     ControlData* ControlData = ctx->control;
 
     UpdateData(TRUE);
+    // The control thread of this rig reads control[] under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     tmp = m_Control_ID;
     ControlData[tmp].e_sigma[0] = m_esigma0; 
     ControlData[tmp].e_sigma[1] = m_esigma1;
@@ -262,6 +264,7 @@ void CControl_ID::OnBUTTONLoadfromfile()
         pFileName = CtlReadFile_dlg.GetPathName();    
         if((err = fopen_s(&FileCtlData,(LPCSTR)pFileName , _T("r"))) == 0)
         {
+            std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
             for(i = 0;i<16;i++){
                 int tmpFlag[3];
                 fscanf_s(FileCtlData,_T("%d"),&tmp);
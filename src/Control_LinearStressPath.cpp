@@ -59,6 +59,8 @@ void CControl_LinearStressPath::OnBUTTONUpdate()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control thread of this rig reads control[] under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->control[7].e_sigma[0] = m_e_sigma1;
     ctx->control[7].e_sigma[1] = m_e_sigma2;
     ctx->control[7].MotorSpeed = m_MotorSpeed;
@@ -57,6 +57,8 @@ void CControl_MLoading::OnBUTTONUpdate()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control thread of this rig reads control[] under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->control[3].MotorCruch = m_MotorCruch;
     ctx->control[3].MotorSpeed = m_MotorSpeed;
     ctx->control[3].flag[0] = (m_flag0 != 0);
@@ -67,6 +69,7 @@ void CControl_MLoading::OnBUTTONUpdate()
 void CControl_MLoading::OnBUTTONReflesh()
 {
     DigitShowContext* ctx = GetContext();
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     if (ctx->ControlID == 4) {
         ctx->control[3] = ctx->control[4];
     }
@@ -51,6 +51,8 @@ void CControl_PreConsolidation::OnOK()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control thread of this rig reads control[] under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->control[1].q = m_q;
     ctx->control[1].MotorSpeed = m_MotorSpeed;
     CDialog::OnOK();
@@ -54,6 +54,8 @@ void CControl_Sensitivity::OnOK()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control thread of this rig reads errTol under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->errTol.StressA = m_ERR_StressA;
     ctx->errTol.StressCom = m_ERR_StressCom;
     ctx->errTol.StressExt = m_ERR_StressExt;
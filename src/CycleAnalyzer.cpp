@@ -0,0 +1,153 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "CycleAnalyzer.h"
+
+#include <cmath>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+} // namespace
+
+CycleAnalyzer::CycleAnalyzer()
+    : m_Band(CYCLE_BAND_DEFAULT)
+{
+    Reset();
+}
+
+void CycleAnalyzer::Reset()
+{
+    m_Started  = false;
+    m_Dir      = 0;
+    m_U0 = m_Ep0 = 0.0;
+    m_PrevQ = m_PrevEa = 0.0;
+    m_Area     = 0.0;
+    m_Ru       = 0.0;
+    m_HavePeak = false;
+    m_Ext = m_Peak = m_Trough = Extreme();
+    m_QSeen.Clear();
+    m_Ea.Clear();
+    m_RuSpan.Clear();
+    m_EaPending.Clear();
+    m_RuPending.Clear();
+    m_Last = CycleResult();
+}
+
+// The present sample becomes the candidate extreme: everything up to it
+// belongs to the open cycle
+void CycleAnalyzer::Extend(double t, double q, double ea)
+{
+    m_Ext.T    = t;
+    m_Ext.Q    = q;
+    m_Ext.Ea   = ea;
+    m_Ext.Ru   = m_Ru;
+    m_Ext.Area = m_Area;
+    m_Ea.Add(m_EaPending);
+    m_RuSpan.Add(m_RuPending);
+    m_EaPending.Clear();
+    m_RuPending.Clear();
+}
+
+bool CycleAnalyzer::Push(double t, double q, double ea, double u, double ep)
+{
+    if (!m_Started) {
+        m_Started = true;
+        m_U0  = u;
+        m_Ep0 = ep;
+        m_PrevQ  = q;
+        m_PrevEa = ea;
+    }
+    m_Area  += 0.5 * (q + m_PrevQ) * (ea - m_PrevEa);
+    m_PrevQ  = q;
+    m_PrevEa = ea;
+    m_Ru = (m_Ep0 > 0.0) ? (u - m_U0) / m_Ep0 : 0.0;
+    m_EaPending.Add(ea);
+    m_RuPending.Add(m_Ru);
+
+    if (m_Dir == 0) {
+        // Direction of the first half cycle
+        m_QSeen.Add(q);
+        if (q - m_QSeen.Min >= m_Band)      m_Dir =  1;
+        else if (m_QSeen.Max - q >= m_Band) m_Dir = -1;
+        if (m_Dir != 0) Extend(t, q, ea);
+        return false;
+    }
+    if (m_Dir > 0) {
+        if (q >= m_Ext.Q) {
+            Extend(t, q, ea);
+            return false;
+        }
+        if (m_Ext.Q - q < m_Band) return false;
+
+        // Maximum confirmed: it closes the open cycle and opens the next
+        bool done = false;
+        if (m_HavePeak) {
+            CycleResult& r = m_Last;
+            r.Cycle     = r.Cycle + 1;
+            r.TimeStart = m_Peak.T;
+            r.TimeEnd   = m_Ext.T;
+            r.QMax      = m_Ext.Q;
+            r.QMin      = m_Trough.Q;
+            r.EaAtQMax  = m_Ext.Ea;
+            r.EaAtQMin  = m_Trough.Ea;
+            r.EaMax     = m_Ea.Max;
+            r.EaMin     = m_Ea.Min;
+            r.DoubleAmplitude = m_Ea.Max - m_Ea.Min;
+            const double dq = r.QMax - r.QMin;
+            const double de = r.EaAtQMax - r.EaAtQMin;
+            r.SecantModulus = (std::fabs(de) > 1e-9) ? dq / de / 10.0 : 0.0;
+            r.LoopArea = std::fabs(m_Ext.Area - m_Peak.Area);
+            const double w = std::fabs(dq * de) / 8.0;
+            r.Damping  = (w > 0.0) ? r.LoopArea / (4.0 * kPi * w) : 0.0;
+            r.Ru       = m_Ext.Ru;
+            r.RuMax    = m_RuSpan.Max;
+            done = true;
+        }
+        m_HavePeak = true;
+        m_Peak = m_Ext;
+        m_Ea.Clear();
+        m_Ea.Add(m_Ext.Ea);
+        m_RuSpan.Clear();
+        m_RuSpan.Add(m_Ext.Ru);
+        m_Dir = -1;
+        Extend(t, q, ea);
+        return done;
+    }
+    if (q <= m_Ext.Q) {
+        Extend(t, q, ea);
+        return false;
+    }
+    if (q - m_Ext.Q >= m_Band) {
+        // Minimum confirmed
+        m_Trough = m_Ext;
+        m_Dir = 1;
+        Extend(t, q, ea);
+    }
+    return false;
+}
+
+double CycleAnalyzer::DoubleAmplitude() const
+{
+    Span s = m_Ea;
+    s.Add(m_EaPending);
+    const double now = s.Empty() ? 0.0 : s.Max - s.Min;
+    return (now > m_Last.DoubleAmplitude) ? now : m_Last.DoubleAmplitude;
+}
@@ -0,0 +1,109 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __CYCLEANALYZER_H_INCLUDE__
+#define __CYCLEANALYZER_H_INCLUDE__
+
+#pragma once
+
+#define CYCLE_BAND_DEFAULT  2.0     // kPa, q reversal hysteresis ("cycle" in the filter config)
+
+/**
+ * One completed load cycle (peak of q to the next peak)
+ */
+struct CycleResult {
+    int    Cycle;                   // 1, 2, ... since Reset()
+    double TimeStart, TimeEnd;      // s, sample times of the two peaks
+    double QMax, QMin;              // kPa, closing peak and the trough before it
+    double EaAtQMax, EaAtQMin;      // %, axial strain at those samples
+    double EaMax, EaMin;            // %, axial strain range over the cycle
+    double DoubleAmplitude;         // %, EaMax - EaMin
+    double SecantModulus;           // MPa, (QMax - QMin) / (EaAtQMax - EaAtQMin)
+    double LoopArea;                // kPa·%, |closed integral of q dea|
+    double Damping;                 // LoopArea / (4π · W), W = ΔQ·ΔEa / 8
+    double Ru;                      // excess pore pressure ratio at the closing peak
+    double RuMax;                   // largest ratio during the cycle
+};
+
+/**
+ * Streaming hysteresis analysis of cyclic loading on the filtered q / ea.
+ *
+ * Reversals of q are found with a hysteresis band: a maximum is confirmed
+ * once q has fallen Band below it, a minimum once q has risen Band above
+ * it. A cycle runs from one confirmed maximum to the next. The loop area
+ * is a running trapezoid sum of q dea, sampled at each candidate peak, so
+ * every sample costs a constant amount of work whatever the cycle length.
+ * Strain and pore-pressure extremes seen after a candidate peak are held
+ * apart until the peak is confirmed or superseded, so each cycle gets
+ * exactly the samples between its two peaks.
+ *
+ * Ru = (u - u0) / p'0 with u0 and p'0 taken at the first sample after
+ * Reset().
+ */
+class CycleAnalyzer
+{
+public:
+    CycleAnalyzer();
+
+    void SetBand(double kPa) { m_Band = (kPa > 0.0) ? kPa : CYCLE_BAND_DEFAULT; }
+    void Reset();
+
+    // One sample at time t [s]: q [kPa], ea [%], u [kPa], p' [kPa].
+    // Returns true when it completed a cycle (see Last()).
+    bool Push(double t, double q, double ea, double u, double ep);
+
+    int    Cycles() const { return m_Last.Cycle; }
+    const CycleResult& Last() const { return m_Last; }
+    // Double amplitude of the cycle in progress, or of the last one if larger
+    double DoubleAmplitude() const;
+    double Ru() const { return m_Ru; }
+
+private:
+    struct Span {
+        double Min, Max;
+        void Clear()          { Min = 1e300; Max = -1e300; }
+        void Add(double x)    { if (x < Min) Min = x; if (x > Max) Max = x; }
+        void Add(const Span& s) { if (s.Min < Min) Min = s.Min; if (s.Max > Max) Max = s.Max; }
+        bool Empty() const    { return Min > Max; }
+    };
+    // Candidate extreme of q in the present direction
+    struct Extreme {
+        double T, Q, Ea, Ru, Area;
+    };
+
+    void Extend(double t, double q, double ea);
+
+    double m_Band;
+    bool   m_Started;
+    int    m_Dir;                   // +1 rising, -1 falling, 0 not known yet
+    double m_U0, m_Ep0;
+    double m_PrevQ, m_PrevEa;
+    double m_Area;                  // running sum of q dea since Reset()
+    double m_Ru;
+    Span   m_QSeen;                 // q range before the first reversal
+    Extreme m_Ext;                  // candidate peak (m_Dir > 0) or trough (m_Dir < 0)
+    bool   m_HavePeak;              // a cycle is open
+    Extreme m_Peak;                 // its opening peak
+    Extreme m_Trough;               // lowest q confirmed since that peak
+    Span   m_Ea, m_RuSpan;          // cycle so far, up to m_Ext
+    Span   m_EaPending, m_RuPending;// after m_Ext
+    CycleResult m_Last;
+};
+
+#endif // __CYCLEANALYZER_H_INCLUDE__
@@ -77,6 +77,8 @@ void CDA_Channel::OnOK()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control thread of this rig converts with ao.cal under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->ao.cal.a[0] = m_DA_Cala00;
     ctx->ao.cal.a[1] = m_DA_Cala01;
     ctx->ao.cal.a[2] = m_DA_Cala02;
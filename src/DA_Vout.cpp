@@ -63,6 +63,8 @@ void CDA_Vout::OnBUTTONDAVout()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // The control loop of this rig writes ao.raw under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->ao.raw[0] = m_DAVout01;
     ctx->ao.raw[1] = m_DAVout02;
     ctx->ao.raw[2] = m_DAVout03;
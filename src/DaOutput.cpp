@@ -0,0 +1,291 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "DaOutput.h"
+#include "AioDevice.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const double kWaveAheadSeconds = 2.0;   // board memory kept at least this far ahead
+const int    kWaveAheadCycles  = 2;
+
+} // namespace
+
+void SetDefaultDaLimits(DaChannelLimits* lim)
+{
+    lim->Min  = 0.0f;
+    lim->Max  = 9.9999f;
+    lim->Slew = 0.0f;
+}
+
+DaOutputStage::DaOutputStage()
+    : m_Dev(nullptr)
+    , m_Channels(0)
+    , m_RangeMax(10.0f)
+    , m_RangeMin(0.0f)
+    , m_CodeMax(65535)
+    , m_Force(true)
+    , m_WriteSum(0.0)
+{
+    for (int j = 0; j < DA_OUT_CHANNELS; j++) {
+        SetDefaultDaLimits(&m_Limits[j]);
+        m_Target[j] = 0.0f;
+        m_Out[j]    = 0.0f;
+        m_Code[j]   = 0;
+    }
+    m_Stats = Stats();
+    m_Wave.Running = false;
+}
+
+void DaOutputStage::Attach(IAioDevice* dev, int channels, float rangeMax, float rangeMin, short resolution)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Dev      = dev;
+    m_Channels = (channels > DA_OUT_CHANNELS) ? DA_OUT_CHANNELS : channels;
+    m_RangeMax = rangeMax;
+    m_RangeMin = rangeMin;
+    m_CodeMax  = (resolution == 16) ? 65535 : 4095;
+    m_Force    = true;
+}
+
+void DaOutputStage::Detach()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    if (m_Wave.Running) EndWave();
+    m_Dev      = nullptr;
+    m_Channels = 0;
+}
+
+void DaOutputStage::SetLimits(int ch, const DaChannelLimits& lim)
+{
+    if (ch < 0 || ch >= DA_OUT_CHANNELS) return;
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Limits[ch] = lim;
+}
+
+DaChannelLimits DaOutputStage::Limits(int ch) const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_Limits[ch];
+}
+
+void DaOutputStage::Request(float* volts)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Stats.Requests++;
+    for (int j = 0; j < m_Channels; j++) {
+        const DaChannelLimits& lim = m_Limits[j];
+        if (volts[j] < lim.Min) volts[j] = lim.Min;
+        if (volts[j] > lim.Max) volts[j] = lim.Max;
+        m_Target[j] = volts[j];
+    }
+}
+
+long DaOutputStage::Service(double dt)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    if (m_Dev == nullptr || m_Channels == 0) return 0;
+    if (m_Wave.Running) return RefillWave();
+
+    long code[DA_OUT_CHANNELS];
+    bool dirty = m_Force;
+    for (int j = 0; j < m_Channels; j++) {
+        float out = m_Target[j];
+        const float slew = m_Limits[j].Slew;
+        if (slew > 0.0f) {
+            const float step = float(slew * dt);
+            if (out > m_Out[j] + step)      { out = m_Out[j] + step; m_Stats.Limited++; }
+            else if (out < m_Out[j] - step) { out = m_Out[j] - step; m_Stats.Limited++; }
+        }
+        m_Out[j] = out;
+        code[j]  = Encode(out);
+        if (code[j] != m_Code[j]) dirty = true;
+    }
+    if (!dirty) {
+        m_Stats.Skipped++;
+        return 0;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const long ret = m_Dev->MultiAo(short(m_Channels), code);
+    const double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    m_Stats.Writes++;
+    m_WriteSum += took;
+    m_Stats.WriteMean = m_WriteSum / double(m_Stats.Writes);
+    if (took > m_Stats.WriteMax) m_Stats.WriteMax = took;
+    if (ret != 0) {
+        // retried on the next Service()
+        m_Stats.Errors++;
+        m_Stats.LastError = ret;
+        m_Force = true;
+        return ret;
+    }
+    for (int j = 0; j < m_Channels; j++) m_Code[j] = code[j];
+    m_Force = false;
+    return 0;
+}
+
+float DaOutputStage::Output(int ch) const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return (ch >= 0 && ch < DA_OUT_CHANNELS) ? m_Out[ch] : 0.0f;
+}
+
+DaOutputStage::Stats DaOutputStage::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_Stats;
+}
+
+void DaOutputStage::ResetStats()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Stats = Stats();
+    m_WriteSum = 0.0;
+}
+
+// ── Buffered waveform ────────────────────────────────────────
+
+long DaOutputStage::StartWave(const AoWaveSpec& spec, const float* base)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    if (m_Dev == nullptr || m_Channels < AO_WAVE_CHANNELS) return -1;
+    if (m_Wave.Running) EndWave();
+
+    m_Wave.Spec = spec;
+    for (int j = 0; j < AO_WAVE_CHANNELS; j++) m_Wave.Base[j] = base[j];
+    m_Wave.Amplitude      = spec.Amplitude;
+    m_Wave.FramesPerCycle = AoWaveFramesPerCycle(spec.Period);
+    m_Wave.Ahead          = int(std::ceil(kWaveAheadSeconds / spec.Period));
+    if (m_Wave.Ahead < kWaveAheadCycles) m_Wave.Ahead = kWaveAheadCycles;
+    m_Wave.Loaded = 0;
+    m_Wave.Done   = 0;
+
+    const float clock_us = float(spec.Period / m_Wave.FramesPerCycle * 1e6);
+    m_Dev->StopAo();
+    long ret = m_Dev->ResetAoMemory();
+    if (ret == 0) ret = m_Dev->SetAoChannels(AO_WAVE_CHANNELS);
+    if (ret == 0) ret = m_Dev->SetAoMemoryType(0);          // FIFO
+    if (ret == 0) ret = m_Dev->SetAoSamplingClock(clock_us);
+    if (ret == 0) ret = m_Dev->SetAoStopTrigger(0);         // end of data
+    while (ret == 0 && m_Wave.Loaded < m_Wave.Ahead && m_Wave.Loaded < spec.Cycles)
+        ret = LoadWaveCycle();
+    if (ret == 0) ret = m_Dev->StartAo();
+    if (ret != 0) {
+        m_Stats.Errors++;
+        m_Stats.LastError = ret;
+        m_Dev->StopAo();
+        m_Force = true;
+        return ret;
+    }
+    m_Wave.Running = true;
+    return 0;
+}
+
+void DaOutputStage::StopWave()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    if (m_Wave.Running) EndWave();
+}
+
+bool DaOutputStage::WaveRunning() const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_Wave.Running;
+}
+
+int DaOutputStage::WaveCycles() const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_Wave.Done;
+}
+
+void DaOutputStage::SetWaveAmplitude(double amplitude)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Wave.Amplitude = amplitude;
+}
+
+long DaOutputStage::LoadWaveCycle()
+{
+    AoWaveCycle(m_Wave.Spec, m_Wave.Amplitude, m_Wave.Base, &m_Wave.Volts);
+    m_Wave.Codes.resize(m_Wave.Volts.size());
+    for (size_t i = 0; i < m_Wave.Volts.size(); i++) {
+        const DaChannelLimits& lim = m_Limits[i % AO_WAVE_CHANNELS];
+        float v = m_Wave.Volts[i];
+        if (v < lim.Min) v = lim.Min;
+        if (v > lim.Max) v = lim.Max;
+        m_Wave.Codes[i] = Encode(v);
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    const long ret = m_Dev->SetAoSamplingData(m_Wave.FramesPerCycle, &m_Wave.Codes[0]);
+    const double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    m_Stats.Writes++;
+    m_WriteSum += took;
+    m_Stats.WriteMean = m_WriteSum / double(m_Stats.Writes);
+    if (took > m_Stats.WriteMax) m_Stats.WriteMax = took;
+    if (ret == 0) m_Wave.Loaded++;
+    return ret;
+}
+
+// Tops the board memory up to Ahead cycles; ends the wave after the last one
+long DaOutputStage::RefillWave()
+{
+    long remaining = 0;
+    long ret = m_Dev->GetAoSamplingTimes(&remaining);
+    if (ret == 0) {
+        const long queued = (remaining + m_Wave.FramesPerCycle - 1) / m_Wave.FramesPerCycle;
+        m_Wave.Done = m_Wave.Loaded - int(queued);
+        while (ret == 0 && m_Wave.Loaded - m_Wave.Done < m_Wave.Ahead && m_Wave.Loaded < m_Wave.Spec.Cycles)
+            ret = LoadWaveCycle();
+    }
+    long status = 0;
+    if (ret == 0) ret = m_Dev->GetAoStatus(&status);
+    if (ret != 0) {
+        m_Stats.Errors++;
+        m_Stats.LastError = ret;
+        EndWave();
+        return ret;
+    }
+    if (!(status & AIO_AOS_BUSY) && m_Wave.Loaded >= m_Wave.Spec.Cycles) {
+        m_Wave.Done = m_Wave.Loaded;
+        EndWave();
+    }
+    return 0;
+}
+
+// Board back to the static outputs, written on the next Service()
+void DaOutputStage::EndWave()
+{
+    m_Dev->StopAo();
+    m_Wave.Running = false;
+    for (int j = 0; j < AO_WAVE_CHANNELS && !m_Wave.Volts.empty(); j++)
+        m_Out[j] = m_Wave.Volts[m_Wave.Volts.size() - AO_WAVE_CHANNELS + j];
+    m_Force = true;
+}
+
+// Same conversion as VoltToBinary() (DataConvert.h)
+long DaOutputStage::Encode(float volt) const
+{
+    if (m_RangeMax == m_RangeMin) return 0;
+    return long(m_CodeMax * (volt - m_RangeMin) / (m_RangeMax - m_RangeMin));
+}
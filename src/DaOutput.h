@@ -0,0 +1,147 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DAOUTPUT_H_INCLUDE__
+#define __DAOUTPUT_H_INCLUDE__
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "AoWaveform.h"
+
+class IAioDevice;
+
+#define DA_OUT_CHANNELS 8   // = AO_MAX_CHANNELS
+
+/**
+ * Limits of one DA channel
+ */
+struct DaChannelLimits {
+    float Min;      // V
+    float Max;      // V
+    float Slew;     // V/s, 0 = unlimited
+};
+
+void SetDefaultDaLimits(DaChannelLimits* lim);   // 0–9.9999 V, no slew limit
+
+/**
+ * The only writer of a rig's DA board.
+ *
+ * Request() takes the setpoints of all channels (ao.raw), clamps them to
+ * the channel limits and marks the channels whose setpoint changed.
+ * Service(dt) moves each output toward its setpoint by at most Slew·dt,
+ * encodes it and calls MultiAo() only when a code differs from what the
+ * board already holds. Control steps call Service() with their dt, the
+ * UI timer with the display interval while control is off, so slewed
+ * channels keep ramping between requests.
+ *
+ * A waveform (AoWaveform.h) is streamed through the board's buffered
+ * output instead: StartWave() loads the first cycles and starts the
+ * board clock, Service() only tops the board memory up, and the static
+ * outputs are written again when the last cycle has been output or
+ * StopWave() is called. Frames are clamped to the channel limits; the
+ * slew limit does not apply to them.
+ *
+ * All calls take the stage's own lock: the dialogs (UI thread) and the
+ * control loop may both write without further coordination.
+ */
+class DaOutputStage
+{
+public:
+    struct Stats {
+        uint64_t Requests;     // Request() calls
+        uint64_t Writes;       // MultiAo() calls
+        uint64_t Skipped;      // Service() calls with nothing to write
+        uint64_t Limited;      // channel updates cut by the slew limit
+        uint64_t Errors;       // MultiAo() / buffered output failures
+        long     LastError;
+        double   WriteMean;    // s, MultiAo() duration
+        double   WriteMax;     // s
+    };
+
+    DaOutputStage();
+
+    // Board of the rig (nullptr = no DA board); range and resolution as
+    // read back from the board. Forces a full write on the next Service().
+    void Attach(IAioDevice* dev, int channels, float rangeMax, float rangeMin, short resolution);
+    void Detach();
+
+    void SetLimits(int ch, const DaChannelLimits& lim);
+    DaChannelLimits Limits(int ch) const;
+
+    // volts[0..channels-1]: new setpoints, clamped in place to the limits
+    void Request(float* volts);
+
+    // Advance slewed outputs by dt [s] and write what changed.
+    // Returns the MultiAo() error code (0 = success or nothing to write).
+    long Service(double dt);
+
+    // Output now on the board [V] (static outputs)
+    float Output(int ch) const;
+
+    // base: static voltages of DA ch 0..AO_WAVE_CHANNELS-1 while the wave
+    // runs. Returns the board's error code, -1 without a board.
+    long StartWave(const AoWaveSpec& spec, const float* base);
+    void StopWave();
+    bool WaveRunning() const;
+    int  WaveCycles() const;                    // cycles output so far
+    void SetWaveAmplitude(double amplitude);    // for the cycles not yet loaded
+
+    Stats GetStats() const;
+    void  ResetStats();
+
+private:
+    DaOutputStage(const DaOutputStage&) = delete;
+    DaOutputStage& operator=(const DaOutputStage&) = delete;
+
+    long Encode(float volt) const;
+    long LoadWaveCycle();
+    long RefillWave();
+    void EndWave();
+
+    mutable std::mutex m_Lock;
+    IAioDevice* m_Dev;
+    int     m_Channels;
+    float   m_RangeMax, m_RangeMin;
+    long    m_CodeMax;
+    bool    m_Force;                         // write even if no code changed
+    DaChannelLimits m_Limits[DA_OUT_CHANNELS];
+    float   m_Target[DA_OUT_CHANNELS];       // requested [V]
+    float   m_Out[DA_OUT_CHANNELS];          // after slew limiting [V]
+    long    m_Code[DA_OUT_CHANNELS];         // last written
+    Stats   m_Stats;
+    double  m_WriteSum;
+
+    struct {
+        bool       Running;
+        AoWaveSpec Spec;
+        float      Base[AO_WAVE_CHANNELS];
+        double     Amplitude;
+        int        FramesPerCycle;
+        int        Ahead;               // cycles kept in board memory
+        int        Loaded;              // cycles written to the board
+        int        Done;                // cycles output
+        std::vector<float> Volts;
+        std::vector<long>  Codes;
+    } m_Wave;
+};
+
+#endif // __DAOUTPUT_H_INCLUDE__
@@ -0,0 +1,409 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "DataLog.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "TsvFormat.h"
+
+namespace {
+
+const size_t kNoChunk  = size_t(-1);
+const size_t kGapKind  = 24;                    // bytes of the kind name in a gap
+const size_t kGapBytes = 8 + 8 + 8 + kGapKind;
+
+void Put(std::vector<char>* buf, const void* p, size_t n)
+{
+    const char* c = static_cast<const char*>(p);
+    buf->insert(buf->end(), c, c + n);
+}
+
+void PutU32(std::vector<char>* buf, uint32_t v) { Put(buf, &v, sizeof(v)); }
+
+FILE* OpenFile(const char* path, const char* mode)
+{
+    FILE* fp = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&fp, path, mode) != 0) fp = nullptr;
+#else
+    fp = std::fopen(path, mode);
+#endif
+    return fp;
+}
+
+size_t RowBytes(int channels, int params)
+{
+    return sizeof(double) + size_t(channels) * (sizeof(float) + sizeof(double))
+         + size_t(params) * sizeof(double);
+}
+
+} // namespace
+
+DataLogWriter::DataLogWriter()
+    : m_File(nullptr), m_Channels(0), m_Params(0), m_Active(false),
+      m_Head(0), m_Count(0), m_Stop(false), m_Convert(false), m_Closed(false),
+      m_ChunkStart(kNoChunk), m_ChunkKind(-1),
+      m_Written(0), m_Dropped(0), m_Failed(0), m_WriteMax(0.0)
+{
+}
+
+DataLogWriter::~DataLogWriter()
+{
+    if (m_Active) Close(false);
+    Wait();
+}
+
+bool DataLogWriter::Open(const char* path, const LogHeader& header, std::string* err)
+{
+    if (m_Active) Close(false);
+    Retire();
+    if (header.Channels < 0 || header.Channels > LOG_MAX_CHANNELS
+     || header.Params < 0 || header.Params > LOG_MAX_PARAMS) {
+        if (err) *err = "too many channels for the log";
+        return false;
+    }
+    m_File = OpenFile(path, "wb");
+    if (m_File == nullptr) {
+        if (err) *err = std::string("cannot create ") + path;
+        return false;
+    }
+    m_Path     = path;
+    m_Channels = header.Channels;
+    m_Params   = header.Params;
+
+    // Header: everything a reader needs to interpret the rows
+    std::string text;
+    char line[64];
+    std::snprintf(line, sizeof(line), "channels\t%d\nparams\t%d\nrow_bytes\t%u\n",
+                  m_Channels, m_Params, unsigned(RowBytes(m_Channels, m_Params)));
+    text += line;
+    text += "voltage\t"  + header.VoltageColumns  + "\n";
+    text += "physical\t" + header.PhysicalColumns + "\n";
+    text += "param\t"    + header.ParamColumns    + "\n";
+    for (const std::string& s : header.Info) text += s + "\n";
+
+    m_Buf.clear();
+    Put(&m_Buf, "DSLG", 4);
+    PutU32(&m_Buf, LOG_FILE_VERSION);
+    Put(&m_Buf, "HEAD", 4);
+    PutU32(&m_Buf, uint32_t(text.size()));
+    Put(&m_Buf, text.data(), text.size());
+    const bool ok = std::fwrite(m_Buf.data(), 1, m_Buf.size(), m_File) == m_Buf.size()
+                 && std::fflush(m_File) == 0;
+    m_Buf.clear();
+    if (!ok) {
+        std::fclose(m_File);
+        m_File = nullptr;
+        if (err) *err = std::string("cannot write ") + path;
+        return false;
+    }
+
+    m_Queue.resize(LOG_QUEUE_DEPTH);
+    m_Head = m_Count = 0;
+    m_Stop = m_Convert = m_Closed = false;
+    m_ChunkStart = kNoChunk;
+    m_ChunkKind  = -1;
+    m_Written.store(0);
+    m_Dropped.store(0);
+    m_Failed.store(0);
+    m_WriteMax.store(0.0);
+    m_Active = true;
+    m_Thread = std::thread(&DataLogWriter::Loop, this);
+    return true;
+}
+
+bool DataLogWriter::Push(const LogRecord& r)
+{
+    if (!m_Active) return false;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Count >= m_Queue.size()) {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_Queue[(m_Head + m_Count) % m_Queue.size()] = r;
+        m_Count++;
+        wake = (m_Count == m_Queue.size() / 4);
+    }
+    // The writer wakes every LOG_FLUSH_SEC anyway; only a filling queue hurries it
+    if (wake) m_Wake.notify_one();
+    return true;
+}
+
+void DataLogWriter::Close(bool convert)
+{
+    if (!m_Active) return;
+    m_Active = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop    = true;
+        m_Convert = convert;
+    }
+    m_Wake.notify_one();
+}
+
+void DataLogWriter::Wait()
+{
+    if (m_Thread.joinable()) m_Thread.join();
+    for (std::thread& t : m_Converting) t.join();
+    m_Converting.clear();
+}
+
+// Once its file is closed the writer only converts copies of the file
+// name, so the members are free for the next file and the thread is kept
+// until Wait()
+void DataLogWriter::Retire()
+{
+    if (!m_Thread.joinable()) return;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_ClosedCv.wait(lock, [this]() { return m_Closed; });
+    }
+    m_Converting.push_back(std::move(m_Thread));
+}
+
+bool DataLogWriter::WaitClosed(double timeoutSec)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    return m_ClosedCv.wait_for(lock, std::chrono::duration<double>(timeoutSec),
+                               [this]() { return m_Closed; });
+}
+
+void DataLogWriter::EndChunk()
+{
+    if (m_ChunkStart == kNoChunk) return;
+    const uint32_t bytes = uint32_t(m_Buf.size() - m_ChunkStart - 8);
+    std::memcpy(&m_Buf[m_ChunkStart + 4], &bytes, sizeof(bytes));
+    m_ChunkStart = kNoChunk;
+    m_ChunkKind  = -1;
+}
+
+// Appends r to the chunk of its kind, preceded by a gap for records
+// the queue refused since the previous batch
+void DataLogWriter::Serialize(const LogRecord& r, uint64_t dropped)
+{
+    if (dropped > 0) {
+        LogRecord gap;
+        gap.Kind    = LOG_REC_GAP;
+        gap.Time    = r.Time;
+        gap.GapEnd  = r.Time;
+        gap.Lost    = dropped;
+        gap.GapKind = "log queue full";
+        Serialize(gap, 0);
+    }
+    if (m_ChunkKind != r.Kind) {
+        EndChunk();
+        m_ChunkStart = m_Buf.size();
+        m_ChunkKind  = r.Kind;
+        Put(&m_Buf, (r.Kind == LOG_REC_ROW) ? "ROWS" : "GAPS", 4);
+        PutU32(&m_Buf, 0);
+    }
+    if (r.Kind == LOG_REC_ROW) {
+        Put(&m_Buf, &r.Time, sizeof(r.Time));
+        Put(&m_Buf, r.Raw,   sizeof(float)  * m_Channels);
+        Put(&m_Buf, r.Phy,   sizeof(double) * m_Channels);
+        Put(&m_Buf, r.Param, sizeof(double) * m_Params);
+    }
+    else {
+        char kind[kGapKind] = {};
+        if (r.GapKind) std::strncpy(kind, r.GapKind, kGapKind - 1);
+        Put(&m_Buf, &r.Time,   sizeof(r.Time));
+        Put(&m_Buf, &r.GapEnd, sizeof(r.GapEnd));
+        Put(&m_Buf, &r.Lost,   sizeof(r.Lost));
+        Put(&m_Buf, kind, kGapKind);
+    }
+}
+
+void DataLogWriter::Loop()
+{
+    std::vector<LogRecord> batch;
+    uint64_t reported = 0;
+    bool stop = false;
+    while (!stop) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait_for(lock, std::chrono::duration<double>(LOG_FLUSH_SEC),
+                            [this]() { return m_Stop || m_Count >= m_Queue.size() / 4; });
+            batch.resize(m_Count);
+            for (size_t i = 0; i < m_Count; i++) batch[i] = m_Queue[(m_Head + i) % m_Queue.size()];
+            m_Head  = (m_Head + m_Count) % m_Queue.size();
+            m_Count = 0;
+            stop = m_Stop;
+        }
+        if (batch.empty()) continue;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const uint64_t dropped = m_Dropped.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < batch.size(); i++) {
+            Serialize(batch[i], (i == 0) ? dropped - reported : 0);
+        }
+        reported = dropped;
+        EndChunk();
+        const bool ok = m_File != nullptr
+                     && std::fwrite(m_Buf.data(), 1, m_Buf.size(), m_File) == m_Buf.size()
+                     && std::fflush(m_File) == 0;
+        m_Buf.clear();
+        (ok ? m_Written : m_Failed).fetch_add(batch.size(), std::memory_order_relaxed);
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (sec > m_WriteMax.load(std::memory_order_relaxed)) m_WriteMax.store(sec, std::memory_order_relaxed);
+    }
+    if (m_File) std::fclose(m_File);
+    m_File = nullptr;
+    bool convert;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Closed = true;
+        convert  = m_Convert;
+        path     = m_Path;
+    }
+    m_ClosedCv.notify_all();
+    if (convert) ConvertLogToTsv(path.c_str(), nullptr);
+}
+
+bool ConvertLogToTsv(const char* path, std::string* err)
+{
+    FILE* in = OpenFile(path, "rb");
+    if (in == nullptr) {
+        if (err) *err = std::string("cannot open ") + path;
+        return false;
+    }
+    std::string base(path);
+    const size_t dot = base.find_last_of('.');
+    const size_t sep = base.find_last_of("\\/");
+    if (dot != std::string::npos && (sep == std::string::npos || dot > sep)) base.erase(dot);
+
+    char magic[4];
+    uint32_t version = 0;
+    bool ok = std::fread(magic, 1, 4, in) == 4 && std::memcmp(magic, "DSLG", 4) == 0
+           && std::fread(&version, sizeof(version), 1, in) == 1 && version == LOG_FILE_VERSION;
+    if (!ok && err) *err = std::string(path) + ": not a DigitShow log";
+
+    FILE* out[3] = {};                  // physical, voltage, param (SaveToFile order)
+    TsvLine line[3];
+    int channels = 0, params = 0;
+    size_t rowBytes = 0;
+    std::vector<char> buf;
+    char tag[4];
+    uint32_t bytes;
+    while (ok && std::fread(tag, 1, 4, in) == 4) {
+        if (std::fread(&bytes, sizeof(bytes), 1, in) != 1) break;
+        buf.resize(bytes);
+        // A chunk cut short by a crash ends the conversion, what came before is kept
+        if (bytes > 0 && std::fread(buf.data(), 1, bytes, in) != bytes) break;
+
+        if (std::memcmp(tag, "HEAD", 4) == 0) {
+            const std::string text(buf.begin(), buf.end());
+            std::string column[3];
+            size_t pos = 0;
+            while (pos < text.size()) {
+                size_t eol = text.find('\n', pos);
+                if (eol == std::string::npos) eol = text.size();
+                const std::string line = text.substr(pos, eol - pos);
+                pos = eol + 1;
+                const size_t tab = line.find('\t');
+                if (tab == std::string::npos) continue;
+                const std::string key = line.substr(0, tab), value = line.substr(tab + 1);
+                if      (key == "channels")  channels = std::atoi(value.c_str());
+                else if (key == "params")    params   = std::atoi(value.c_str());
+                else if (key == "row_bytes") rowBytes = size_t(std::atol(value.c_str()));
+                else if (key == "physical")  column[0] = value;
+                else if (key == "voltage")   column[1] = value;
+                else if (key == "param")     column[2] = value;
+            }
+            ok = channels >= 0 && channels <= LOG_MAX_CHANNELS && params >= 0 && params <= LOG_MAX_PARAMS
+              && rowBytes == RowBytes(channels, params) && out[0] == nullptr;
+            if (!ok) {
+                if (err) *err = std::string(path) + ": invalid header";
+                break;
+            }
+            const char* suffix[3] = { ".tsv", "_v.tsv", "_p.tsv" };
+            for (int f = 0; f < 3 && ok; f++) {
+                out[f] = OpenFile((base + suffix[f]).c_str(), "w");
+                ok = out[f] != nullptr;
+                if (!ok && err) *err = "cannot create " + base + suffix[f];
+                if (ok) std::fprintf(out[f], "%s\n", column[f].c_str());
+            }
+        }
+        else if (std::memcmp(tag, "ROWS", 4) == 0 && out[0] != nullptr) {
+            for (size_t off = 0; off + rowBytes <= buf.size(); off += rowBytes) {
+                const char* p = buf.data() + off;
+                double t;
+                std::memcpy(&t, p, sizeof(t));
+                p += sizeof(t);
+                for (TsvLine& l : line) {
+                    l.Clear();
+                    l.Field(t, TSV_TIME_DECIMALS);
+                }
+                for (int j = 0; j < channels; j++) {
+                    float v;
+                    double y;
+                    std::memcpy(&v, p + j * sizeof(float), sizeof(v));
+                    std::memcpy(&y, p + channels * sizeof(float) + j * sizeof(double), sizeof(y));
+                    line[1].Field(v);
+                    line[0].Field(y);
+                }
+                p += channels * (sizeof(float) + sizeof(double));
+                for (int i = 0; i < params; i++) {
+                    double y;
+                    std::memcpy(&y, p + i * sizeof(double), sizeof(y));
+                    line[2].Field(y);
+                }
+                for (int f = 0; f < 3; f++) {
+                    line[f].End();
+                    line[f].Write(out[f]);
+                }
+            }
+        }
+        else if (std::memcmp(tag, "GAPS", 4) == 0 && out[0] != nullptr) {
+            for (size_t off = 0; off + kGapBytes <= buf.size(); off += kGapBytes) {
+                double start, end;
+                uint64_t lost;
+                char kind[kGapKind + 1] = {};
+                std::memcpy(&start, &buf[off],      sizeof(start));
+                std::memcpy(&end,   &buf[off + 8],  sizeof(end));
+                std::memcpy(&lost,  &buf[off + 16], sizeof(lost));
+                std::memcpy(kind,   &buf[off + 24], kGapKind);
+                line[0].Clear();
+                line[0].Text("#GAP\t");
+                line[0].Field(start, TSV_TIME_DECIMALS);
+                line[0].Field(end, TSV_TIME_DECIMALS);
+                line[0].Unsigned(lost);
+                line[0].Char('\t');
+                line[0].Text(kind);
+                line[0].End();
+                for (FILE* fp : out) line[0].Write(fp);
+            }
+        }
+        // unknown chunks are skipped
+    }
+    std::fclose(in);
+    for (FILE* fp : out) {
+        if (fp) std::fclose(fp);
+    }
+    if (ok && out[0] == nullptr) {
+        if (err) *err = std::string(path) + ": no header";
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,156 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __DATALOG_H_INCLUDE__
+#define __DATALOG_H_INCLUDE__
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DspFilter.h"
+
+#define LOG_MAX_CHANNELS  DSP_MAX_CHANNELS
+#define LOG_MAX_PARAMS    16
+#define LOG_QUEUE_DEPTH   4096  // records between the pipeline and the writer (~7 min at 10 Hz)
+#define LOG_FLUSH_SEC     1.0   // the writer flushes at least this often
+#define LOG_FILE_VERSION  1
+
+/**
+ * Binary data log (*.dslog) written by a background thread.
+ *
+ * SaveToFile() fills one fixed-size LogRecord per row and Push()es it
+ * into a bounded queue without waiting for the disk; the writer thread
+ * appends whatever is queued as chunks and flushes. A full queue drops
+ * the record and the next chunk carries a gap saying how many were lost.
+ * A batch the disk refuses (full, I/O error) is counted in Failed()
+ * instead of Written().
+ *
+ * File layout (little endian):
+ *   "DSLG" u32 version
+ *   chunks: char tag[4], u32 bytes, payload
+ *     HEAD  text, one "key<TAB>value" per line: channels, params,
+ *           row_bytes, the three TSV header lines (voltage, physical,
+ *           param) and free "info" lines (calibration, specimen, ...)
+ *     ROWS  rows of row_bytes: f64 time, f32 raw[channels],
+ *           f64 phy[channels], f64 param[params]
+ *     GAPS  f64 start, f64 end, u64 lost, char kind[24] (NUL padded)
+ * Chunks follow the order of the records, so rows and gaps interleave
+ * as they did in the TSV files. ConvertLogToTsv() regenerates those.
+ */
+
+enum LogRecordKind {
+    LOG_REC_ROW = 0,
+    LOG_REC_GAP = 1,
+};
+
+struct LogRecord {
+    int         Kind;                   // LogRecordKind
+    double      Time;                   // row: time of the row [s]; gap: start
+    double      GapEnd;                 // gap
+    uint64_t    Lost;                   // gap: scans lost
+    const char* GapKind;                // gap: static string (AiFaultLog::KindName)
+    float       Raw[LOG_MAX_CHANNELS];  // row: voltages [V]
+    double      Phy[LOG_MAX_CHANNELS];  // row: calibrated values
+    double      Param[LOG_MAX_PARAMS];  // row: derived parameters
+};
+
+struct LogHeader {
+    int Channels;
+    int Params;
+    std::string VoltageColumns;         // TSV header lines, tab separated, without "\n"
+    std::string PhysicalColumns;
+    std::string ParamColumns;
+    std::vector<std::string> Info;      // "key<TAB>value" lines
+};
+
+class DataLogWriter
+{
+public:
+    DataLogWriter();
+    ~DataLogWriter();
+
+    // Creates the file, writes the header and starts the writer thread
+    bool Open(const char* path, const LogHeader& header, std::string* err);
+
+    // Pipeline side: never blocks on the disk. False if the queue is full.
+    bool Push(const LogRecord& r);
+
+    // Writes what is queued and closes the file on the writer thread, then
+    // (convert) regenerates the TSV files from it. Returns at once; the next
+    // Open() waits for the file to be closed but not for the conversion.
+    void Close(bool convert);
+    // Waits for the writer thread and any conversion still running
+    void Wait();
+    // Waits up to timeoutSec for the file to be complete and closed after
+    // Close() (not for the conversion); true once it is
+    bool WaitClosed(double timeoutSec);
+
+    bool     Active() const   { return m_Active; }
+    uint64_t Written() const  { return m_Written.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const  { return m_Dropped.load(std::memory_order_relaxed); }
+    uint64_t Failed() const   { return m_Failed.load(std::memory_order_relaxed); }   // lost to write errors
+    double   WriteMax() const { return m_WriteMax.load(std::memory_order_relaxed); }  // s per batch
+
+private:
+    DataLogWriter(const DataLogWriter&) = delete;
+    DataLogWriter& operator=(const DataLogWriter&) = delete;
+
+    void Loop();
+    void Retire();
+    void Serialize(const LogRecord& r, uint64_t dropped);
+    void EndChunk();
+
+    FILE*        m_File;
+    std::string  m_Path;
+    int          m_Channels, m_Params;
+    bool         m_Active;              // between Open() and Close() (pipeline side)
+
+    std::vector<LogRecord> m_Queue;     // ring of LOG_QUEUE_DEPTH
+    size_t       m_Head, m_Count;
+    bool         m_Stop, m_Convert;
+    bool         m_Closed;              // writer: file complete and closed
+    std::thread             m_Thread;
+    std::vector<std::thread> m_Converting;  // writers past their file, converting it
+    std::mutex              m_Mutex;
+    std::condition_variable m_Wake;
+    std::condition_variable m_ClosedCv;  // signals m_Closed
+
+    std::vector<char> m_Buf;            // chunks being built by the writer
+    size_t       m_ChunkStart;          // offset of the open chunk's tag, or npos
+    int          m_ChunkKind;
+
+    std::atomic<uint64_t> m_Written;    // records on disk
+    std::atomic<uint64_t> m_Dropped;    // records refused by Push()
+    std::atomic<uint64_t> m_Failed;     // records in batches the disk refused
+    std::atomic<double>   m_WriteMax;
+};
+
+// Regenerates <base>.tsv, <base>_v.tsv and <base>_p.tsv from <base>.dslog
+// in the format SaveToFile() writes them.
+bool ConvertLogToTsv(const char* path, std::string* err);
+
+#endif // __DATALOG_H_INCLUDE__
@@ -24,6 +24,7 @@
 #include "MainFrm.h"
 #include "DigitShowBasicDoc.h"
 #include "DigitShowBasicView.h"
+#include "DataLog.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -68,6 +69,16 @@ BOOL CDigitShowBasicApp::InitInstance()
 {
     AfxEnableControlContainer();
 
+    // "DigitShowBasic /convert a.dslog ...": regenerate the TSV files of
+    // binary logs (e.g. after a crash) and exit
+    if (__argc >= 2 && _stricmp(__argv[1], "/convert") == 0) {
+        for (int i = 2; i < __argc; i++) {
+            std::string err;
+            if (!ConvertLogToTsv(__argv[i], &err)) AfxMessageBox(err.c_str());
+        }
+        return FALSE;
+    }
+
     // 標準的な初期化処理
     // もしこれらの機能を使用せず、実行ファイルのサイズを小さく
     // したければ以下の特定の初期化ルーチンの中から不必要なもの
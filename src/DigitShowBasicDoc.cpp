@@ -20,6 +20,7 @@
 #include    "stdafx.h"
 #include    "DigitShowBasic.h"
 #include    "DigitShowBasicDoc.h"
+#include    "AioSimDevice.h"
 #include    "caio.h"
 #include    "dataconvert.h"
 
@@ -111,95 +112,188 @@ void CDigitShowBasicDoc::OpenBoard()
         return;
     }
 
-    // ── Open AD board (AIO000, always required) ───────────────
-    ret = AioInit("AIO000", &ctx->ad.Id);
+    // ── Filter configuration (AD rate, MA taps, channel chains) ─
+    std::string filterErr;
+    if (!LoadFilterConfig(GetFilterConfigPath(ctx->RigID), &ctx->ai.filterCfg, &filterErr)) {
+        msgStr.Format("フィルタ設定を読み込めません。既定値で続行します。\n%s", filterErr.c_str());
+        AfxMessageBox(msgStr, MB_ICONWARNING | MB_OK);
+    }
+    const FilterConfig& fcfg = ctx->ai.filterCfg;
+    ctx->ai.dsp.SetTaps(fcfg.Ma1Taps, fcfg.Ma2Taps);
+    if (fcfg.ControlMs > 0 || fcfg.SyncControl) ctx->timeSettings.ControlInterval = fcfg.ControlMs;
+    ctx->ai.chainActive = false;
+    for (int ch = 0; ch < AI_MAX_CHANNELS; ch++) {
+        ctx->ai.chain[ch].Build(fcfg.Chain[ch], fcfg.FsHz);
+        if (!ctx->ai.chain[ch].Empty()) ctx->ai.chainActive = true;
+    }
+
+    // ── Select device backend (DIGITSHOW_AIO, default: contec) ─
+    const char* backend = GetAioBackendSpec();
+    ctx->ad.Dev = CreateAioDevice(backend);
+    // Board-less backends drive a simulated DA board; the rig simulator's
+    // DA board feeds the same plant the AD board samples
+    if (CAioPlantDevice* plant = dynamic_cast<CAioPlantDevice*>(ctx->ad.Dev.get())) {
+        ctx->da.Dev.reset(new CAioPlantDevice(plant->Plant(), plant->Speed()));
+        // The plant advances on scan time, at any speed: a control timer on
+        // the wall clock would get the wrong dt, so control runs on scans
+        if (!fcfg.SyncControl) {
+            TRACE("Rig %d: plant backend, control runs in sync mode\n", ctx->RigID + 1);
+            ctx->ai.filterCfg.SyncControl = true;
+        }
+    }
+    else
+        ctx->da.Dev = CreateAioDevice(strcmp(backend, "contec") == 0 ? backend : "sim");
+    if(!ctx->ad.Dev || !ctx->da.Dev){
+        msgStr.Format("AIO バックエンド \"%s\" は使用できません。", backend);
+        AfxMessageBox(msgStr, MB_ICONSTOP | MB_OK);
+        ctx->ad.Dev.reset();
+        ctx->da.Dev.reset();
+        return;
+    }
+
+    // ── Open AD board (first of "boards", AIO000 by default; required) ──
+    ret = ctx->ad.Dev->Init(fcfg.Boards[0].c_str());
     if(ret != 0){
-        ret2 = AioGetErrorString(ret, errStr);
-        msgStr.Format("ADボード (AIO000) の初期化に失敗しました。\nAioInit = %d : %s", ret, errStr);
+        ret2 = ctx->ad.Dev->GetErrorString(ret, errStr);
+        msgStr.Format("Rig %d: ADボード (%s) の初期化に失敗しました。\nAioInit = %d : %s",
+                      ctx->RigID + 1, fcfg.Boards[0].c_str(), ret, errStr);
         AfxMessageBox(msgStr, MB_ICONSTOP | MB_OK);
         return;
     }
-    ret = AioResetDevice(ctx->ad.Id);
+    ret = ctx->ad.Dev->ResetDevice();
     if(ret != 0){
-        ret2 = AioGetErrorString(ret, errStr);
+        ret2 = ctx->ad.Dev->GetErrorString(ret, errStr);
         msgStr.Format("AioResetDevice (AD) = %d : %s", ret, errStr);
         AfxMessageBox(msgStr, MB_ICONSTOP | MB_OK);
-        AioExit(ctx->ad.Id);
+        ctx->ad.Dev->Exit();
         return;
     }
 
-    // ── Open DA board (AIO001, optional) ──────────────────────
-    ret = AioInit("AIO001", &ctx->da.Id);
+    // ── Open DA board ("da", AIO001 by default; optional) ────────
+    ret = ctx->da.Dev->Init(fcfg.DaBoard.c_str());
     if(ret != 0){
         // DA board not found — ask user whether to continue as logger-only
-        int ans = AfxMessageBox(
-            "DAボード (AIO001) が見つかりません。\n"
+        msgStr.Format(
+            "Rig %d: DAボード (%s) が見つかりません。\n"
             "アナログ出力によるフィードバック制御は使用できませんが、\n"
             "ロガーとして動作を続けますか？",
-            MB_ICONWARNING | MB_YESNO);
+            ctx->RigID + 1, fcfg.DaBoard.c_str());
+        int ans = AfxMessageBox(msgStr, MB_ICONWARNING | MB_YESNO);
         if(ans != IDYES){
-            AioExit(ctx->ad.Id);
+            ctx->ad.Dev->Exit();
             return;
         }
         ctx->flags.HasDA = false;
     }
     else{
-        ret = AioResetDevice(ctx->da.Id);
+        ret = ctx->da.Dev->ResetDevice();
         if(ret != 0){
-            ret2 = AioGetErrorString(ret, errStr);
+            ret2 = ctx->da.Dev->GetErrorString(ret, errStr);
             msgStr.Format("AioResetDevice (DA) = %d : %s", ret, errStr);
             AfxMessageBox(msgStr, MB_ICONSTOP | MB_OK);
-            AioExit(ctx->ad.Id);
-            AioExit(ctx->da.Id);
+            ctx->ad.Dev->Exit();
+            ctx->da.Dev->Exit();
             return;
         }
         ctx->flags.HasDA = true;
     }
 
     // ── Configure AD board ────────────────────────────────────
-    ret = AioGetAiInputMethod(ctx->ad.Id, &ctx->ad.InputMethod);
-    ret = AioGetAiResolution (ctx->ad.Id, &ctx->ad.Resolution);
+    ret = ctx->ad.Dev->GetAiInputMethod(&ctx->ad.InputMethod);
+    ret = ctx->ad.Dev->GetAiResolution (&ctx->ad.Resolution);
 
     short physicalChannels = 0;
-    ret = AioGetAiMaxChannels(ctx->ad.Id, &physicalChannels);
+    ret = ctx->ad.Dev->GetAiMaxChannels(&physicalChannels);
     if (physicalChannels < DSP_AD_CHANNELS) {
         msgStr.Format(
             "AD board has only %d channels; %d are required. Aborting.",
             (int)physicalChannels, DSP_AD_CHANNELS);
         AfxMessageBox(msgStr, MB_ICONSTOP | MB_OK);
-        AioExit(ctx->ad.Id);
-        if (ctx->flags.HasDA) AioExit(ctx->da.Id);
+        ctx->ad.Dev->Exit();
+        if (ctx->flags.HasDA) ctx->da.Dev->Exit();
         return;
     }
     ctx->ad.Channels = DSP_AD_CHANNELS;   // clamp to 16
-    ret = AioSetAiChannels(ctx->ad.Id, ctx->ad.Channels);
+    ret = ctx->ad.Dev->SetAiChannels(ctx->ad.Channels);
 
-    ret = AioSetAiRangeAll(ctx->ad.Id, 1);   // ±5 V
-    ret = AioGetAiRange   (ctx->ad.Id, 0, &ctx->ad.Range);
+    ret = ctx->ad.Dev->SetAiRangeAll(1);   // ±5 V
+    ret = ctx->ad.Dev->GetAiRange   (0, &ctx->ad.Range);
     ret = GetRangeValue   (ctx->ad.Range, &ctx->ad.RangeMax, &ctx->ad.RangeMin);
-    ret = AioGetAiMemoryType(ctx->ad.Id, &ctx->ad.MemoryType);
+    ctx->ai.dsp.SetRange(ctx->ad.RangeMax, ctx->ad.RangeMin, ctx->ad.Resolution);
+    ret = ctx->ad.Dev->GetAiMemoryType(&ctx->ad.MemoryType);
 
     // ScanClock: floor(208.33) = 208 µs/ch → slightly above 300 sps/ch
     const float scanClock_us =
-        floorf(1000000.0f / (float(DSP_FS_HZ) * float(DSP_AD_CHANNELS)));
-    ret = AioSetAiScanClock    (ctx->ad.Id, scanClock_us);
-    ret = AioGetAiScanClock    (ctx->ad.Id, &ctx->ad.ScanClock);
-    ret = AioGetAiSamplingClock(ctx->ad.Id, &ctx->ad.SamplingClock);
-    ret = AioGetAiEventSamplingTimes(ctx->ad.Id, &ctx->ad.SamplingTimes);
+        floorf(1000000.0f / (float(fcfg.FsHz) * float(DSP_AD_CHANNELS)));
+    ret = ctx->ad.Dev->SetAiScanClock    (scanClock_us);
+    ret = ctx->ad.Dev->GetAiScanClock    (&ctx->ad.ScanClock);
+    ret = ctx->ad.Dev->GetAiSamplingClock(&ctx->ad.SamplingClock);
+    ret = ctx->ad.Dev->GetAiEventSamplingTimes(&ctx->ad.SamplingTimes);
 
     // Allocate sample buffer exactly once, sized for one event burst
     ctx->ad.Data0.resize(
         static_cast<size_t>(ctx->ad.SamplingTimes) * DSP_AD_CHANNELS);
 
+    // Raw scan ring: absorbs bursts while AD_INPUT() is not being called
+    ctx->ai.ring.Allocate(
+        static_cast<size_t>(fcfg.FsHz) * DSP_RING_SECONDS, DSP_AD_CHANNELS);
+
+    // ── Secondary AD boards ("boards" in the filter config) ──────
+    // Channels are positional (board b = ch 16b..), so stop at the first
+    // board that cannot be opened.
+    ctx->ad.Aux.clear();
+    for (size_t b = 1; b < fcfg.Boards.size(); b++) {
+        std::unique_ptr<AiAuxBoard> aux(new AiAuxBoard);
+        aux->Name = fcfg.Boards[b];
+        aux->Dev  = CreateAioDevice(backend);
+        if (CAioReplayDevice* replay = dynamic_cast<CAioReplayDevice*>(aux->Dev.get()))
+            replay->SetFirstChannel(DSP_AD_CHANNELS * int(b));     // its columns of a multi-board capture
+        short auxChannels = 0;
+        ret = aux->Dev->Init(aux->Name.c_str());
+        if (ret == 0) ret = aux->Dev->ResetDevice();
+        if (ret == 0) ret = aux->Dev->GetAiMaxChannels(&auxChannels);
+        if (ret != 0 || auxChannels < DSP_AD_CHANNELS) {
+            if (ret != 0) ret2 = aux->Dev->GetErrorString(ret, errStr);
+            msgStr.Format("ADボード (%s) を使用できません。ch%d 以降なしで続行します。\nAIO = %d : %s",
+                          aux->Name.c_str(), int(DSP_AD_CHANNELS * b), ret, ret != 0 ? errStr : "channels");
+            AfxMessageBox(msgStr, MB_ICONWARNING | MB_OK);
+            aux->Dev->Exit();
+            break;
+        }
+        short auxResolution = 0, auxRange = 0;
+        float auxMax = 0.0f, auxMin = 0.0f;
+        ret = aux->Dev->GetAiResolution(&auxResolution);
+        ret = aux->Dev->SetAiChannels(DSP_AD_CHANNELS);
+        ret = aux->Dev->SetAiRangeAll(1);   // ±5 V
+        ret = aux->Dev->GetAiRange(0, &auxRange);
+        ret = GetRangeValue(auxRange, &auxMax, &auxMin);
+        ret = aux->Dev->SetAiScanClock(scanClock_us);
+        memset(&aux->dsp, 0, sizeof(aux->dsp));
+        aux->dsp.SetMode(DspMode(ctx->ai.dsp.mode));
+        aux->dsp.SetTaps(fcfg.Ma1Taps, fcfg.Ma2Taps);
+        aux->dsp.SetRange(auxMax, auxMin, auxResolution);
+        aux->ring.Allocate(
+            static_cast<size_t>(fcfg.FsHz) * DSP_RING_SECONDS, DSP_AD_CHANNELS);
+        ctx->ad.Aux.push_back(std::move(aux));
+    }
+    ctx->ai.channels = DSP_AD_CHANNELS * int(1 + ctx->ad.Aux.size());
+
+    // Filtered history for control / logging / display readers
+    ctx->ai.history.Allocate(fcfg.FsHz, ctx->ai.channels);
+    ctx->ai.scanCount = 0;
+
     // ── Configure DA board ────────────────────────────────────
     if (ctx->flags.HasDA) {
-        ret = AioGetAoResolution (ctx->da.Id, &ctx->da.Resolution);
+        ret = ctx->da.Dev->GetAoResolution (&ctx->da.Resolution);
         short daPhys = 0;
-        ret = AioGetAoMaxChannels(ctx->da.Id, &daPhys);
+        ret = ctx->da.Dev->GetAoMaxChannels(&daPhys);
         ctx->da.Channels = (daPhys > DSP_DA_CHANNELS) ? DSP_DA_CHANNELS : daPhys;
-        ret = AioSetAoRangeAll(ctx->da.Id, 50);   // 0–10 V
-        ret = AioGetAoRange   (ctx->da.Id, 0, &ctx->da.Range);
+        ret = ctx->da.Dev->SetAoRangeAll(50);   // 0–10 V
+        ret = ctx->da.Dev->GetAoRange   (0, &ctx->da.Range);
         ret = GetRangeValue   (ctx->da.Range, &ctx->da.RangeMax, &ctx->da.RangeMin);
+        for (int ch = 0; ch < DA_OUT_CHANNELS; ch++) ctx->da.Out.SetLimits(ch, fcfg.DaLimits[ch]);
+        ctx->da.Out.Attach(ctx->da.Dev.get(), ctx->da.Channels,
+                           ctx->da.RangeMax, ctx->da.RangeMin, ctx->da.Resolution);
     }
     ctx->flags.SetBoard = TRUE;
     return;
@@ -211,82 +305,209 @@ void CDigitShowBasicDoc::CloseBoard()
     long ret = 0;
     // Close A/D and D/A board to end the application 
     if( ctx->flags.SetBoard==TRUE ){
-        ret = AioExit(ctx->ad.Id);
-        if(ctx->flags.HasDA)  ret = AioExit(ctx->da.Id);
+        ctx->ai.worker.Stop();
+        ctx->ai.capture.Close();
+        for (auto& aux : ctx->ad.Aux) {
+            aux->worker.Stop();
+            aux->Dev->StopAi();
+            aux->Dev->Exit();
+        }
+        ret = ctx->ad.Dev->Exit();
+        ctx->da.Out.Detach();
+        if(ctx->flags.HasDA)  ret = ctx->da.Dev->Exit();
+    }
+}
+
+//--- Periodic pipeline steps -----------------------------------------------
+// Rig 0 runs acquire/save from the view's WM_TIMER 1/3, the other rigs from
+// their RigRunner thread; control runs on each rig's ctrlLoop thread. All
+// of them work on the rig bound to the calling thread, under its lock.
+
+// Display rate: drain the AD ring and refresh ai.raw / phy / param
+void CDigitShowBasicDoc::AcquireTick()
+{
+    DigitShowContext* ctx = GetContext();
+    ctx->NowTime = ctx->NowTime.GetCurrentTime();
+    ctx->SNowTime = ctx->NowTime.Format("%m/%d  %H:%M:%S");
+    if(ctx->flags.SaveData){
+        ctx->SpanTime = ctx->NowTime- ctx->StartTime;
+        ctx->SequentTime1 = (long)ctx->SpanTime.GetTotalSeconds();
+    }
+    if(ctx->flags.SetBoard)    AD_INPUT();
+    Cal_Physical();
+    Cal_Param();
+    // Without control, manual DA settings still ramp at their slew limits
+    if(ctx->flags.HasDA && !ctx->flags.CtrlRun)
+        ctx->da.Out.Service(ctx->timeSettings.DisplayInterval / 1000.0);
+}
+
+// Control rate (ctrlLoop thread, timer mode): act on samples band-limited
+// to the control rate; dt is whole loop periods, so the laws integrate exactly
+void CDigitShowBasicDoc::ControlTick(double dt)
+{
+    DigitShowContext* ctx = GetContext();
+    if(ctx->flags.SetBoard){
+        AD_INPUT();
+        ControlStep(dt, ctx->ai.ctrlDec.Output());
+    }
+    else{
+        ctx->flags.Ctrl = TRUE;
+        ctx->CtrlStepTime = dt;
+    }
+}
+
+// One evaluation of the control law on the voltages raw[], DA written in
+// the same pass. Timer mode: from ControlTick(); sync mode: from AD_INPUT()
+// for every decimated scan, dt = decimation × scan period.
+void CDigitShowBasicDoc::ControlStep(double dt, const float* raw)
+{
+    DigitShowContext* ctx = GetContext();
+    // The first step comes one period after Ctrl On, so dt counts from there
+    ctx->flags.Ctrl = TRUE;
+    ctx->CtrlStepTime = dt;
+    Cal_Physical(raw);
+    Cal_Param();
+    AnalyzeCycle();
+    Control_DA();
+    if (ctx->flags.HasDA) ctx->da.Out.Service(dt);
+}
+
+// Logging rate: with a board the rows come from AD_INPUT(), one per output
+// of ai.saveDec (SaveRow), so the timer only drains the ring in between;
+// without one a row is written per tick, stamped by the wall clock
+void CDigitShowBasicDoc::SaveTick()
+{
+    DigitShowContext* ctx = GetContext();
+    if(ctx->flags.SetBoard){
+        AD_INPUT();
+        return;
     }
+    _ftime_s(&ctx->NowTime2);
+    ctx->SequentTime2 = double(ctx->NowTime2.time-ctx->StartTime2.time)+double( (ctx->NowTime2.millitm-ctx->StartTime2.millitm)/1000.0 );
+    Cal_Physical();
+    Cal_Param();
+    SaveToFile();
+}
+
+// One logged row per decimated sample: time = its window centre. Outputs
+// up to the first row (written by Start Save) are not logged again.
+void CDigitShowBasicDoc::SaveRow()
+{
+    DigitShowContext* ctx = GetContext();
+    const double t = ctx->ai.saveDec.OutputTime() - ctx->ai.saveTime0;
+    if (t <= 0.0) return;
+    ctx->SequentTime2 = t;
+    Cal_Physical(ctx->ai.saveDec.Output());
+    Cal_Param();
+    SaveToFile();
 }
 
 //--- Input from A/D Board (20Hz-B: cascaded MA5 × MA6 @ 300 sps) ---
+// Drains every scan queued in ai.ring since the previous call, so no burst
+// is lost when timer 1/3 is delayed (e.g. while a modal dialog is open).
 void CDigitShowBasicDoc::AD_INPUT()
 {
     DigitShowContext* ctx = GetContext();
     if (!ctx->flags.SetBoard) return;
 
-    const int   N1   = DSP_MA1_TAPS;          // 5
-    const int   N2   = DSP_MA2_TAPS;          // 6
-    const float inv1 = 1.0f / float(N1);
-    const float inv2 = 1.0f / float(N2);
-    const int   nCh  = ctx->ad.Channels;   // always DSP_AD_CHANNELS = 16
-
-    const long nScans = ctx->ad.LastDataCount;
-    if (nScans <= 0) return;
-
+    // MA5×MA6 over all 16 channels of each scan (SIMD kernel, see DspFilter.cpp);
+    // every filtered scan also goes to the history, stamped by ai.clock.
+    // Secondary boards are merged by time: master scan m takes the scan of
+    // each board within half a scan period of it (HostTime, drift-corrected),
+    // waits up to DSP_AUX_WAIT_SECONDS for it, else holds the last value.
     DspFilter& d = ctx->ai.dsp;
+    const double scanPeriod = ctx->ad.SamplingClock * 1e-6;   // s/scan
+
+    // Decimators follow the current control/logging intervals (at least one scan)
+    if (scanPeriod > 0.0) {
+        const double ctrlSec = ctx->timeSettings.ControlInterval / 1000.0;
+        ctx->ai.ctrlDec.Configure(1.0 / scanPeriod, (ctrlSec > scanPeriod) ? ctrlSec : scanPeriod,
+                                  ctx->ai.channels, DSP_CTRL_DEC_WINDOWS);
+        ctx->ai.saveDec.Configure(1.0 / scanPeriod, ctx->timeSettings.SaveInterval / 1000.0,
+                                  ctx->ai.channels, DSP_SAVE_DEC_WINDOWS);
+    }
+    // Sync control: the control law is a stage of this loop, so actuation
+    // follows a scan by the filter group delay, not by a timer period
+    const bool   syncCtrl = ctx->ai.filterCfg.SyncControl && ctx->flags.CtrlRun;
+    const size_t nAux    = ctx->ad.Aux.size();
+    const double half    = 0.5 * scanPeriod;
+    const size_t pending = ctx->ai.ring.Pending();
+    size_t done = 0;
+    for (; done < pending; done++) {
+        const long* aux[DSP_MAX_BOARDS] = {};
+        if (nAux > 0) {
+            const double tm = ctx->ai.clock.HostTime(ctx->ai.scanCount);
+            bool wait = false;
+            for (size_t b = 0; b < nAux && !wait; b++) {
+                AiAuxBoard& x = *ctx->ad.Aux[b];
+                while (x.ring.Pending() > 0 && x.clock.HostTime(x.ring.Consumed()) < tm - half)
+                    x.ring.Release(1);      // older than this master scan: no partner
+                if (x.ring.Pending() > 0) {
+                    if (x.clock.HostTime(x.ring.Consumed()) <= tm + half) aux[b] = x.ring.Peek(0);
+                }
+                else if (x.worker.Running()
+                      && ctx->ai.clock.HostNow() - tm < DSP_AUX_WAIT_SECONDS) {
+                    wait = true;            // not delivered yet
+                }
+            }
+            if (wait) break;
+        }
 
-    for (long scan = 0; scan < nScans; scan++) {
-        for (int ch = 0; ch < nCh; ch++) {
-            // Raw ADC value — 16-ch layout: Data0[scan * nCh + ch]
-            float raw = BinaryToVolt(
-                ctx->ad.RangeMax, ctx->ad.RangeMin,
-                ctx->ad.Resolution,
-                ctx->ad.Data0[nCh * scan + ch]);
-
-            // Stage 1: MA(5) — 60 Hz notch
-            int   i1   = d.ma1_idx[ch];
-            float old1 = d.ma1_buf[ch][i1];
-            d.ma1_sum[ch] += raw - old1;
-            d.ma1_buf[ch][i1] = raw;
-            d.ma1_idx[ch] = (i1 + 1 >= N1) ? 0 : i1 + 1;
-            float out1 = float(d.ma1_sum[ch] * inv1);
-
-            // Stage 2: MA(6) — 50 Hz notch
-            int   i2   = d.ma2_idx[ch];
-            float old2 = d.ma2_buf[ch][i2];
-            d.ma2_sum[ch] += out1 - old2;
-            d.ma2_buf[ch][i2] = out1;
-            d.ma2_idx[ch] = (i2 + 1 >= N2) ? 0 : i2 + 1;
-
-            // Output: latest filtered value for this channel
-            ctx->ai.raw[ch] = float(d.ma2_sum[ch] * inv2);
+        d.Process(ctx->ai.ring.Peek(done), ctx->ai.raw);
+        for (size_t b = 0; b < nAux; b++) {
+            if (aux[b] == NULL) continue;
+            ctx->ad.Aux[b]->dsp.Process(aux[b], ctx->ai.raw + DSP_AD_CHANNELS * (b + 1));
+            if (ctx->ai.capture.Active())
+                memcpy(ctx->ai.captureCodes + DSP_AD_CHANNELS * (b + 1), aux[b], DSP_AD_CHANNELS * sizeof(long));
+            ctx->ad.Aux[b]->ring.Release(1);
+        }
+        if (ctx->ai.chainActive) {
+            // Optional per-channel stages; decimating chains hold their last output
+            for (int ch = 0; ch < ctx->ai.channels; ch++) {
+                double y;
+                if (!ctx->ai.chain[ch].Empty() && ctx->ai.chain[ch].Process(ctx->ai.raw[ch], &y))
+                    ctx->ai.raw[ch] = float(y);
+            }
         }
+        const double t = ctx->ai.clock.ScanTime(ctx->ai.scanCount);
+        if (ctx->ai.capture.Active()) {
+            // All boards as the filter paired them; a board without a partner scan repeats its last codes
+            memcpy(ctx->ai.captureCodes, ctx->ai.ring.Peek(done), DSP_AD_CHANNELS * sizeof(long));
+            ctx->ai.capture.Push(ctx->ai.scanCount, t, ctx->ai.captureCodes);
+        }
+        ctx->ai.history.Append(t, ctx->ai.raw);
+        if (ctx->ai.ctrlDec.Push(t, ctx->ai.raw) && syncCtrl)
+            ControlStep(ctx->ai.ctrlDec.Factor() * scanPeriod, ctx->ai.ctrlDec.Output());
+        if (ctx->ai.saveDec.Push(t, ctx->ai.raw) && ctx->flags.SaveData)
+            SaveRow();
+        ctx->ai.scanCount++;
     }
+    ctx->ai.ring.Release(done);
 }
 
 //--- Output to D/A Board ---
+// ao.raw is clamped in place to the channel limits ("daout" in the filter
+// config); the board is written only if a code changed. Slew-limited
+// channels move on at Service(dt) from ControlStep() / AcquireTick().
 void CDigitShowBasicDoc::DA_OUTPUT()
 {
     DigitShowContext* ctx = GetContext();
-    long ret = 0;
     if (!ctx->flags.HasDA) return;
 
-    const int nCh = ctx->da.Channels;   // clamped to DSP_DA_CHANNELS = 8
-    for (int j = 0; j < nCh; j++) {
-        if (ctx->ao.raw[j] < 0.0f)     ctx->ao.raw[j] = 0.0f;
-        if (ctx->ao.raw[j] > 9.9999f)  ctx->ao.raw[j] = 9.9999f;
-        ctx->da.Data[j] = VoltToBinary(
-            ctx->da.RangeMax, ctx->da.RangeMin,
-            ctx->da.Resolution, ctx->ao.raw[j]);
-    }
-    ret = AioMultiAo(ctx->da.Id, nCh, &ctx->da.Data[0]);
+    ctx->da.Out.Request(ctx->ao.raw);
+    ctx->da.Out.Service(0.0);
 }
 
 //--- Calcuration of Physical Value ---
-void CDigitShowBasicDoc::Cal_Physical()
+void CDigitShowBasicDoc::Cal_Physical(const float* raw)
 {
     DigitShowContext* ctx = GetContext();
-    for(int i = 0;i<AI_MAX_CHANNELS;i++){
-        ctx->ai.phy[i] = ctx->ai.cal.a[i] * ctx->ai.raw[i] * ctx->ai.raw[i]
-                       + ctx->ai.cal.b[i] * ctx->ai.raw[i]
+    // raw: voltages to use (decimated control/log samples); NULL = latest ai.raw
+    // (decimator outputs hold ai.channels values, not AI_MAX_CHANNELS)
+    if (raw == NULL) raw = ctx->ai.raw;
+    for(int i = 0;i<ctx->ai.channels;i++){
+        ctx->ai.phy[i] = ctx->ai.cal.a[i] * raw[i] * raw[i]
+                       + ctx->ai.cal.b[i] * raw[i]
                        + ctx->ai.cal.c[i];
     }
 }
@@ -362,22 +583,106 @@ void CDigitShowBasicDoc::Cal_Param()
 void CDigitShowBasicDoc::SaveToFile()
 {
     DigitShowContext* ctx = GetContext();
-    fprintf(ctx->fpVoltage,  "%.3lf\t", ctx->SequentTime2);
-    fprintf(ctx->fpPhysical, "%.3lf\t", ctx->SequentTime2);
+    // Voltages band-limited to the logging rate (same samples Cal_Physical used)
+    const float* raw = ctx->ai.saveDec.Configured() ? ctx->ai.saveDec.Output() : ctx->ai.raw;
+
+    // Intervals without data since the previous row, in the same time base
+    std::vector<AiFaultEvent> gaps;
+    ctx->ai.faults.TakeGaps(&gaps);
+
+    // Binary log: the record is queued, the writer thread does the disk
+    if (ctx->log.Active()) {
+        LogRecord r;
+        for (const AiFaultEvent& g : gaps) {
+            r.Kind    = LOG_REC_GAP;
+            r.Time    = g.GapStart - ctx->ai.saveTime0;
+            r.GapEnd  = g.GapEnd - ctx->ai.saveTime0;
+            r.Lost    = g.Lost;
+            r.GapKind = AiFaultLog::KindName(g.Kind);
+            ctx->log.Push(r);
+        }
+        r.Kind = LOG_REC_ROW;
+        r.Time = ctx->SequentTime2;
+        for (int j = 0; j < ctx->ai.channels; j++) {
+            r.Raw[j] = raw[j];
+            r.Phy[j] = ctx->ai.phy[j];
+        }
+        for (int i = 0; i < AI_NUM_PARAMS; i++) r.Param[i] = ctx->ai.param[i];
+        ctx->log.Push(r);
+        return;
+    }
+
+    // Each file gets its gap lines and row as one write ("%.3lf" time, "%lf" values)
+    TsvLine& voltage  = ctx->tsvLine[0];
+    TsvLine& physical = ctx->tsvLine[1];
+    TsvLine& param    = ctx->tsvLine[2];
+    voltage.Clear();
+    for (const AiFaultEvent& g : gaps) {
+        voltage.Text("#GAP\t");
+        voltage.Field(g.GapStart - ctx->ai.saveTime0, TSV_TIME_DECIMALS);
+        voltage.Field(g.GapEnd - ctx->ai.saveTime0, TSV_TIME_DECIMALS);
+        voltage.Unsigned(g.Lost);
+        voltage.Char('\t');
+        voltage.Text(AiFaultLog::KindName(g.Kind));
+        voltage.End();
+    }
+    physical.Clear();
+    param.Clear();
+    physical.Text(voltage.Data(), voltage.Size());
+    param.Text(voltage.Data(), voltage.Size());
+    voltage.Field(ctx->SequentTime2, TSV_TIME_DECIMALS);
+    physical.Field(ctx->SequentTime2, TSV_TIME_DECIMALS);
+    param.Field(ctx->SequentTime2, TSV_TIME_DECIMALS);
+
+    // All AD boards, 16 channels each
+    for (int j = 0; j < ctx->ai.channels; j++) {
+        voltage.Field(raw[j]);
+        physical.Field(ctx->ai.phy[j]);
+    }
+    for (int i = 0; i < AI_NUM_PARAMS; i++) param.Field(ctx->ai.param[i]);
+    voltage.End();
+    physical.End();
+    param.End();
+    voltage.Write(ctx->fpVoltage);
+    physical.Write(ctx->fpPhysical);
+    param.Write(ctx->fpParam);
+}
 
-    // Single AD board, all DSP_AD_CHANNELS channels
-    for (int j = 0; j < ctx->ad.Channels; j++) {
-        fprintf(ctx->fpVoltage,  "%lf\t", ctx->ai.raw[j]);
-        fprintf(ctx->fpPhysical, "%lf\t", ctx->ai.phy[j]);
+//--- Hysteresis of cyclic loading ---
+// Control modes 5/6 and cyclic control-file steps (cyclic_stress,
+// cyclic_strain, wave): every control sample goes to the cycle analyzer,
+// which restarts when the mode or step changes. A completed cycle is a
+// row of *_c.tsv while logging; DA, ru, Esec and damping are also "until"
+// quantities of the control script.
+void CDigitShowBasicDoc::AnalyzeCycle()
+{
+    DigitShowContext* ctx = GetContext();
+    const int id  = ctx->ControlID;
+    const int num = ctx->controlFile.CurrentNum;
+    bool cyclic = (id == 5 || id == 6);
+    if( id == 15 && num >= 0 && num < (int)ctx->program.Steps.size() ){
+        const int type = ctx->program.Steps[num].Type;
+        cyclic = (type == CTL_STEP_CLOADING_STRESS || type == CTL_STEP_CLOADING_STRAIN
+               || type == CTL_STEP_WAVE);
+    }
+    const int key = cyclic ? id*1000 + (id == 15 ? num : 0) : -1;
+    CycleAnalyzer& a = ctx->cycle.Analyzer;
+    if( key != ctx->cycle.Key ){
+        ctx->cycle.Key = key;
+        a.SetBand(ctx->ai.filterCfg.CycleBand);
+        a.Reset();
     }
-    fprintf(ctx->fpVoltage,  "\n");
-    fprintf(ctx->fpPhysical, "\n");
+    if( key < 0 ) return;
 
-    fprintf(ctx->fpParam, "%.3lf\t", ctx->SequentTime2);
-    for (int i = 0; i < AI_MAX_CHANNELS; i++) {
-        fprintf(ctx->fpParam, "%lf\t", ctx->ai.param[i]);
+    // Time of the control sample, on the time base of the log rows
+    const double t = ctx->ai.ctrlDec.OutputTime() - ctx->ai.saveTime0;
+    if( !a.Push(t, ctx->phys.q, ctx->phys.ea, ctx->phys.u, ctx->phys.e_p) ) return;
+    if( ctx->flags.SaveData && ctx->fpCycle != nullptr ){
+        const CycleResult& r = a.Last();
+        fprintf(ctx->fpCycle, "%d\t%.3lf\t%.3lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\n",
+                r.Cycle, r.TimeStart, r.TimeEnd, r.QMax, r.QMin, r.EaAtQMax, r.EaAtQMin,
+                r.DoubleAmplitude, r.SecantModulus, r.Damping, r.Ru, r.RuMax);
     }
-    fprintf(ctx->fpParam, "\n");
 }
 
 //--- Control Statements ---
@@ -386,6 +691,8 @@ void CDigitShowBasicDoc::Control_DA()
     DigitShowContext* ctx = GetContext();
     auto ControlData = ctx->control;
 
+    UpdateControlProgram();
+    SetupPid();
     switch (ctx->ControlID)
     {
     case 0:
@@ -423,6 +730,7 @@ void CDigitShowBasicDoc::Control_DA()
                     ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
                     // RPM->0
             }
+            MotorPid(0.0, ctx->phys.q, -ControlData[1].MotorSpeed, ControlData[1].MotorSpeed);
             DA_OUTPUT();
         }
         break;
@@ -437,10 +745,10 @@ void CDigitShowBasicDoc::Control_DA()
             // Motor: On
             ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ControlData[2].MotorSpeed+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
             if( ctx->phys.e_sr < ControlData[2].e_sigma[0]*ControlData[2].K0-ctx->errTol.StressA){
-                ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(ctx->ao.cal.a[DA_CH_EP_CELL]*ControlData[2].sigmaRate[2]/60.0*ctx->timeSettings.ControlInterval/1000.0);
+                ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(ctx->ao.cal.a[DA_CH_EP_CELL]*ControlData[2].sigmaRate[2]/60.0*ctx->CtrlStepTime);
             }    
             if( ctx->phys.e_sr > ControlData[2].e_sigma[0]*ControlData[2].K0+ctx->errTol.StressA){
-                ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-float(ctx->ao.cal.a[DA_CH_EP_CELL]*ControlData[2].sigmaRate[2]/60.0*ctx->timeSettings.ControlInterval/1000.0);
+                ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-float(ctx->ao.cal.a[DA_CH_EP_CELL]*ControlData[2].sigmaRate[2]/60.0*ctx->CtrlStepTime);
             }    
             if( ctx->phys.e_sa < ctx->phys.e_sr/ControlData[2].K0+ctx->errTol.StressExt ){
                 ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
@@ -454,6 +762,8 @@ void CDigitShowBasicDoc::Control_DA()
                 ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
                 // RPM->0
             }
+            CellPid(ControlData[2].e_sigma[0]*ControlData[2].K0, ControlData[2].sigmaRate[2], ctx->phys.e_sr);
+            MotorPid(ctx->phys.e_sr/ControlData[2].K0, ctx->phys.e_sa, -ControlData[2].MotorSpeed, ControlData[2].MotorSpeed);
             DA_OUTPUT();
         }
         break;
@@ -685,7 +995,7 @@ void CDigitShowBasicDoc::Control_DA()
                     ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-float(0.2*ctx->ao.cal.a[DA_CH_EP_CELL]*(ctx->phys.e_sr-ControlData[7].e_sigma[1]));
                 }
                 if( ctx->phys.e_sr < ControlData[7].e_sigma[1]) {
-                    ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(ctx->ao.cal.a[DA_CH_EP_CELL]*fabs(ControlData[7].sigmaRate[0])/60.0*ctx->timeSettings.ControlInterval/1000.0);
+                    ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(ctx->ao.cal.a[DA_CH_EP_CELL]*fabs(ControlData[7].sigmaRate[0])/60.0*ctx->CtrlStepTime);
                 }
                 if( ctx->phys.e_sa > (ControlData[7].e_sigma[0]-ControlData[7].sigma[0])/(ControlData[7].e_sigma[1]-ControlData[7].sigma[1])*(ctx->phys.e_sr-ControlData[7].sigma[1])+ControlData[7].sigma[0]+ctx->errTol.StressCom){
                     ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
@@ -702,7 +1012,7 @@ void CDigitShowBasicDoc::Control_DA()
             }
             if(ControlData[7].sigma[1] > ControlData[7].e_sigma[1]){
                 if( ctx->phys.e_sr > ControlData[7].e_sigma[1]) {
-                    ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-float(ctx->ao.cal.a[DA_CH_EP_CELL]*fabs(ControlData[7].sigmaRate[0])/60.0*ctx->timeSettings.ControlInterval/1000.0);
+                    ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-float(ctx->ao.cal.a[DA_CH_EP_CELL]*fabs(ControlData[7].sigmaRate[0])/60.0*ctx->CtrlStepTime);
                 }
                 if( ctx->phys.e_sr <= ControlData[7].e_sigma[1]) {
                     ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(0.2*ctx->ao.cal.a[DA_CH_EP_CELL]*(ControlData[7].e_sigma[1]- ctx->phys.e_sr));
@@ -720,6 +1030,15 @@ void CDigitShowBasicDoc::Control_DA()
                     // RPM -> 0
                 }
             }
+            // PID: cell pressure ramps to e_sigma[1], the axial stress follows the path
+            CellPid(ControlData[7].e_sigma[1], fabs(ControlData[7].sigmaRate[0]), ctx->phys.e_sr);
+            if(ControlData[7].sigma[1] == ControlData[7].e_sigma[1]){
+                MotorPid(ControlData[7].e_sigma[0], ctx->phys.e_sa, -ControlData[7].MotorSpeed, ControlData[7].MotorSpeed);
+            }
+            else {
+                MotorPid((ControlData[7].e_sigma[0]-ControlData[7].sigma[0])/(ControlData[7].e_sigma[1]-ControlData[7].sigma[1])*(ctx->phys.e_sr-ControlData[7].sigma[1])+ControlData[7].sigma[0],
+                         ctx->phys.e_sa, -ControlData[7].MotorSpeed, ControlData[7].MotorSpeed);
+            }
             DA_OUTPUT();
         }
         break;
@@ -760,231 +1079,373 @@ void CDigitShowBasicDoc::Control_DA()
         break;
     case 15:
         { 
-            if( ctx->controlFile.CurrentNum >=0 && ctx->controlFile.CurrentNum < 128 ){
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==0 ){
-                    ctx->ao.raw[DA_CH_MOTOR] = 0.0f;
-                }
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==1 )    MLoading_Stress();
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==2 )    MLoading_Strain();
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==3 )    CLoading_Stress();
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==4 )    CLoading_Strain();
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==5 )    Creep();
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==6 )    LinearEffectiveStressPath();
-                if( ctx->controlFile.Num[ctx->controlFile.CurrentNum]==7 )    Creep2();
-                DA_OUTPUT();
-            }
+            RunControlProgram();
         }
         break;
     }
 }
 void CDigitShowBasicDoc::Start_Control()
 {
+    DigitShowContext* ctx = GetContext();
+    ctx->pid.Key = -1;
+    // PID loops restart bumplessly at the next control step
+    ctx->cycle.Key = -1;
+    // cycle analysis restarts with the control
+    ctx->program.Revision = -1;
+    // control file recompiled with the present DA calibration
+}
+
+// Recompile the control file after it was read or edited
+void CDigitShowBasicDoc::UpdateControlProgram()
+{
+    DigitShowContext* ctx = GetContext();
+    if( ctx->program.Revision == ctx->controlFile.Revision ) return;
+
+    ControlDaCal cal;
+    cal.SpeedGain   = ctx->ao.cal.a[DA_CH_MOTOR_SPEED];
+    cal.SpeedOffset = ctx->ao.cal.b[DA_CH_MOTOR_SPEED];
+    cal.CellGain    = ctx->ao.cal.a[DA_CH_EP_CELL];
+    std::string err;
+    CompileControlProgram(ctx->controlFile, cal, &ctx->program, &err);
+    // invalid steps run as motor off; CControl_File reports them
+    ctx->pid.Key = -1;
+}
+
+// Control mode 15: run the current step of the compiled control file
+void CDigitShowBasicDoc::RunControlProgram()
+{
+    typedef void (CDigitShowBasicDoc::*StepFn)(const ControlFileStep&);
+    static const StepFn kStep[CTL_STEP_TYPES] = {
+        &CDigitShowBasicDoc::MotorOff,                  // 0
+        &CDigitShowBasicDoc::MLoading_Stress,           // 1
+        &CDigitShowBasicDoc::MLoading_Strain,           // 2
+        &CDigitShowBasicDoc::CLoading_Stress,           // 3
+        &CDigitShowBasicDoc::CLoading_Strain,           // 4
+        &CDigitShowBasicDoc::Creep,                     // 5
+        &CDigitShowBasicDoc::LinearEffectiveStressPath, // 6
+        &CDigitShowBasicDoc::Creep2,                    // 7
+        &CDigitShowBasicDoc::WaveLoading,               // 8
+        &CDigitShowBasicDoc::StrainRateLoading,         // 9
+    };
+    DigitShowContext* ctx = GetContext();
+    const int n = ctx->controlFile.CurrentNum;
+    if( n < 0 || n >= (int)ctx->program.Steps.size() ) return;
+    const ControlFileStep& s = ctx->program.Steps[n];
+    (this->*kStep[s.Type])(s);
+    if( ctx->controlFile.CurrentNum == n ){
+        for( size_t c = 0; c < s.Until.size(); c++ ){
+            if( s.Until[c].Met(StepQuantity(s.Until[c].Quantity)) ){
+                AdvanceStep();
+                break;
+            }
+        }
+    }
+    DA_OUTPUT();
+}
+
+// Quantity of a control-script "until" condition
+double CDigitShowBasicDoc::StepQuantity(int q)
+{
+    DigitShowContext* ctx = GetContext();
+    switch( q ){
+    case CTL_Q_SA:      return ctx->phys.sa;
+    case CTL_Q_E_SA:    return ctx->phys.e_sa;
+    case CTL_Q_SR:      return ctx->phys.sr;
+    case CTL_Q_E_SR:    return ctx->phys.e_sr;
+    case CTL_Q_P:       return ctx->phys.p;
+    case CTL_Q_E_P:     return ctx->phys.e_p;
+    case CTL_Q_Q:       return ctx->phys.q;
+    case CTL_Q_U:       return ctx->phys.u;
+    case CTL_Q_EA:      return ctx->phys.ea;
+    case CTL_Q_ER:      return ctx->phys.er;
+    case CTL_Q_EV:      return ctx->phys.ev;
+    case CTL_Q_ELDT:    return ctx->phys.eLDT;
+    case CTL_Q_TIME:    return ctx->TotalStepTime;
+    case CTL_Q_ELAPSED: return ctx->SequentTime2;
+    case CTL_Q_CYCLE:   return ctx->NumCyclic;
+    case CTL_Q_DA:      return ctx->cycle.Analyzer.DoubleAmplitude();
+    case CTL_Q_RU:      return ctx->cycle.Analyzer.Ru();
+    case CTL_Q_ESEC:    return ctx->cycle.Analyzer.Last().SecantModulus;
+    case CTL_Q_DAMPING: return ctx->cycle.Analyzer.Last().Damping;
+    }
+    return 0.0;
+}
+
+//--- PID loops (ai.filterCfg "pid" directive) ---
+// (Re)configure the motor and cell PIDs when the control ID or the
+// control-file step changes. A control-file step with any of
+// Para[6..9] != 0 enables its own PID with Kp, Ki, Kd, Kff from those
+// (motor for Creep / Creep2, cell for LinearEffectiveStressPath); Tf,
+// slew, dead band and limit still come from "pid ... 15". Gains from a
+// *.ctl table count only if "pid ... 15" enables that PID: older files
+// may hold stray values in those columns.
+void CDigitShowBasicDoc::SetupPid()
+{
+    DigitShowContext* ctx = GetContext();
+    const int id  = ctx->ControlID;
+    const int num = ctx->controlFile.CurrentNum;
+    const int key = id*1000 + (id == 15 ? num : 0);
+    if( key == ctx->pid.Key ) return;
+    ctx->pid.Key = key;
+
+    PidParams motor, cell;
+    SetDefaultPidParams(&motor);
+    SetDefaultPidParams(&cell);
+    if( id >= 0 && id < PID_CONTROL_IDS ){
+        motor = ctx->ai.filterCfg.MotorPid[id];
+        cell  = ctx->ai.filterCfg.CellPid[id];
+    }
+    if( id == 15 && num >= 0 && num < (int)ctx->program.Steps.size() ){
+        const ControlFileStep& s = ctx->program.Steps[num];
+        PidParams* step = NULL;
+        if( s.Type == CTL_STEP_CREEP || s.Type == CTL_STEP_CREEP2 ) step = &motor;
+        if( s.Type == CTL_STEP_LINEAR_PATH ) step = &cell;
+        if( step && s.HasPid && (s.PidScript || step->Enabled) ){
+            step->Enabled = true;
+            step->Kp  = s.Kp;
+            step->Ki  = s.Ki;
+            step->Kd  = s.Kd;
+            step->Kff = s.Kff;
+        }
+    }
+    ctx->pid.Motor.Configure(motor);
+    ctx->pid.Cell.Configure(cell);
+
+    // Bumpless: the motor starts from standstill, the cell from the present command
+    ctx->pid.Motor.Reset(0.0);
+    if( ctx->ao.cal.a[DA_CH_EP_CELL] != 0.0 ){
+        ctx->pid.Cell.Reset((ctx->ao.raw[DA_CH_EP_CELL]-ctx->ao.cal.b[DA_CH_EP_CELL])/ctx->ao.cal.a[DA_CH_EP_CELL]);
+    }
+    else {
+        ctx->pid.Cell.Reset(0.0);
+    }
+}
+
+// Motor speed PID: replaces the on/off clutch/speed output when enabled.
+// Output in rpm, > 0 loads the specimen (clutch down), < 0 unloads (clutch up).
+bool CDigitShowBasicDoc::MotorPid(double target, double measurement, double minRpm, double maxRpm)
+{
+    DigitShowContext* ctx = GetContext();
+    PidController& pid = ctx->pid.Motor;
+    if( !pid.Enabled() ) return false;
+
+    pid.SetLimits(minRpm, maxRpm);
+    const double rpm = pid.Update(target, 0.0, measurement, ctx->CtrlStepTime);
+    ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = (rpm < 0.0) ? 5.0f : 0.0f;
+    // Cruch: Up / Down
+    if( rpm != 0.0 ) ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*fabs(rpm)+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
+    else             ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
+    return true;
+}
+
+// Cell pressure PID: the setpoint ramps to target at ratePerMin [kPa/min]
+// (0 = step); replaces the incremental EP output when enabled.
+bool CDigitShowBasicDoc::CellPid(double target, double ratePerMin, double measurement)
+{
+    DigitShowContext* ctx = GetContext();
+    PidController& pid = ctx->pid.Cell;
+    const double a = ctx->ao.cal.a[DA_CH_EP_CELL];
+    const double b = ctx->ao.cal.b[DA_CH_EP_CELL];
+    if( !pid.Enabled() || a == 0.0 ) return false;
 
+    // EP input range 0..9.9999 V
+    const double lo = (0.0-b)/a, hi = (9.9999-b)/a;
+    if( lo < hi ) pid.SetLimits(lo, hi);
+    else          pid.SetLimits(hi, lo);
+    const double kPa = pid.Update(target, fabs(ratePerMin)/60.0, measurement, ctx->CtrlStepTime);
+    ctx->ao.raw[DA_CH_EP_CELL] = float(a*kPa+b);
+    return true;
 }
 
 void CDigitShowBasicDoc::Stop_Control()
 {
     DigitShowContext* ctx = GetContext();
+    ctx->da.Out.StopWave();
     ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
     //Motor Speed->0
     DA_OUTPUT();
 }
 
-void CDigitShowBasicDoc::MLoading_Stress()
+//--- Control file (mode 15) steps ---
+// Each step gets its compiled form (ControlProgram.h) and is called from the
+// dispatch table in RunControlProgram().
+void CDigitShowBasicDoc::AdvanceStep()
+{
+    DigitShowContext* ctx = GetContext();
+    ctx->da.Out.StopWave();
+    ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
+    ctx->TotalStepTime = 0.0;
+    ctx->NumCyclic = 0;
+}
+
+void CDigitShowBasicDoc::MotorOff(const ControlFileStep& s)
+{
+    DigitShowContext* ctx = GetContext();
+    ctx->ao.raw[DA_CH_MOTOR] = 0.0f;
+}
+
+// Direction 0: load (clutch down) while x <= Target; 1: unload (clutch up) while x >= Target
+void CDigitShowBasicDoc::MonotonicLoading(const ControlFileStep& s, double x)
 {
     DigitShowContext* ctx = GetContext();
     ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
     ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
     // Motor: On
-    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
+    ctx->ao.raw[DA_CH_MOTOR_SPEED] = s.SpeedVolts;
     // Motor_Speed
-    if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==0.0){
-        if( ctx->phys.q <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
+    if(s.Direction==0){
+        if( x <= s.Target ) {
             ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
             // Cruch:Down
         }
-        else {
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
-        }
+        else AdvanceStep();
     }
-    else if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==1.0){
-        if( ctx->phys.q >= ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
+    else {
+        if( x >= s.Target ) {
             ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
             // Cruch:Up
         }
-        else {
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
-        }
+        else AdvanceStep();
     }
 }
 
-void CDigitShowBasicDoc::MLoading_Strain()
+// Cycles between Lower and Upper. Direction 0: unload first, a cycle ends
+// at Upper; 1: load first, a cycle ends at Lower.
+void CDigitShowBasicDoc::CyclicLoading(const ControlFileStep& s, double x)
 {
     DigitShowContext* ctx = GetContext();
     ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
     ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
     // Motor: On
-    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
+    ctx->ao.raw[DA_CH_MOTOR_SPEED] = s.SpeedVolts;
     // Motor_Speed
-    if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==0.0){
-        if(ctx->phys.ea <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
-            ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-            // Cruch:Down
-        }
-        else {
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
-        }
+    if(ctx->NumCyclic==0){
+        ctx->flags.Cyclic = (s.Direction==1);
+        ctx->NumCyclic = 1;
     }
-    else if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==1.0){
-        if(ctx->phys.ea >= ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
+    if(ctx->NumCyclic <= s.Cycles){
+        if(ctx->flags.Cyclic==FALSE){
             ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
             // Cruch:Up
+            if( x <= s.Lower ) {
+                ctx->flags.Cyclic = TRUE;
+                if(s.Direction==1) ctx->NumCyclic = ctx->NumCyclic+1;
+            }
         }
-        else {
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
+        if(ctx->flags.Cyclic==TRUE){
+            ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
+            // Cruch:Down
+            if( x >= s.Upper ) {
+                ctx->flags.Cyclic = FALSE;
+                if(s.Direction==0) ctx->NumCyclic = ctx->NumCyclic+1;
+            }
         }
     }
+    if(ctx->NumCyclic > s.Cycles) AdvanceStep();
+}
+
+void CDigitShowBasicDoc::MLoading_Stress(const ControlFileStep& s)
+{
+    MonotonicLoading(s, GetContext()->phys.q);
 }
 
-void CDigitShowBasicDoc::CLoading_Stress()
+void CDigitShowBasicDoc::MLoading_Strain(const ControlFileStep& s)
+{
+    MonotonicLoading(s, GetContext()->phys.ea);
+}
+
+void CDigitShowBasicDoc::CLoading_Stress(const ControlFileStep& s)
+{
+    CyclicLoading(s, GetContext()->phys.q);
+}
+
+void CDigitShowBasicDoc::CLoading_Strain(const ControlFileStep& s)
+{
+    CyclicLoading(s, GetContext()->phys.ea);
+}
+
+void CDigitShowBasicDoc::Creep(const ControlFileStep& s)
 {
     DigitShowContext* ctx = GetContext();
     ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
     ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
-    // Motor: On
-    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
-    // Motor_Speed
-    if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==0.0){
-        if(ctx->NumCyclic==0){
-            ctx->flags.Cyclic = FALSE;
-            ctx->NumCyclic = 1;
-        }
-        if(ctx->NumCyclic!=0 && ctx->NumCyclic <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){
-            if(ctx->flags.Cyclic==FALSE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
-                // Cruch:Up
-                if( ctx->phys.q<=ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) ctx->flags.Cyclic = TRUE;
-            }
-            if(ctx->flags.Cyclic==TRUE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-                // Cruch:Down
-                if( ctx->phys.q>=ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]) {
-                    ctx->flags.Cyclic = FALSE;
-                    ctx->NumCyclic = ctx->NumCyclic+1;
-                }
-            }
-        }
-        if(ctx->NumCyclic>ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){ 
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
-            ctx->NumCyclic = 0;
-        }
+    // Motor:On
+    ctx->ao.raw[DA_CH_MOTOR_SPEED] = s.SpeedVolts;
+    if( ctx->phys.q >= s.Target+ctx->errTol.StressCom)    {
+        ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
+        // Cruch:Up
     }
-    else if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==1.0){
-        if(ctx->NumCyclic==0){
-            ctx->flags.Cyclic = TRUE;
-            ctx->NumCyclic = 1;
-        }
-        if(ctx->NumCyclic!=0 && ctx->NumCyclic <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){
-            if(ctx->flags.Cyclic==FALSE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
-                // Cruch:Up
-                if( ctx->phys.q<=ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
-                    ctx->flags.Cyclic = TRUE;
-                    ctx->NumCyclic = ctx->NumCyclic+1;
-                }
-            }
-            if(ctx->flags.Cyclic==TRUE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-                // Cruch:Down
-                if( ctx->phys.q>=ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]) ctx->flags.Cyclic = FALSE;
-            }
-        }
-        if(ctx->NumCyclic>ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){ 
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
-            ctx->NumCyclic = 0;
-        }
+    else if( ctx->phys.q <= s.Target+ctx->errTol.StressExt)    {
+        ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
+        // Cruch:Down
+    }        
+    else {
+        ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
+        // RPM->0
     }
+    MotorPid(s.Target, ctx->phys.q, -s.Rpm, s.Rpm);
+    if(ctx->TotalStepTime >= s.Duration) AdvanceStep();
 }
 
-void CDigitShowBasicDoc::CLoading_Strain()
+void CDigitShowBasicDoc::LinearEffectiveStressPath(const ControlFileStep& s)
 {
     DigitShowContext* ctx = GetContext();
+    const double e_sr = ctx->phys.e_sr;
+    const double e_sa = ctx->phys.e_sa;
+    const double sa   = s.PathSa(e_sr);
+    // e_sa on the path at the present e_sr
+    const double hold = 0.2*ctx->ao.cal.a[DA_CH_EP_CELL]*(s.Sr1-e_sr);
+    // cell pressure correction near / at the end point
+    const float  ramp = s.CellVoltsPerSec*float(ctx->CtrlStepTime);
+    bool done = false;
+
     ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
     ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
-    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
-    // Motor_Speed
-    if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==0.0){
-        if(ctx->NumCyclic==0){
-            ctx->flags.Cyclic = FALSE;
-            ctx->NumCyclic = 1;
-        }
-        if(ctx->NumCyclic!=0 && ctx->NumCyclic <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){
-            if(ctx->flags.Cyclic==FALSE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
-                // Cruch:Up
-                if(ctx->phys.ea<=ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) ctx->flags.Cyclic = TRUE;
-            }
-            if(ctx->flags.Cyclic==TRUE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-                // Cruch:Down
-                if(ctx->phys.ea>=ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]) {
-                    ctx->flags.Cyclic = FALSE;
-                    ctx->NumCyclic = ctx->NumCyclic+1;
-                }
-            }
-        }
-        if(ctx->NumCyclic>ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){ 
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
-            ctx->NumCyclic = 0;
-        }
+    ctx->ao.raw[DA_CH_MOTOR_SPEED] = s.SpeedVolts;
+    if(s.ConstSr){
+        ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(hold);
     }
-    else if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]==1.0){
-        if(ctx->NumCyclic==0){
-            ctx->flags.Cyclic = TRUE;
-            ctx->NumCyclic = 1;
-        }
-        if(ctx->NumCyclic!=0 && ctx->NumCyclic <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){
-            if(ctx->flags.Cyclic==FALSE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
-                // Cruch:Up
-                if(ctx->phys.ea<=ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
-                    ctx->flags.Cyclic = TRUE;
-                    ctx->NumCyclic = ctx->NumCyclic+1;
-                }
-            }
-            if(ctx->flags.Cyclic==TRUE){
-                ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-                // Cruch:Down
-                if(ctx->phys.ea>=ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]) ctx->flags.Cyclic = FALSE;
-            }
-        }
-        if(ctx->NumCyclic>ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]){ 
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
-            ctx->NumCyclic = 0;
-        }
+    else if(s.Sr0 < s.Sr1){
+        if( e_sr >= s.Sr1-ctx->errTol.StressA) ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(hold);
+        else                                   ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+ramp;
     }
+    else {
+        if( e_sr > s.Sr1+ctx->errTol.StressA)  ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-ramp;
+        else                                   ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(hold);
+    }
+    if( e_sa > sa+ctx->errTol.StressCom){
+        ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
+        // Cruch:Up
+    }
+    else if( e_sa < sa+ctx->errTol.StressExt){
+        ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
+        // Cruch:Down
+    }
+    else if(s.ConstSr){
+        done = true;
+    }
+    else {
+        ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
+        // RPM -> 0
+        done = (fabs(e_sr-s.Sr1) <= ctx->errTol.StressA);
+    }
+    if(done){
+        AdvanceStep();
+        return;
+    }
+    // PID (if enabled) replaces the on/off output above; step completion is unchanged
+    CellPid(s.Sr1, s.CellRate, e_sr);
+    MotorPid(sa, e_sa, -s.Rpm, s.Rpm);
 }
 
-void CDigitShowBasicDoc::Creep()
+void CDigitShowBasicDoc::Creep2(const ControlFileStep& s)
 {
     DigitShowContext* ctx = GetContext();
     ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
     ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
     // Motor:On
-    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
-    if( ctx->phys.q>=ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]+ctx->errTol.StressCom)    {
-        ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
-        // Cruch:Up
-    }
-    else if( ctx->phys.q<=ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]+ctx->errTol.StressExt)    {
+    ctx->ao.raw[DA_CH_MOTOR_SPEED] = s.SpeedVolts;
+    if( ctx->phys.q <= s.Target+ctx->errTol.StressExt)    {
         ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
         // Cruch:Down
     }        
@@ -992,100 +1453,121 @@ void CDigitShowBasicDoc::Creep()
         ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
         // RPM->0
     }
-    if(ctx->TotalStepTime>= ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
-        ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-        ctx->TotalStepTime = 0.0;
-    }
+    MotorPid(s.Target, ctx->phys.q, 0.0, s.Rpm);
+    if(ctx->TotalStepTime >= s.Duration) AdvanceStep();
 }
 
-void CDigitShowBasicDoc::LinearEffectiveStressPath()
+// Board-buffered waveform: the DA board outputs the precomputed cycles on
+// its own clock; this step starts it, counts the cycles output and, with
+// q_amp, scales the motor amplitude of the cycles still to be loaded by
+// the q single amplitude of the last one (0.5..2 times per cycle).
+void CDigitShowBasicDoc::WaveLoading(const ControlFileStep& s)
 {
     DigitShowContext* ctx = GetContext();
-    ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
-    ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
-    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ctx->controlFile.Para[ctx->controlFile.CurrentNum][4]+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
-    if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]==ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]){
-        ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(0.2*ctx->ao.cal.a[DA_CH_EP_CELL]*(ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]- ctx->phys.e_sr));
-        if( ctx->phys.e_sa > ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]+ctx->errTol.StressCom){
-            ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
-            // Cruch:Up
-        }
-        else if( ctx->phys.e_sa < ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]+ctx->errTol.StressExt){
-            ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-            // Cruch:Down
+    if( ctx->TotalStepTime == 0.0 && !ctx->da.Out.WaveRunning() ){
+        const int ch = (s.WaveTarget == AO_WAVE_MOTOR) ? DA_CH_MOTOR_SPEED : DA_CH_EP_CELL;
+        AoWaveSpec spec;
+        spec.Shape     = s.WaveShape;
+        spec.Target    = s.WaveTarget;
+        spec.Amplitude = s.Amplitude;
+        spec.Period    = s.Period;
+        spec.Cycles    = s.Cycles;
+        spec.Gain      = ctx->ao.cal.a[ch];
+        spec.Offset    = ctx->ao.cal.b[ch];
+        spec.Center    = (spec.Gain != 0.0) ? (ctx->ao.raw[DA_CH_EP_CELL]-spec.Offset)/spec.Gain : 0.0;
+        if( s.WaveShape >= AO_WAVE_USER ) spec.Table = ctx->ai.filterCfg.WaveTables[s.WaveShape-AO_WAVE_USER];
+        if( s.WaveTarget == AO_WAVE_MOTOR ){
+            ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
+            ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
         }
-        else {
-            ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-            ctx->TotalStepTime = 0.0;
+        ctx->wave.Amplitude = s.Amplitude;
+        ctx->wave.QMin = ctx->wave.QMax = ctx->phys.q;
+        if( (s.WaveShape >= AO_WAVE_USER && spec.Table.empty()) || ctx->da.Out.StartWave(spec, ctx->ao.raw) != 0 ){
+            AdvanceStep();
+            return;
         }
     }
-    else if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][1] < ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]){
-        if( ctx->phys.e_sr >= ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]-ctx->errTol.StressA) {
-            ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-float(0.2*ctx->ao.cal.a[DA_CH_EP_CELL]*(ctx->phys.e_sr-ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]));
-        }
-        if( ctx->phys.e_sr < ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]-ctx->errTol.StressA) {
-            ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(ctx->ao.cal.a[DA_CH_EP_CELL]*fabs(ctx->controlFile.Para[ctx->controlFile.CurrentNum][5])/60.0*ctx->timeSettings.ControlInterval/1000.0);
-        }
-        if( ctx->phys.e_sa > (ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][0])/(ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])*(ctx->phys.e_sr-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])+ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]+ctx->errTol.StressCom){
-            ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
-            // Cruch:Up
+    ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
+    if( ctx->phys.q < ctx->wave.QMin ) ctx->wave.QMin = ctx->phys.q;
+    if( ctx->phys.q > ctx->wave.QMax ) ctx->wave.QMax = ctx->phys.q;
+    const int done = ctx->da.Out.WaveCycles();
+    if( done > ctx->NumCyclic ){
+        const double qAmp = (ctx->wave.QMax-ctx->wave.QMin)/2.0;
+        if( s.QAmp > 0.0 && qAmp > 0.0 ){
+            double k = s.QAmp/qAmp;
+            if( k < 0.5 ) k = 0.5;
+            if( k > 2.0 ) k = 2.0;
+            ctx->wave.Amplitude = ctx->wave.Amplitude*k;
+            ctx->da.Out.SetWaveAmplitude(ctx->wave.Amplitude);
         }
-        else if( ctx->phys.e_sa < (ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][0])/(ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])*(ctx->phys.e_sr-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])+ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]+ctx->errTol.StressExt){
+        ctx->wave.QMin = ctx->wave.QMax = ctx->phys.q;
+        ctx->NumCyclic = done;
+    }
+    if( !ctx->da.Out.WaveRunning() ){
+        ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
+        AdvanceStep();
+    }
+}
+
+// Constant axial strain rate: like load_strain, but the motor speed follows
+// StrainRateControl so the measured rate stays at s.StrainRate whatever
+// the frame compliance
+void CDigitShowBasicDoc::StrainRateLoading(const ControlFileStep& s)
+{
+    DigitShowContext* ctx = GetContext();
+    if( ctx->TotalStepTime == 0.0 ) ctx->rate.Start(s.Rpm, s.RpmMax, s.Window);
+    ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
+
+    double rate = 0.0;
+    const bool valid = MeasureStrainRate(s.Window, &rate);
+    // loading raises ea, unloading lowers it
+    const double rpm = ctx->rate.Update(s.StrainRate, (s.Direction == 0) ? rate : -rate, valid, ctx->CtrlStepTime);
+    ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
+    // Motor: On
+    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*rpm+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
+    // Motor_Speed
+    if(s.Direction==0){
+        if( ctx->phys.ea <= s.Target ) {
             ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
             // Cruch:Down
         }
-        else {
-            ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
-            // RPM -> 0
-            if(fabs(ctx->phys.e_sr-ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]) <= ctx->errTol.StressA) {
-                ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-                ctx->TotalStepTime = 0.0;
-            }
-        }
+        else AdvanceStep();
     }
-    else if(ctx->controlFile.Para[ctx->controlFile.CurrentNum][1] > ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]){
-        if( ctx->phys.e_sr > ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]+ctx->errTol.StressA) {
-            ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]-float(ctx->ao.cal.a[DA_CH_EP_CELL]*fabs(ctx->controlFile.Para[ctx->controlFile.CurrentNum][5])/60.0*ctx->timeSettings.ControlInterval/1000.0);
-        }
-        if( ctx->phys.e_sr <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]+ctx->errTol.StressA) {
-            ctx->ao.raw[DA_CH_EP_CELL] = ctx->ao.raw[DA_CH_EP_CELL]+float(0.2*ctx->ao.cal.a[DA_CH_EP_CELL]*(ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]- ctx->phys.e_sr));
-        }
-        if( ctx->phys.e_sa > (ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][0])/(ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])*(ctx->phys.e_sr-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])+ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]+ctx->errTol.StressCom){
+    else {
+        if( ctx->phys.ea >= s.Target ) {
             ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 5.0f;
             // Cruch:Up
         }
-        else if( ctx->phys.e_sa < (ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][0])/(ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])*(ctx->phys.e_sr-ctx->controlFile.Para[ctx->controlFile.CurrentNum][1])+ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]+ctx->errTol.StressExt){
-            ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-            // Cruch:Down
-        }
-        else {
-            ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
-            // RPM -> 0
-            if(fabs(ctx->phys.e_sr-ctx->controlFile.Para[ctx->controlFile.CurrentNum][3]) <= ctx->errTol.StressA){
-                ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-                ctx->TotalStepTime = 0.0;
-            }
-        }
+        else AdvanceStep();
     }
 }
 
-void CDigitShowBasicDoc::Creep2()
+// dea/dt [%/min] over the last `window` seconds of the filtered displacement
+// (ch 1) in ai.history, the same calibration as Cal_Param(). False until
+// the history spans most of the window.
+bool CDigitShowBasicDoc::MeasureStrainRate(double window, double* rate)
 {
     DigitShowContext* ctx = GetContext();
-    ctx->TotalStepTime = ctx->TotalStepTime+ctx->CtrlStepTime/60.0;
-    ctx->ao.raw[DA_CH_MOTOR] = 5.0f;
-    // Motor:On
-    ctx->ao.raw[DA_CH_MOTOR_SPEED] = float(ctx->ao.cal.a[DA_CH_MOTOR_SPEED]*ctx->controlFile.Para[ctx->controlFile.CurrentNum][0]+ctx->ao.cal.b[DA_CH_MOTOR_SPEED]);
-    if( ctx->phys.q <= ctx->controlFile.Para[ctx->controlFile.CurrentNum][1]+ctx->errTol.StressExt)    {
-        ctx->ao.raw[DA_CH_MOTOR_CLUTCH] = 0.0f;
-        // Cruch:Down
-    }        
-    else {
-        ctx->ao.raw[DA_CH_MOTOR_SPEED] = 0.0f;
-        // RPM->0
-    }
-    if(ctx->TotalStepTime >= ctx->controlFile.Para[ctx->controlFile.CurrentNum][2]) {
-        ctx->controlFile.CurrentNum = ctx->controlFile.CurrentNum+1;
-        ctx->TotalStepTime = 0.0;
+    const FilterHistory& h = ctx->ai.history;
+    const double h0 = ctx->specimen.Height[0];
+    if( !ctx->flags.SetBoard || h.Tiers() == 0 || h0 <= 0.0 ) return false;
+
+    StrainRateControl& r = ctx->rate;
+    const int tier = h.TierFor(window);
+    const size_t want = size_t(window/h.Period(tier))+1;
+    r.T.resize(want);
+    r.V.resize(want);
+    r.Ea.resize(want);
+    const size_t n = h.ReadLatest(tier, 1, want, r.T.data(), r.V.data());
+    if( n < 3 || r.T[n-1]-r.T[0] < 0.8*window ) return false;
+    for( size_t i = 0; i < n; i++ ){
+        const double v = r.V[i];
+        const double height = h0-(ctx->ai.cal.a[1]*v*v+ctx->ai.cal.b[1]*v+ctx->ai.cal.c[1]);
+        if( height <= 0.0 ) return false;
+        r.Ea[i] = -log(height/h0)*100.0;
     }
+    double slope;
+    if( !RobustSlope(r.T.data(), r.Ea.data(), n, STRAIN_RATE_BINS, &slope) ) return false;
+    *rate = slope*60.0;
+    return true;
 }
@@ -34,23 +34,42 @@ public:
     virtual void Serialize(CArchive& ar);
 
 public:
-    void Creep2();
-    void LinearEffectiveStressPath();
+    void WaveLoading(const ControlFileStep& s);
+    void StrainRateLoading(const ControlFileStep& s);
+    bool MeasureStrainRate(double window, double* rate);
+    void Creep2(const ControlFileStep& s);
+    void LinearEffectiveStressPath(const ControlFileStep& s);
     void Stop_Control();
     void Start_Control();
-    void Creep();
-    void CLoading_Strain();
-    void CLoading_Stress();
-    void MLoading_Strain();
-    void MLoading_Stress();
+    void Creep(const ControlFileStep& s);
+    void CLoading_Strain(const ControlFileStep& s);
+    void CLoading_Stress(const ControlFileStep& s);
+    void MLoading_Strain(const ControlFileStep& s);
+    void MLoading_Stress(const ControlFileStep& s);
+    void MotorOff(const ControlFileStep& s);
+    void MonotonicLoading(const ControlFileStep& s, double x);
+    void CyclicLoading(const ControlFileStep& s, double x);
+    void AdvanceStep();
+    void UpdateControlProgram();
+    void RunControlProgram();
+    double StepQuantity(int q);
     void CloseBoard();
     void OpenBoard();
     void SaveToFile();
+    void AnalyzeCycle();
     void Control_DA();
+    void SetupPid();
+    bool MotorPid(double target, double measurement, double minRpm, double maxRpm);
+    bool CellPid(double target, double ratePerMin, double measurement);
     void Cal_Param();
-    void Cal_Physical();
+    void Cal_Physical(const float* raw = NULL);
     void DA_OUTPUT();
     void AD_INPUT();
+    void AcquireTick();
+    void ControlTick(double dt);
+    void ControlStep(double dt, const float* raw);
+    void SaveTick();
+    void SaveRow();
     virtual ~CDigitShowBasicDoc();
 
 #ifdef _DEBUG
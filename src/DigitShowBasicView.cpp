@@ -23,6 +23,7 @@
 
 #include "DigitShowBasicDoc.h"
 #include "DigitShowBasicView.h"
+#include "MainFrm.h"
 
 #include "caio.h"
 
@@ -121,6 +122,9 @@ CDigitShowBasicView::CDigitShowBasicView()
 CDigitShowBasicView::~CDigitShowBasicView()
 {
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
+    StopRigs();
+    RigScope rig0(0);
+    GetContext()->ctrlLoop.Stop();
     pDoc->CloseBoard();
 }
 
@@ -180,7 +184,7 @@ void CDigitShowBasicView::DoDataExchange(CDataExchange* pDX)
     DDX_Text(pDX, IDC_EDIT_NowTime, m_NowTime);
     DDX_Text(pDX, IDC_EDIT_SeqTime, m_SeqTime);
     DDX_Text(pDX, IDC_EDIT_SamplingTime, m_SamplingTime);
-    DDV_MinMaxLong(pDX, m_SamplingTime, 100, 86400000);
+    DDV_MinMaxLong(pDX, m_SamplingTime, 50, 86400000);
     DDX_Text(pDX, IDC_EDIT_FileName, m_FileName);
     //}}AFX_DATA_MAP
 }
@@ -219,7 +223,6 @@ CDigitShowBasicDoc* CDigitShowBasicView::GetDocument() // 非デバッグ バー
 void CDigitShowBasicView::OnInitialUpdate()
 {
     DigitShowContext* ctx = GetContext();
-    long        Ret;
     CFormView::OnInitialUpdate();
     GetParentFrame()->RecalcLayout();
     ResizeParentToFit();
@@ -249,6 +252,8 @@ void CDigitShowBasicView::OnInitialUpdate()
     m_Combo1->InsertString(-1,"15");
     m_Combo1->SetWindowText("0");
     CComboBox* m_Combo2 = (CComboBox*)GetDlgItem(IDC_COMBO_SamplingTime);
+    m_Combo2->InsertString(-1,"0.05 s");
+    m_Combo2->InsertString(-1,"0.1 s");
     m_Combo2->InsertString(-1,"0.2 s");
     m_Combo2->InsertString(-1,"0.5 s");
     m_Combo2->InsertString(-1,"1.0 s");
@@ -266,36 +271,96 @@ void CDigitShowBasicView::OnInitialUpdate()
     m_Combo2->SetWindowText("1.0 s");
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
     pDoc->OpenBoard();
-    if(ctx->flags.SetBoard){
-        {
-            // floor() rounds toward shorter period to avoid board init failure
-            const float scanClock_us =
-                floorf(1000000.0f / (float(DSP_FS_HZ) * float(DSP_AD_CHANNELS)));
-            Ret = AioSetAiSamplingClock(ctx->ad.Id, scanClock_us * DSP_AD_CHANNELS);
-            Ret = AioGetAiSamplingClock(ctx->ad.Id, &ctx->ad.SamplingClock);
-            Ret = AioSetAiScanClock    (ctx->ad.Id, scanClock_us);
-            Ret = AioGetAiScanClock    (ctx->ad.Id, &ctx->ad.ScanClock);
-
-            // EventSamplingTimes: scans accumulated per Interval1 ms
-            ctx->ad.SamplingTimes =
-                long(ctx->timeSettings.DisplayInterval * 1000.0f
-                     / (scanClock_us * DSP_AD_CHANNELS));
-            if (ctx->ad.SamplingTimes < 1) ctx->ad.SamplingTimes = 1;
-
-            Ret = AioSetAiEventSamplingTimes(ctx->ad.Id, ctx->ad.SamplingTimes);
-            Ret = AioGetAiEventSamplingTimes(ctx->ad.Id, &ctx->ad.SamplingTimes);
-            // Resize sample buffer to match the confirmed SamplingTimes
-            ctx->ad.Data0.resize(
-                static_cast<size_t>(ctx->ad.SamplingTimes) * DSP_AD_CHANNELS);
-            Ret = AioSetAiStopTrigger(ctx->ad.Id, 4);
-            Ret = AioResetAiMemory   (ctx->ad.Id);
+    if(ctx->flags.SetBoard) StartAcquisition(true);
+    SetTimer(1,ctx->timeSettings.DisplayInterval,NULL);    
+    StartRigs();
+}
+
+// "capture <dir>": raw scans of every AD board for as long as they run
+static void OpenRawCapture(DigitShowContext* ctx)
+{
+    std::string dir = ctx->ai.filterCfg.CaptureDir;
+    if (dir.back() != '\\' && dir.back() != '/') dir += '\\';
+    CString path = dir.c_str();
+    CString name;
+    name.Format("DigitShowRaw_rig%d_", ctx->RigID + 1);
+    path += name + CTime::GetCurrentTime().Format("%Y%m%d_%H%M%S.dsraw");
+
+    RawCaptureHeader header;
+    header.Channels   = ctx->ai.channels;     // secondary boards at ch 16b, as AD_INPUT() pairs them
+    header.ScanPeriod = ctx->ad.SamplingClock * 1e-6;
+    header.RangeMax   = ctx->ad.RangeMax;
+    header.RangeMin   = ctx->ad.RangeMin;
+    header.Resolution = ctx->ad.Resolution;
+    memset(ctx->ai.captureCodes, 0, sizeof(ctx->ai.captureCodes));
+    std::string msg;
+    if (!ctx->ai.capture.Open((LPCSTR)path, header, &msg)) {
+        TRACE("Rig %d raw capture: %s\n", ctx->RigID + 1, msg.c_str());
+    }
+}
+
+// Configure the clocks and start AD on the rig bound to this thread.
+// events: rig 0 is read from the AD event messages of this window; the
+// other rigs have no window and poll their first board from ai.worker.
+void CDigitShowBasicView::StartAcquisition(bool events)
+{
+    DigitShowContext* ctx = GetContext();
+    long        Ret;
+    {
+        // floor() rounds toward shorter period to avoid board init failure
+        const float scanClock_us =
+            floorf(1000000.0f / (float(ctx->ai.filterCfg.FsHz) * float(DSP_AD_CHANNELS)));
+        Ret = ctx->ad.Dev->SetAiSamplingClock(scanClock_us * DSP_AD_CHANNELS);
+        Ret = ctx->ad.Dev->GetAiSamplingClock(&ctx->ad.SamplingClock);
+        Ret = ctx->ad.Dev->SetAiScanClock    (scanClock_us);
+        Ret = ctx->ad.Dev->GetAiScanClock    (&ctx->ad.ScanClock);
+
+        // EventSamplingTimes: scans per latency budget (Interval1 ms unless
+        // "latency" is set in the filter config), then tuned at run time
+        const double budgetMs = (ctx->ai.filterCfg.LatencyMs > 0.0)
+            ? ctx->ai.filterCfg.LatencyMs : double(ctx->timeSettings.DisplayInterval);
+        ctx->ad.Tuner.Configure(ctx->ad.SamplingClock * 1e-6, budgetMs / 1000.0,
+                                ctx->ai.filterCfg.AutoBurst);
+        ctx->ad.SamplingTimes = ctx->ad.Tuner.Initial();
+
+        Ret = ctx->ad.Dev->SetAiEventSamplingTimes(ctx->ad.SamplingTimes);
+        Ret = ctx->ad.Dev->GetAiEventSamplingTimes(&ctx->ad.SamplingTimes);
+        // Resize sample buffer to match the confirmed SamplingTimes
+        ctx->ad.Data0.resize(
+            static_cast<size_t>(ctx->ad.SamplingTimes) * DSP_AD_CHANNELS);
+        Ret = ctx->ad.Dev->SetAiStopTrigger(4);
+        Ret = ctx->ad.Dev->ResetAiMemory   ();
+
+        // Secondary boards run on the same clocks, polled by their workers
+        for (auto& aux : ctx->ad.Aux) {
+            Ret = aux->Dev->SetAiSamplingClock(scanClock_us * DSP_AD_CHANNELS);
+            Ret = aux->Dev->SetAiScanClock    (scanClock_us);
+            Ret = aux->Dev->SetAiEventSamplingTimes(ctx->ad.SamplingTimes);
+            Ret = aux->Dev->SetAiStopTrigger(4);
+            Ret = aux->Dev->ResetAiMemory   ();
         }
+    }
+    if (events) {
         const long adEvent = AIE_DATA_NUM | AIE_OFERR | AIE_SCERR | AIE_ADERR;
-        Ret = AioSetAiEvent(ctx->ad.Id, m_hWnd, adEvent);
-        Ret = AioSetAiEventSamplingTimes(ctx->ad.Id, ctx->ad.SamplingTimes);
-        Ret = AioStartAi(ctx->ad.Id);
+        Ret = ctx->ad.Dev->SetAiEvent(m_hWnd, adEvent);
     }
-    SetTimer(1,ctx->timeSettings.DisplayInterval,NULL);    
+    Ret = ctx->ad.Dev->SetAiEventSamplingTimes(ctx->ad.SamplingTimes);
+    Ret = ctx->ad.Dev->StartAi();
+    // Scan 0 is anchored to the host monotonic clock here
+    ctx->ai.clock.Start(ctx->ad.SamplingClock * 1e-6);
+    ctx->ai.faults.Reset();
+    ctx->ad.Tuner.Applied(ctx->ad.SamplingTimes, ctx->ai.clock.HostNow());
+    if (!events) {
+        ctx->ai.worker.Start(ctx->ad.Dev.get(), &ctx->ai.ring, &ctx->ai.clock, DSP_AD_CHANNELS,
+                             ctx->ad.SamplingTimes, ctx->ad.Tuner.BurstPeriod() / 2.0);
+    }
+    for (auto& aux : ctx->ad.Aux) {
+        Ret = aux->Dev->StartAi();
+        aux->clock.StartFrom(ctx->ai.clock, ctx->ad.SamplingClock * 1e-6);
+        aux->worker.Start(aux->Dev.get(), &aux->ring, &aux->clock, DSP_AD_CHANNELS,
+                          ctx->ad.SamplingTimes, ctx->ad.Tuner.BurstPeriod() / 2.0);
+    }
+    if (!ctx->ai.filterCfg.CaptureDir.empty()) OpenRawCapture(ctx);
 }
 
 HBRUSH CDigitShowBasicView::OnCtlColor(CDC* pDC, CWnd* pWnd, UINT nCtlColor) 
@@ -330,47 +395,30 @@ void CDigitShowBasicView::OnDestroy()
 }
 void CDigitShowBasicView::OnTimer(UINT_PTR nIDEvent) 
 {
-    DigitShowContext* ctx = GetContext();
-
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
 
-
+    // The timers drive acquisition and logging of rig 0 (control has its
+    // own thread, which takes the same lock); the window shows the rig selected in the menu
     switch (nIDEvent)
     {
     case 1:
-        { 
-            ctx->NowTime = ctx->NowTime.GetCurrentTime();
-            ctx->SNowTime = ctx->NowTime.Format("%m/%d  %H:%M:%S");
-            if(ctx->flags.SaveData){
-                ctx->SpanTime = ctx->NowTime- ctx->StartTime;
-                ctx->SequentTime1 = (long)ctx->SpanTime.GetTotalSeconds();
-            }    
-            if(ctx->flags.SetBoard)    pDoc -> AD_INPUT();
-            pDoc -> Cal_Physical();
-            pDoc -> Cal_Param();
-            ShowData();
-        }
-        break;
-    case 2:
-        { 
-            _ftime_s(&StepTime1);
-            if(ctx->flags.Ctrl==FALSE){
-                StepTime0 = StepTime1;
-                ctx->flags.Ctrl = TRUE;
+        {
+            {
+                RigScope rig0(0);
+                std::lock_guard<std::mutex> lock(GetContext()->runner.Mutex());
+                pDoc -> AcquireTick();
             }
-            ctx->CtrlStepTime = double(StepTime1.time-StepTime0.time)+double( (StepTime1.millitm-StepTime0.millitm)/1000.0 );
-            StepTime0 = StepTime1;
-            if(ctx->flags.SetBoard)    pDoc -> Control_DA(); 
+            DigitShowContext* ctx = GetContext();
+            std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+            ShowData();
+            UpdateAiStatus();
         }
         break;
     case 3:
-        { 
-            _ftime_s(&NowTime2);
-            ctx->SequentTime2 = double(NowTime2.time-StartTime2.time)+double( (NowTime2.millitm-StartTime2.millitm)/1000.0 );
-            if(ctx->flags.SetBoard)    pDoc -> AD_INPUT();
-            pDoc -> Cal_Physical();
-            pDoc -> Cal_Param();
-            pDoc -> SaveToFile();
+        {
+            RigScope rig0(0);
+            std::lock_guard<std::mutex> lock(GetContext()->runner.Mutex());
+            pDoc -> SaveTick();
         }
         break;
     }    
@@ -444,13 +492,34 @@ void CDigitShowBasicView::OnBUTTONCtrlOn()
     DigitShowContext* ctx = GetContext();
 
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     if(ctx->flags.SetBoard){
-        SetTimer(2,ctx->timeSettings.ControlInterval,NULL);
+        ctx->flags.CtrlRun = TRUE;
         CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_CtrlOn);
         CButton* myBTN2 = (CButton*)GetDlgItem(IDC_BUTTON_CtrlOff);
         myBTN1->EnableWindow(FALSE);    
         myBTN2->EnableWindow(TRUE);
         pDoc->Start_Control();
+        // Control runs on its own timer thread, not on WM_TIMER. Sync mode:
+        // the thread only drains the AD ring every scan period; AD_INPUT()
+        // runs the control law on each decimated scan it filters.
+        const int rig = ctx->RigID;
+        if (ctx->ai.filterCfg.SyncControl) {
+            ctx->ctrlLoop.Start(ctx->ad.SamplingClock * 1e-6,
+                [rig]() { BindRig(rig); },
+                [ctx, pDoc](double) {
+                    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+                    pDoc->AD_INPUT();
+                });
+        }
+        else {
+            ctx->ctrlLoop.Start(ctx->timeSettings.ControlInterval / 1000.0,
+                [rig]() { BindRig(rig); },
+                [ctx, pDoc](double dt) {
+                    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+                    pDoc->ControlTick(dt);
+                });
+        }
     }
 }
 
@@ -459,7 +528,10 @@ void CDigitShowBasicView::OnBUTTONCtrlOff()
     DigitShowContext* ctx = GetContext();
 
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
-    KillTimer(2);
+    ctx->ctrlLoop.Stop();   // before the lock: a step may be waiting for it
+    TraceControlJitter(ctx);
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+    ctx->flags.CtrlRun = FALSE;
     ctx->flags.Ctrl = FALSE;
     CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_CtrlOn);
     CButton* myBTN2 = (CButton*)GetDlgItem(IDC_BUTTON_CtrlOff);
@@ -468,6 +540,55 @@ void CDigitShowBasicView::OnBUTTONCtrlOff()
     pDoc->Stop_Control();
 }
 
+// Header lines of *.tsv, *_v.tsv and *_p.tsv (without "\n")
+static void LogColumns(const DigitShowContext* ctx, CString* physical, CString* voltage, CString* param)
+{
+    static const char* const kPhysical[7] = {
+        "Load_(N)", "Disp.(mm)", "Cell_P.(kPa)", "ECellP.(kPa)", "SP.Vol.(mm3)", "V-LDT1_(mm)", "V-LDT2_(mm)",
+    };
+    static const char* const kParam[AI_NUM_PARAMS] = {
+        "s(a)_(kPa)", "s(r)_(kPa)", "s'(a)(kPa)", "s'(r)(kPa)", "Pore_(kPa)", "p____(kPa)",
+        "q____(kPa)", "p'___(kPa)", "e(a)_(%)_", "e(r)_(%)_", "e(v)_(%)_", "eLDT1(%)_",
+        "eLDT2(%)_", "AvLDT(%)_", "(s'a+s'r)/2", "(s'a-s'r)/2",
+    };
+    CString col;
+    *physical = *voltage = *param = "Time(s)";
+    for (int ch = 0; ch < ctx->ai.channels; ch++) {
+        col.Format("CH%02d_(V)", ch);
+        *voltage  += "\t" + col;
+        *physical += "\t" + ((ch < 7) ? CString(kPhysical[ch]) : col);
+    }
+    for (int i = 0; i < AI_NUM_PARAMS; i++) *param += CString("\t") + kParam[i];
+}
+
+// "info" lines of a binary log header: what the rows were computed with
+static void LogInfo(const DigitShowContext* ctx, std::vector<std::string>* info)
+{
+    const SpecimenData& sp = ctx->specimen;
+    CString line;
+    line = CTime::GetCurrentTime().Format("started\t%Y/%m/%d %H:%M:%S");
+    info->push_back((LPCSTR)line);
+    line.Format("rig\t%d", ctx->RigID + 1);
+    info->push_back((LPCSTR)line);
+    line.Format("save_interval_ms\t%u", ctx->timeSettings.SaveInterval);
+    info->push_back((LPCSTR)line);
+    line.Format("fs_hz\t%g", ctx->ai.filterCfg.FsHz);
+    info->push_back((LPCSTR)line);
+    if (ctx->ai.capture.Active()) {
+        // Raw scans behind the rows: capture file and the scan index at the start
+        line.Format("capture\t%s\t%llu", ctx->ai.capture.Path().c_str(),
+                    (unsigned long long)ctx->ai.scanCount);
+        info->push_back((LPCSTR)line);
+    }
+    for (int ch = 0; ch < ctx->ai.channels; ch++) {
+        line.Format("cal\t%d\t%.10g\t%.10g\t%.10g", ch, ctx->ai.cal.a[ch], ctx->ai.cal.b[ch], ctx->ai.cal.c[ch]);
+        info->push_back((LPCSTR)line);
+    }
+    line.Format("specimen\theight\t%g\tdiameter\t%g\tarea\t%g\tvolume\t%g\tweight\t%g\tvldt1\t%g\tvldt2\t%g\tgs\t%g",
+                sp.Height[0], sp.Diameter[0], sp.Area[0], sp.Volume[0], sp.Weight[0], sp.VLDT1[0], sp.VLDT2[0], sp.Gs);
+    info->push_back((LPCSTR)line);
+}
+
 void CDigitShowBasicView::OnBUTTONStartSave() 
 {
     DigitShowContext* ctx = GetContext();
@@ -476,10 +597,13 @@ void CDigitShowBasicView::OnBUTTONStartSave()
     errno_t err;
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
 
-    CString    pFileName0, pFileName1, pFileName2;
+    CString    pFileName0, pFileName1, pFileName2, pFileName3;
     CFileDialog SaveFile_dlg( FALSE, NULL, "*.tsv",  OFN_CREATEPROMPT | OFN_OVERWRITEPROMPT,
             "TSV Files(*.tsv)|*.tsv| All Files(*.*)|*.*| |",NULL);
     if (SaveFile_dlg.DoModal()==IDOK){
+            // The rig's runner waits while the files are opened
+            std::string logErr;
+            std::unique_lock<std::mutex> lock(ctx->runner.Mutex());
             // File for saving the physical data 
             pFileName1 = SaveFile_dlg.GetPathName();    
             m_FileName =    SaveFile_dlg.GetFileTitle();
@@ -494,96 +618,94 @@ void CDigitShowBasicView::OnBUTTONStartSave()
                 pFileName1.Replace(TmpString,".tsv");
                 m_FileName = m_FileName+_T(".tsv");
             }
-            if((err = fopen_s(&ctx->fpPhysical,(LPCSTR)pFileName1, _T("w"))) == 0)
-            {
-                fprintf(ctx->fpPhysical,"%s\t","Time(s)");
-                fprintf(ctx->fpPhysical,"%s\t","Load_(N)");
-                fprintf(ctx->fpPhysical,"%s\t","Disp.(mm)");
-                fprintf(ctx->fpPhysical,"%s\t","Cell_P.(kPa)");
-                fprintf(ctx->fpPhysical,"%s\t","ECellP.(kPa)");
-                fprintf(ctx->fpPhysical,"%s\t","SP.Vol.(mm3)");
-                fprintf(ctx->fpPhysical,"%s\t","V-LDT1_(mm)");
-                fprintf(ctx->fpPhysical,"%s\t","V-LDT2_(mm)");
-                fprintf(ctx->fpPhysical,"%s\t","CH07_(V)");
-                fprintf(ctx->fpPhysical,"%s\t","CH08_(V)");
-                fprintf(ctx->fpPhysical,"%s\t","CH09_(V)");
-                fprintf(ctx->fpPhysical,"%s\t","CH10_(V)");
-                fprintf(ctx->fpPhysical,"%s\t","CH11_(V)");
-                fprintf(ctx->fpPhysical,"%s\t","CH12_(V)");
-                fprintf(ctx->fpPhysical,"%s\t","CH13_(V)");
-                fprintf(ctx->fpPhysical,"%s\t","CH14_(V)");
-                fprintf(ctx->fpPhysical,"%s\n","CH15_(V)");
-            }
-
-
-            // File for saving the voltage data
+            // Data files: *.tsv (physical), *_v.tsv (voltage), *_p.tsv (parameters),
+            // or with "log binary" one *.dslog the writer thread turns into them
+            // (the TSV files are written directly if it cannot be created)
+            CString colPhysical, colVoltage, colParam;
+            LogColumns(ctx, &colPhysical, &colVoltage, &colParam);
             pFileName0 = pFileName1;
             pFileName0.Replace(".tsv","_v.tsv");
-            if((err = fopen_s(&ctx->fpVoltage,(LPCSTR)pFileName0, _T("w"))) == 0)
-            {
-                fprintf(ctx->fpVoltage,"%s\t","Time(s)");
-                fprintf(ctx->fpVoltage,"%s\t","CH00_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH01_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH02_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH03_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH04_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH05_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH06_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH07_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH08_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH09_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH10_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH11_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH12_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH13_(V)");
-                fprintf(ctx->fpVoltage,"%s\t","CH14_(V)");
-                fprintf(ctx->fpVoltage,"%s\n","CH15_(V)");
+            pFileName2 = pFileName1;
+            pFileName2.Replace(".tsv","_p.tsv");
+            if(ctx->ai.filterCfg.BinaryLog){
+                CString logName = pFileName1;
+                logName.Replace(".tsv",".dslog");
+                LogHeader header;
+                header.Channels = ctx->ai.channels;
+                header.Params   = AI_NUM_PARAMS;
+                header.PhysicalColumns = (LPCSTR)colPhysical;
+                header.VoltageColumns  = (LPCSTR)colVoltage;
+                header.ParamColumns    = (LPCSTR)colParam;
+                LogInfo(ctx, &header.Info);
+                if(!ctx->log.Open((LPCSTR)logName, header, &logErr) && logErr.empty())
+                    logErr = (LPCSTR)logName;
+            }
+            if(!ctx->log.Active()){
+                if((err = fopen_s(&ctx->fpPhysical,(LPCSTR)pFileName1, _T("w"))) == 0)
+                    fprintf(ctx->fpPhysical,"%s\n",(LPCSTR)colPhysical);
+                if((err = fopen_s(&ctx->fpVoltage,(LPCSTR)pFileName0, _T("w"))) == 0)
+                    fprintf(ctx->fpVoltage,"%s\n",(LPCSTR)colVoltage);
+                if((err = fopen_s(&ctx->fpParam,(LPCSTR)pFileName2, _T("w"))) == 0)
+                    fprintf(ctx->fpParam,"%s\n",(LPCSTR)colParam);
             }
 
 
-            // File for saving the parameter data
-            pFileName2 = pFileName1;
-            pFileName2.Replace(".tsv","_p.tsv");
-            if((err = fopen_s(&ctx->fpParam,(LPCSTR)pFileName2, _T("w"))) == 0)
+            // File for saving the per-cycle hysteresis of cyclic loading
+            pFileName3 = pFileName1;
+            pFileName3.Replace(".tsv","_c.tsv");
+            if((err = fopen_s(&ctx->fpCycle,(LPCSTR)pFileName3, _T("w"))) == 0)
             {
-                fprintf(ctx->fpParam,"%s\t","Time(s)");
-                fprintf(ctx->fpParam,"%s\t","s(a)_(kPa)");
-                fprintf(ctx->fpParam,"%s\t","s(r)_(kPa)");
-                fprintf(ctx->fpParam,"%s\t","s'(a)(kPa)");
-                fprintf(ctx->fpParam,"%s\t","s'(r)(kPa)");
-                fprintf(ctx->fpParam,"%s\t","Pore_(kPa)");
-                fprintf(ctx->fpParam,"%s\t","p____(kPa)");
-                fprintf(ctx->fpParam,"%s\t","q____(kPa)");
-                fprintf(ctx->fpParam,"%s\t","p'___(kPa)");
-                fprintf(ctx->fpParam,"%s\t","e(a)_(%)_");
-                fprintf(ctx->fpParam,"%s\t","e(r)_(%)_");
-                fprintf(ctx->fpParam,"%s\t","e(v)_(%)_");
-                fprintf(ctx->fpParam,"%s\t","eLDT1(%)_");
-                fprintf(ctx->fpParam,"%s\t","eLDT2(%)_");
-                fprintf(ctx->fpParam,"%s\t","AvLDT(%)_");
-                fprintf(ctx->fpParam,"%s\t","(s'a+s'r)/2");
-                fprintf(ctx->fpParam,"%s\n","(s'a-s'r)/2");
+                fprintf(ctx->fpCycle,"%s\t","Cycle");
+                fprintf(ctx->fpCycle,"%s\t","Start(s)");
+                fprintf(ctx->fpCycle,"%s\t","End(s)__");
+                fprintf(ctx->fpCycle,"%s\t","q_max(kPa)");
+                fprintf(ctx->fpCycle,"%s\t","q_min(kPa)");
+                fprintf(ctx->fpCycle,"%s\t","e(a)@qmax(%)");
+                fprintf(ctx->fpCycle,"%s\t","e(a)@qmin(%)");
+                fprintf(ctx->fpCycle,"%s\t","DA_(%)___");
+                fprintf(ctx->fpCycle,"%s\t","Esec(MPa)");
+                fprintf(ctx->fpCycle,"%s\t","Damping");
+                fprintf(ctx->fpCycle,"%s\t","ru");
+                fprintf(ctx->fpCycle,"%s\n","ru_max");
             }
 // Timer starts
-            SetTimer(3,ctx->timeSettings.SaveInterval,NULL);
+            if(ctx->RigID == 0) SetTimer(3,ctx->timeSettings.SaveInterval,NULL);
+            m_RigFileName[ctx->RigID] = m_FileName;
             ctx->NowTime = ctx->NowTime.GetCurrentTime();
             ctx->StartTime = ctx->NowTime;
             ctx->SpanTime = ctx->NowTime- ctx->StartTime;
             ctx->SequentTime1 = (long)ctx->SpanTime.GetTotalSeconds();
-            _ftime_s(&NowTime2);
-            StartTime2 = NowTime2;
-            ctx->SequentTime2 = double(NowTime2.time-StartTime2.time)+double( (NowTime2.millitm-StartTime2.millitm)/1000.0 );
-            ctx->flags.SaveData = TRUE;
+            _ftime_s(&ctx->NowTime2);
+            ctx->StartTime2 = ctx->NowTime2;
+            ctx->SequentTime2 = double(ctx->NowTime2.time-ctx->StartTime2.time)+double( (ctx->NowTime2.millitm-ctx->StartTime2.millitm)/1000.0 );
             CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_StartSave);
             CButton* myBTN2 = (CButton*)GetDlgItem(IDC_BUTTON_StopSave);
             CButton* myBTN3 = (CButton*)GetDlgItem(IDC_BUTTON_InterceptSave);
             myBTN1->EnableWindow(FALSE);    
             myBTN2->EnableWindow(TRUE);
             myBTN3->EnableWindow(TRUE);
-            if(ctx->flags.SetBoard)    pDoc -> AD_INPUT();
-            pDoc -> Cal_Physical();
+            if(ctx->flags.SetBoard){
+                pDoc -> AD_INPUT();
+                ctx->ai.faults.TakeGaps(NULL);      // gaps before the first row are not logged
+                ctx->ai.saveTime0 = ctx->ai.saveDec.Ready()
+                    ? ctx->ai.saveDec.OutputTime()
+                    : ctx->ai.clock.ScanTime(ctx->ai.scanCount);
+                ctx->SequentTime2 = 0.0;
+                pDoc -> Cal_Physical(ctx->ai.saveDec.Output());
+            }
+            else{
+                pDoc -> Cal_Physical();
+            }
+            // From here on AD_INPUT() logs every saveDec output after saveTime0
+            ctx->flags.SaveData = TRUE;
             pDoc -> Cal_Param();
             pDoc -> SaveToFile();
+            lock.unlock();
+            if(!logErr.empty()){
+                CString msgStr;
+                msgStr.Format("バイナリ記録ファイルを作成できません。TSV ファイルに直接記録します。\n%s", logErr.c_str());
+                AfxMessageBox(msgStr, MB_ICONWARNING | MB_OK);
+            }
     }
 }
 
@@ -592,17 +714,31 @@ void CDigitShowBasicView::OnBUTTONStopSave()
     DigitShowContext* ctx = GetContext();
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
 
+    bool logClosed = false;
+    std::unique_lock<std::mutex> lock(ctx->runner.Mutex());
     if(ctx->flags.SaveData==TRUE){
-        KillTimer(3);
-        _ftime_s(&NowTime2);
-        ctx->SequentTime2 = double(NowTime2.time-StartTime2.time)+double( (NowTime2.millitm-StartTime2.millitm)/1000.0 );
-        if(ctx->flags.SetBoard)    pDoc -> AD_INPUT();
+        if(ctx->RigID == 0) KillTimer(3);
+        _ftime_s(&ctx->NowTime2);
+        ctx->SequentTime2 = double(ctx->NowTime2.time-ctx->StartTime2.time)+double( (ctx->NowTime2.millitm-ctx->StartTime2.millitm)/1000.0 );
+        if(ctx->flags.SetBoard){
+            pDoc -> AD_INPUT();
+            ctx->SequentTime2 = ctx->ai.clock.ScanTime(ctx->ai.scanCount) - ctx->ai.saveTime0;
+        }
         pDoc -> Cal_Physical();
         pDoc -> Cal_Param();
         pDoc -> SaveToFile();
-        fclose(ctx->fpVoltage);
-        fclose(ctx->fpPhysical);
-        fclose(ctx->fpParam);
+        if(ctx->log.Active()){
+            ctx->log.Close(true);
+            logClosed = true;
+            // the writer thread finishes the file and converts it to the TSV files
+        }
+        else{
+            fclose(ctx->fpVoltage);
+            fclose(ctx->fpPhysical);
+            fclose(ctx->fpParam);
+        }
+        if(ctx->fpCycle != nullptr) fclose(ctx->fpCycle);
+        ctx->fpCycle = nullptr;
         CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_StartSave);
         CButton* myBTN2 = (CButton*)GetDlgItem(IDC_BUTTON_StopSave);    
         CButton* myBTN3 = (CButton*)GetDlgItem(IDC_BUTTON_InterceptSave);
@@ -611,16 +747,32 @@ void CDigitShowBasicView::OnBUTTONStopSave()
         myBTN3->EnableWindow(FALSE);    
         ctx->flags.SaveData = FALSE;
     }
+    lock.unlock();
+
+    // Report lost records once the last batch is on disk, outside the rig lock
+    if(logClosed && ctx->log.WaitClosed(2.0 * LOG_FLUSH_SEC)
+       && (ctx->log.Failed() > 0 || ctx->log.Dropped() > 0)){
+        CString msgStr;
+        msgStr.Format("記録ファイルに書き込めなかったデータがあります。\n"
+                      "書き込み %llu 行, 書き込み失敗 %llu 行, キューあふれ %llu 行",
+                      (unsigned long long)ctx->log.Written(), (unsigned long long)ctx->log.Failed(),
+                      (unsigned long long)ctx->log.Dropped());
+        AfxMessageBox(msgStr, MB_ICONWARNING | MB_OK);
+    }
 }
 
 void CDigitShowBasicView::OnBUTTONInterceptSave() 
 {
     DigitShowContext* ctx = GetContext();
     CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     
-    _ftime_s(&NowTime2);
-    ctx->SequentTime2 = double(NowTime2.time-StartTime2.time)+double( (NowTime2.millitm-StartTime2.millitm)/1000.0 );    
-    if(ctx->flags.SetBoard)    pDoc -> AD_INPUT();
+    _ftime_s(&ctx->NowTime2);
+    ctx->SequentTime2 = double(ctx->NowTime2.time-ctx->StartTime2.time)+double( (ctx->NowTime2.millitm-ctx->StartTime2.millitm)/1000.0 );    
+    if(ctx->flags.SetBoard){
+        pDoc -> AD_INPUT();
+        ctx->SequentTime2 = ctx->ai.clock.ScanTime(ctx->ai.scanCount) - ctx->ai.saveTime0;
+    }
     pDoc -> Cal_Physical();
     pDoc -> Cal_Param();
     pDoc -> SaveToFile();    
@@ -628,48 +780,224 @@ void CDigitShowBasicView::OnBUTTONInterceptSave()
 
 LRESULT CDigitShowBasicView::DefWindowProc(UINT message, WPARAM wParam, LPARAM lParam) 
 {
-    DigitShowContext* ctx = GetContext();
-    long    Ret, Ret2;
-    char    errStr[256];
-    CString msgStr;
+    // AD event messages come from rig 0's board (the other rigs poll)
+    DigitShowContext* ctx = GetRigContext(0);
 
     switch(message){
     case AIOM_AIE_DATA_NUM:
     {
-        long tmp = 0;
-        Ret = AioGetAiSamplingCount(ctx->ad.Id, &tmp);
-        if (tmp <= 0) return TRUE;
-
-        Ret = AioGetAiSamplingData(ctx->ad.Id, &tmp, ctx->ad.Data0.data());
-        if (Ret != 0) {
-            Ret2 = AioGetErrorString(Ret, errStr);
-            msgStr.Format("AioGetAiSamplingData = %d : %s", Ret, errStr);
-            AfxMessageBox(msgStr, MB_ICONSTOP | MB_OK);
-            return TRUE;
+        RigScope rig0(0);
+        // Handler cost and the latency of the oldest scan of this burst
+        // drive the burst size (BurstTuner)
+        const uint64_t first = ctx->ai.ring.Written();
+        const double t0 = ctx->ai.clock.HostNow();
+        ReadAiData();
+        const double t1 = ctx->ai.clock.HostNow();
+        ctx->ai.clock.Observe(ctx->ai.ring.Written());
+        if (ctx->ai.ring.Written() > first) {
+            ctx->ad.Tuner.Observe(t1 - t0, t1 - ctx->ai.clock.HostTime(first));
+            long burst = 0;
+            if (ctx->ad.Tuner.Propose(t1, !ctx->flags.SaveData, &burst)) ApplyBurst(burst);
         }
-        ctx->ad.LastDataCount = tmp;   // store for AD_INPUT()
         return TRUE;
     }
+    // Board faults are queued and recovered here without a message box:
+    // a modal loop would stall this handler and cause further overflows.
+    // UpdateAiStatus() (timer 1) reports them in the status bar.
     case AIOM_AIE_OFERR:
-        if(ctx->ad.Id >= 0){
-            Ret = AioResetAiMemory(ctx->ad.Id);
-            Ret = AioStartAi(ctx->ad.Id);
-        }
-        AfxMessageBox("Sampling overflowed and restarted automatically.", MB_OK | MB_ICONSTOP, 0);    
+    {
+        RigScope rig0(0);
+        RecoverAi(AI_FAULT_OVERFLOW, 0);
         return TRUE;
+    }
     case AIOM_AIE_SCERR:
-        AfxMessageBox("Sampling error.", MB_OK | MB_ICONSTOP, 0);    
+    {
+        RigScope rig0(0);
+        RecoverAi(AI_FAULT_SAMPLING, 0);
         return TRUE;
+    }
     case AIOM_AIE_ADERR:
-        AfxMessageBox("A/D conversion error.", MB_OK | MB_ICONSTOP, 0);    
+    {
+        RigScope rig0(0);
+        RecoverAi(AI_FAULT_CONVERSION, 0);
         return TRUE;
+    }
     case AIOM_AIE_END:
-        AfxMessageBox("Sampling ended.", MB_OK | MB_ICONSTOP, 0);    
+    {
+        AiFaultEvent e = {};
+        e.Kind = AI_FAULT_END;
+        e.Scan = ctx->ai.ring.Written();
+        e.GapStart = e.GapEnd = ctx->ai.clock.ScanTime(e.Scan);
+        ctx->ai.faults.Post(e);
+        ctx->ai.faults.SetStopped(true);
         return TRUE;
+    }
     }    
     return CFormView::DefWindowProc(message, wParam, lParam);
 }
 
+// Move everything the board holds into ai.ring; Data0 is only a
+// staging buffer of one burst, so read in chunks of its size.
+void CDigitShowBasicView::ReadAiData()
+{
+    DigitShowContext* ctx = GetContext();
+    long Ret;
+    const long chunk = long(ctx->ad.Data0.size() / DSP_AD_CHANNELS);
+    long pending = 0;
+    Ret = ctx->ad.Dev->GetAiSamplingCount(&pending);
+    ctx->ad.LastDataCount = 0;
+    while (Ret == 0 && pending > 0 && chunk > 0) {
+        long tmp = (pending < chunk) ? pending : chunk;
+        Ret = ctx->ad.Dev->GetAiSamplingData(&tmp, ctx->ad.Data0.data());
+        if (Ret != 0) {
+            // Data stays on the board; the next event retries
+            AiFaultEvent e = {};
+            e.Kind = AI_FAULT_READ;
+            e.Code = Ret;
+            e.Scan = ctx->ai.ring.Written();
+            e.GapStart = e.GapEnd = ctx->ai.clock.ScanTime(e.Scan);
+            ctx->ai.faults.Post(e);
+            break;
+        }
+        if (tmp <= 0) break;
+        const uint64_t next = ctx->ai.ring.Written();
+        const size_t stored = ctx->ai.ring.Push(ctx->ad.Data0.data(), static_cast<size_t>(tmp));
+        if (stored < static_cast<size_t>(tmp)) {
+            AiFaultEvent e = {};
+            e.Kind = AI_FAULT_RING;
+            e.Scan = next + stored;
+            e.Lost = static_cast<uint64_t>(tmp) - stored;
+            e.GapStart = ctx->ai.clock.ScanTime(e.Scan);
+            ctx->ai.clock.Skip(e.Scan, e.Lost);
+            e.GapEnd = ctx->ai.clock.ScanTime(e.Scan);
+            ctx->ai.faults.Post(e);
+        }
+        ctx->ad.LastDataCount += tmp;
+        pending -= tmp;
+    }
+}
+
+// Change the event burst size. The board only accepts it while stopped:
+// stop, drain what it holds, resize, restart; the few ms in between are
+// logged as a gap like any other restart.
+void CDigitShowBasicView::ApplyBurst(long burst)
+{
+    DigitShowContext* ctx = GetContext();
+    long Ret = ctx->ad.Dev->StopAi();
+    ReadAiData();
+    const uint64_t next = ctx->ai.ring.Written();
+    AiFaultEvent e = {};
+    e.Kind = AI_FAULT_RETUNE;
+    e.Scan = next;
+    e.GapStart = ctx->ai.clock.ScanTime(next);
+    Ret = ctx->ad.Dev->SetAiEventSamplingTimes(burst);
+    if (Ret == 0) Ret = ctx->ad.Dev->GetAiEventSamplingTimes(&ctx->ad.SamplingTimes);
+    ctx->ad.Data0.resize(static_cast<size_t>(ctx->ad.SamplingTimes) * DSP_AD_CHANNELS);
+    Ret = ctx->ad.Dev->StartAi();
+    if (Ret != 0) {
+        RecoverAi(AI_FAULT_RETUNE, Ret);
+        return;
+    }
+    ctx->ai.clock.Restart(next);
+    e.GapEnd = ctx->ai.clock.ScanTime(next);
+    e.Recovered = true;
+    const double period = ctx->ai.clock.ScanPeriod();
+    if (period > 0.0) e.Lost = uint64_t((e.GapEnd - e.GapStart) / period + 0.5);
+    ctx->ai.faults.Post(e);
+    ctx->ad.Tuner.Applied(ctx->ad.SamplingTimes, ctx->ai.clock.HostNow());
+}
+
+// Restart acquisition after a board fault and queue a gap record covering
+// the scans lost in between. Gives up (StopAi) when AllowRestart() refuses.
+void CDigitShowBasicView::RecoverAi(int kind, long code)
+{
+    DigitShowContext* ctx = GetContext();
+    AiFaultEvent e = {};
+    e.Kind = kind;
+    e.Code = code;
+    e.Scan = ctx->ai.ring.Written();
+    e.GapStart = e.GapEnd = ctx->ai.clock.ScanTime(e.Scan);
+    if (ctx->ad.Dev && !ctx->ai.faults.Stopped()) {
+        if (ctx->ai.faults.AllowRestart(ctx->ai.clock.HostNow())) {
+            long Ret = ctx->ad.Dev->StopAi();
+            Ret = ctx->ad.Dev->ResetAiMemory();
+            if (Ret == 0) Ret = ctx->ad.Dev->StartAi();
+            if (Ret == 0) {
+                ctx->ai.clock.Restart(e.Scan);
+                e.GapEnd = ctx->ai.clock.ScanTime(e.Scan);
+                e.Recovered = true;
+            }
+            else {
+                e.Code = Ret;
+            }
+        }
+        if (!e.Recovered) {
+            ctx->ad.Dev->StopAi();
+            ctx->ai.faults.SetStopped(true);
+        }
+    }
+    const double period = ctx->ai.clock.ScanPeriod();
+    if (period > 0.0) e.Lost = uint64_t((e.GapEnd - e.GapStart) / period + 0.5);
+    ctx->ai.faults.Post(e);
+}
+
+// Non-modal acquisition status (status bar): fault counters, lost time,
+// clock drift, event burst size with its latency and overflow margin
+void CDigitShowBasicView::UpdateAiStatus()
+{
+    DigitShowContext* ctx = GetContext();
+    if (!ctx->flags.SetBoard) return;
+    AiFaultLog& f = ctx->ai.faults;
+    f.Drain([&](const AiFaultEvent& e) {
+        CTime now = CTime::GetCurrentTime();
+        m_AiLastFault.Format("last: %s %s%s", (LPCTSTR)now.Format("%H:%M:%S"),
+                             AiFaultLog::KindName(e.Kind),
+                             e.Recovered ? " (restarted)" : "");
+        TRACE("AI fault: %s code=%ld scan=%llu lost=%llu\n", AiFaultLog::KindName(e.Kind),
+              e.Code, (unsigned long long)e.Scan, (unsigned long long)e.Lost);
+    });
+    CString text;
+    if (GetRigContext(1)->runner.Running()) text.Format("Rig %d | ", ctx->RigID + 1);
+    text.AppendFormat("AI %s | OF %llu  SC %llu  AD %llu  RD %llu  RING %llu | lost %.3f s | drift %+.1f ppm",
+                f.Stopped() ? "STOPPED" : "running",
+                (unsigned long long)f.Count(AI_FAULT_OVERFLOW),
+                (unsigned long long)f.Count(AI_FAULT_SAMPLING),
+                (unsigned long long)f.Count(AI_FAULT_CONVERSION),
+                (unsigned long long)f.Count(AI_FAULT_READ),
+                (unsigned long long)f.Count(AI_FAULT_RING),
+                f.LostSeconds(), ctx->ai.clock.DriftPpm());
+    const BurstTuner& tn = ctx->ad.Tuner;
+    CString burst;
+    burst.Format(" | burst %ld (%.0f ms) latency %.0f/%.0f ms margin %.1fx",
+                 tn.Burst(), tn.BurstPeriod() * 1000.0,
+                 tn.Latency() * 1000.0, tn.LatencyMax() * 1000.0, tn.Margin());
+    text += burst;
+    if (ctx->ctrlLoop.Running()) {
+        const ControlLoop::Stats cs = ctx->ctrlLoop.GetStats();
+        CString ctrl;
+        ctrl.Format(" | ctrl %s%.1f ms late p99 %.2f max %.2f ms miss %llu",
+                    ctx->ai.filterCfg.SyncControl ? "sync " : "", cs.Period * 1000.0, ControlLoop::LatePercentile(cs, 0.99) * 1000.0,
+                    cs.LateMax * 1000.0, (unsigned long long)cs.Missed);
+        text += ctrl;
+    }
+    if (ctx->ai.worker.Running()) {
+        CString poll;
+        poll.Format(" | poll restarts %llu drop %llu", (unsigned long long)ctx->ai.worker.Restarts(),
+                    (unsigned long long)ctx->ai.ring.Dropped());
+        text += poll;
+    }
+    for (size_t b = 0; b < ctx->ad.Aux.size(); b++) {
+        const AiAuxBoard& x = *ctx->ad.Aux[b];
+        CString aux;
+        aux.Format(" | %s restarts %llu drop %llu", x.Name.c_str(),
+                   (unsigned long long)x.worker.Restarts(), (unsigned long long)x.ring.Dropped());
+        text += aux;
+    }
+    if (!m_AiLastFault.IsEmpty()) text += " | " + m_AiLastFault;
+    CMainFrame* pFrame = static_cast<CMainFrame*>(GetParentFrame());
+    if (pFrame) pFrame->SetAiStatus(text);
+}
+
 
 void CDigitShowBasicView::OnBUTTONSetCtrlID() 
 {
@@ -677,6 +1005,7 @@ void CDigitShowBasicView::OnBUTTONSetCtrlID()
     CString        tmp;
     CComboBox* m_Combo1 = (CComboBox*)GetDlgItem(IDC_COMBO_Control_ID);
     m_Combo1->GetWindowText(tmp);
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->ControlID = atoi(tmp);
 }
 
@@ -686,6 +1015,9 @@ void CDigitShowBasicView::OnBUTTONSetTimeInterval()
     CString        tmp;
     CComboBox* m_Combo1 = (CComboBox*)GetDlgItem(IDC_COMBO_SamplingTime);
     m_Combo1->GetWindowText(tmp);
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+    if(tmp=="0.05 s")    ctx->timeSettings.SaveInterval = 50;
+    if(tmp=="0.1 s")    ctx->timeSettings.SaveInterval = 100;
     if(tmp=="0.2 s")    ctx->timeSettings.SaveInterval = 200;
     if(tmp=="0.5 s")    ctx->timeSettings.SaveInterval = 500;
     if(tmp=="1.0 s")    ctx->timeSettings.SaveInterval = 1000;
@@ -700,10 +1032,110 @@ void CDigitShowBasicView::OnBUTTONSetTimeInterval()
     if(tmp=="3.0 min")    ctx->timeSettings.SaveInterval = 180000;
     if(tmp=="5.0 min")    ctx->timeSettings.SaveInterval = 300000;
     if(tmp=="10.0 min")    ctx->timeSettings.SaveInterval = 600000;
-    if(ctx->flags.SaveData){
+    if(ctx->flags.SaveData && ctx->RigID == 0){
         KillTimer(3);
         SetTimer(3,ctx->timeSettings.SaveInterval,NULL);
     }    
 }
 
+// Rigs 2..MAX_RIGS: opened when their filter configuration file exists,
+// then driven by their own RigRunner thread (no window, no AD events)
+void CDigitShowBasicView::StartRigs()
+{
+    CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
+    for (int r = 1; r < MAX_RIGS; r++) {
+        if (!FilterConfigExists(GetFilterConfigPath(r))) continue;
+        RigScope rig(r);
+        DigitShowContext* ctx = GetContext();
+        pDoc->OpenBoard();
+        if (!ctx->flags.SetBoard) continue;
+        StartAcquisition(false);
+        ctx->runner.Add([ctx]() { return ctx->timeSettings.DisplayInterval; },
+                        [pDoc]() { pDoc->AcquireTick(); });
+        ctx->runner.Add([ctx]() { return ctx->flags.SaveData ? ctx->timeSettings.SaveInterval : 0u; },
+                        [pDoc]() { pDoc->SaveTick(); });
+        ctx->runner.Start([r]() { BindRig(r); });
+    }
+}
+
+void CDigitShowBasicView::StopRigs()
+{
+    CDigitShowBasicDoc* pDoc = (CDigitShowBasicDoc *)GetDocument();
+    for (int r = MAX_RIGS - 1; r > 0; r--) {
+        DigitShowContext* ctx = GetRigContext(r);
+        ctx->ctrlLoop.Stop();
+        ctx->runner.Stop();
+        if (!ctx->flags.SetBoard) continue;
+        RigScope rig(r);
+        if (ctx->flags.SaveData) {
+            if (ctx->log.Active()) {
+                ctx->log.Close(true);
+            }
+            else {
+                fclose(ctx->fpVoltage);
+                fclose(ctx->fpPhysical);
+                fclose(ctx->fpParam);
+            }
+            if (ctx->fpCycle != nullptr) fclose(ctx->fpCycle);
+            ctx->fpCycle = nullptr;
+            ctx->flags.SaveData = FALSE;
+        }
+        pDoc->CloseBoard();
+    }
+    BindRig(0);
+}
+
+// Rig menu: show and operate another rig; its threads keep running
+void CDigitShowBasicView::SelectRig(int rig)
+{
+    DigitShowContext* ctx = GetRigContext(rig);
+    if (ctx == nullptr || (rig > 0 && !ctx->runner.Running())) return;
+    BindRig(rig);
+    m_AiLastFault.Empty();
+    m_FileName = m_RigFileName[rig];
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+    UpdateRigButtons();
+    ShowData();
+    UpdateAiStatus();
+}
+
+// Control loop lateness histogram of the run just stopped (debug output)
+void CDigitShowBasicView::TraceControlJitter(DigitShowContext* ctx)
+{
+    const ControlLoop::Stats cs = ctx->ctrlLoop.GetStats();
+    if (cs.Ticks == 0) return;
+    TRACE("Rig %d control %.1f ms: %llu steps, %llu missed, late mean %.3f max %.3f ms, step max %.3f ms\n",
+          ctx->RigID + 1, cs.Period * 1000.0, (unsigned long long)cs.Ticks, (unsigned long long)cs.Missed,
+          cs.LateMean * 1000.0, cs.LateMax * 1000.0, cs.StepMax * 1000.0);
+    for (int i = 0; i < ControlLoop::kJitterBins; i++) {
+        TRACE("  late < %8.3f ms: %llu\n", ControlLoop::JitterBinEdge(i) * 1000.0,
+              (unsigned long long)cs.Hist[i]);
+    }
+    if (ctx->ai.capture.Active()) {
+        TRACE("Rig %d raw capture: %llu scans, %llu bytes written, %llu scans dropped\n",
+              ctx->RigID + 1, (unsigned long long)ctx->ai.capture.Scans(),
+              (unsigned long long)ctx->ai.capture.Bytes(), (unsigned long long)ctx->ai.capture.Dropped());
+    }
+    if (ctx->log.Written() > 0 || ctx->log.Failed() > 0) {
+        TRACE("Rig %d log: %llu records written, %llu dropped, %llu failed, batch write max %.3f ms\n",
+              ctx->RigID + 1, (unsigned long long)ctx->log.Written(), (unsigned long long)ctx->log.Dropped(),
+              (unsigned long long)ctx->log.Failed(), ctx->log.WriteMax() * 1000.0);
+    }
+    const DaOutputStage::Stats ds = ctx->da.Out.GetStats();
+    TRACE("Rig %d DA: %llu requests, %llu writes, %llu skipped, %llu slew-limited, %llu errors (last %ld), write mean %.3f max %.3f ms\n",
+          ctx->RigID + 1, (unsigned long long)ds.Requests, (unsigned long long)ds.Writes,
+          (unsigned long long)ds.Skipped, (unsigned long long)ds.Limited, (unsigned long long)ds.Errors,
+          ds.LastError, ds.WriteMean * 1000.0, ds.WriteMax * 1000.0);
+}
+
+void CDigitShowBasicView::UpdateRigButtons()
+{
+    DigitShowContext* ctx = GetContext();
+    GetDlgItem(IDC_BUTTON_CtrlOn)->EnableWindow(ctx->flags.SetBoard && !ctx->flags.CtrlRun);
+    GetDlgItem(IDC_BUTTON_CtrlOff)->EnableWindow(ctx->flags.CtrlRun);
+    GetDlgItem(IDC_BUTTON_StartSave)->EnableWindow(!ctx->flags.SaveData);
+    GetDlgItem(IDC_BUTTON_StopSave)->EnableWindow(ctx->flags.SaveData);
+    GetDlgItem(IDC_BUTTON_InterceptSave)->EnableWindow(ctx->flags.SaveData);
+}
+
 
@@ -52,11 +52,11 @@ public:
 
 public:
     CDigitShowBasicDoc* GetDocument();
-    struct _timeb StartTime2, NowTime2;
-    struct _timeb StepTime0, StepTime1;
     CBrush* m_pEditBrush;
     CBrush* m_pStaticBrush;
     CBrush* m_pDlgBrush;
+    CString m_AiLastFault;
+    CString m_RigFileName[MAX_RIGS];
 
 public:
     virtual BOOL PreCreateWindow(CREATESTRUCT& cs);
@@ -68,6 +68,16 @@ protected:
 
 public:
     void ShowData();
+    void RecoverAi(int kind, long code);
+    void ReadAiData();
+    void ApplyBurst(long burst);
+    void UpdateAiStatus();
+    void StartAcquisition(bool events);
+    void StartRigs();
+    void StopRigs();
+    void SelectRig(int rig);
+    void UpdateRigButtons();
+    void TraceControlJitter(DigitShowContext* ctx);
     virtual ~CDigitShowBasicView();
 
 #ifdef _DEBUG
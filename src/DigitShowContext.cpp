@@ -19,17 +19,34 @@
 #include "stdafx.h"
 #include "DigitShowContext.h"
 
-// Singleton instance
-static DigitShowContext g_Context;
-static bool g_ContextInitialized = false;
+// One context per rig; each thread works on the rig it is bound to
+static DigitShowContext g_Rigs[MAX_RIGS];
+static std::once_flag   g_RigInit[MAX_RIGS];
+static thread_local int t_Rig = 0;
+
+DigitShowContext* GetRigContext(int rig)
+{
+    if (rig < 0 || rig >= MAX_RIGS) return nullptr;
+    std::call_once(g_RigInit[rig], [rig]() {
+        InitContext(&g_Rigs[rig]);
+        g_Rigs[rig].RigID = rig;
+    });
+    return &g_Rigs[rig];
+}
 
 DigitShowContext* GetContext()
 {
-    if (!g_ContextInitialized) {
-        InitContext(&g_Context);
-        g_ContextInitialized = true;
-    }
-    return &g_Context;
+    return GetRigContext(t_Rig);
+}
+
+void BindRig(int rig)
+{
+    if (rig >= 0 && rig < MAX_RIGS) t_Rig = rig;
+}
+
+int BoundRig()
+{
+    return t_Rig;
 }
 
 void InitContext(DigitShowContext* ctx)
@@ -39,18 +56,30 @@ void InitContext(DigitShowContext* ctx)
     // Initialize A/D board config (zero all POD fields)
     ctx->ad = {};
     
-    // Initialize D/A board config
-    memset(&ctx->da, 0, sizeof(ctx->da));
+    // Initialize D/A board config (da.Out is detached until OpenBoard)
+    ctx->da.Dev.reset();
+    ctx->da.Channels   = 0;
+    ctx->da.Range      = 0;
+    ctx->da.RangeMax   = 0.0f;
+    ctx->da.RangeMin   = 0.0f;
+    ctx->da.Resolution = 0;
+    ctx->da.Out.Detach();
 
     ctx->ad.LastDataCount = 0;
 
     // Initialize digital filter state (20Hz-B: MA5 × MA6 @ 300 sps)
     memset(&ctx->ai.dsp, 0, sizeof(ctx->ai.dsp));
+    SetDefaultFilterConfig(&ctx->ai.filterCfg, DSP_FS_HZ);
+    ctx->ai.dsp.SetTaps(ctx->ai.filterCfg.Ma1Taps, ctx->ai.filterCfg.Ma2Taps);
+    ctx->ai.chainActive = false;
+    ctx->ai.scanCount = 0;
+    ctx->ai.saveTime0 = 0.0;
 
     // Initialize flags
     ctx->flags.SetBoard  = false;
     ctx->flags.HasDA     = false;
     ctx->flags.SaveData  = false;
+    ctx->flags.CtrlRun   = false;
     ctx->flags.Cyclic    = false;
     ctx->flags.Ctrl      = false;
 
@@ -59,6 +88,11 @@ void InitContext(DigitShowContext* ctx)
     ctx->NumCyclic = 0;
     ctx->TotalStepTime = 0.0;
     ctx->AmpID = 0;
+    ctx->pid.Key = -1;
+    ctx->wave.Amplitude = 0.0;
+    ctx->wave.QMin = ctx->wave.QMax = 0.0;
+    ctx->cycle.Analyzer.Reset();
+    ctx->cycle.Key = -1;
 
     // Initialize time values
     ctx->SequentTime1 = 0;
@@ -93,14 +127,18 @@ void InitContext(DigitShowContext* ctx)
     ctx->fpVoltage  = nullptr;
     ctx->fpPhysical = nullptr;
     ctx->fpParam    = nullptr;
+    ctx->fpCycle    = nullptr;
 
     // Initialize calibration factors (default: linear y = x)
+    ctx->ai.channels = DSP_AD_CHANNELS;
     for (int i = 0; i < AI_MAX_CHANNELS; i++) {
         ctx->ai.raw[i] = 0.0f;
         ctx->ai.phy[i] = 0.0;
+    }
+    for (int i = 0; i < AI_NUM_PARAMS; i++) {
         ctx->ai.param[i] = 0.0;
     }
-    for (int i = 0; i < NUM_PARAM_MAX; i++) {
+    for (int i = 0; i < AI_MAX_CHANNELS; i++) {
         ctx->ai.cal.a[i] = 0.0;
         ctx->ai.cal.b[i] = 1.0;
         ctx->ai.cal.c[i] = 0.0;
@@ -159,12 +197,15 @@ void InitContext(DigitShowContext* ctx)
 
     // Initialize control file data
     ctx->controlFile.CurrentNum = 0;
-    for (int i = 0; i < 128; i++) {
+    for (int i = 0; i < CONTROL_FILE_STEPS; i++) {
         ctx->controlFile.Num[i] = 0;
-        for (int j = 0; j < 10; j++) {
+        for (int j = 0; j < CONTROL_FILE_PARAS; j++) {
             ctx->controlFile.Para[i][j] = 0.0;
         }
     }
+    ctx->controlFile.Script.clear();
+    ctx->controlFile.Revision = 0;
+    ctx->program.Revision = -1;
 
     // Pre-consolidation control defaults
     ctx->control[1].MotorSpeed = 1000.0;
@@ -22,11 +22,38 @@
 #pragma once
 
 #include <afxwin.h>
+#include <sys/timeb.h>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
-#define NUM_PARAM_MAX    16  // Number of calibration parameter sets (cal.a/b/c array size)
-#define AI_MAX_CHANNELS  16  // Maximum number of analog input channels (ai_raw / ai_phy array size)
+#include "AiBoardWorker.h"
+#include "AiFaultLog.h"
+#include "AioDevice.h"
+#include "BurstTuner.h"
+#include "ControlLoop.h"
+#include "ControlProgram.h"
+#include "DataLog.h"
+#include "CycleAnalyzer.h"
+#include "DaOutput.h"
+#include "DspFilter.h"
+#include "FilterChain.h"
+#include "FilterHistory.h"
+#include "PidController.h"
+#include "RateDecimator.h"
+#include "RawCapture.h"
+#include "RigRunner.h"
+#include "SampleClock.h"
+#include "ScanRing.h"
+#include "StrainRate.h"
+#include "TsvFormat.h"
+
+#define NUM_PARAM_MAX    16  // Channels shown in the calibration dialog (AmpID range)
+#define AI_MAX_CHANNELS  DSP_MAX_CHANNELS  // Maximum analog input channels, all boards (ai.raw / phy / cal size)
+#define AI_NUM_PARAMS    16  // Derived parameters (ai.param size)
 #define AO_MAX_CHANNELS   8  // Maximum number of analog output channels (ao_raw array size)
+#define MAX_RIGS          4  // Test rigs (triaxial cells) driven by one process
 
 // D/A channel index assignments (fixed hardware wiring)
 #define DA_CH_MOTOR         0    // Motor on/off (5V = on)
@@ -35,13 +62,13 @@
 #define DA_CH_EP_CELL       3    // Cell pressure [V]
 
 // ── Digital Filter / Board Constants ──────────────────────
-#define DSP_AD_CHANNELS   16     // Number of AD channels used (hard limit)
+// (DSP_AD_CHANNELS and the MA tap counts live in DspFilter.h)
 #define DSP_DA_CHANNELS    8     // Number of DA channels used (= AO_MAX_CHANNELS)
-#define DSP_FS_HZ        300     // AD sampling rate [sps/ch]
-#define DSP_MA1_TAPS       5     // Stage-1 MA taps  → notch at Fs/5 = 60 Hz
-#define DSP_MA2_TAPS       6     // Stage-2 MA taps  → notch at Fs/6 = 50 Hz
-// Group delay = (MA1_TAPS-1 + MA2_TAPS-1) / (2*Fs) = 15 ms
-// -3dB ~ 18 Hz
+#define DSP_FS_HZ        300     // Default AD sampling rate [sps/ch] (ai.filterCfg.FsHz at run time)
+#define DSP_RING_SECONDS  60     // Raw scan ring depth [s] between AD event and AD_INPUT()
+#define DSP_CTRL_DEC_WINDOWS 1   // Control-rate decimator: block mean (delay = ControlInterval/2)
+#define DSP_SAVE_DEC_WINDOWS 4   // Logging-rate decimator: 4-period windowed sinc
+#define DSP_AUX_WAIT_SECONDS 1.0 // AD_INPUT() waits this long for a secondary board's scan
 // ScanClock = 1e6 / (DSP_FS_HZ * DSP_AD_CHANNELS) = 208.33 µs/ch
 
 /**
@@ -108,21 +135,12 @@ struct PhysicalValues {
     double eLDT2;   // LDT2 strain
 };
 
-/**
- * Control file data
- */
-struct ControlFileData {
-    int    CurrentNum;
-    int    Num[128];
-    double Para[128][10];
-};
-
 /**
  * Time settings
  */
 struct TimeSettings {
     unsigned int DisplayInterval;   // ms — Timer 1: AD acquire + display
-    unsigned int ControlInterval;   // ms — Timer 2: control feedback
+    unsigned int ControlInterval;   // ms — control loop period (ctrlLoop)
     unsigned int SaveInterval;      // ms — Timer 3: data file write
 };
 
@@ -139,18 +157,16 @@ struct ErrorTolerance {
 };
 
 /**
- * Cascaded sliding-window MA filter state (20Hz-B design)
- * Stage 1: MA(DSP_MA1_TAPS) — 60 Hz notch
- * Stage 2: MA(DSP_MA2_TAPS) — 50 Hz notch
+ * Secondary AD board (filter config "boards" after the first): channels
+ * 16b..16b+15 of the merged scan, acquired by its own worker thread.
  */
-struct DspFilter {
-    float  ma1_buf[AI_MAX_CHANNELS][DSP_MA1_TAPS];
-    double ma1_sum[AI_MAX_CHANNELS];
-    int    ma1_idx[AI_MAX_CHANNELS];
-
-    float  ma2_buf[AI_MAX_CHANNELS][DSP_MA2_TAPS];
-    double ma2_sum[AI_MAX_CHANNELS];
-    int    ma2_idx[AI_MAX_CHANNELS];
+struct AiAuxBoard {
+    std::string   Name;
+    std::unique_ptr<IAioDevice> Dev;
+    DspFilter     dsp;                 // same MA5×MA6 as ai.dsp, own range
+    ScanRing      ring;                // raw scans from the worker
+    SampleClock   clock;               // started from ai.clock (shared time origin)
+    AiBoardWorker worker;
 };
 
 /**
@@ -158,17 +174,36 @@ struct DspFilter {
  * Singleton pattern for global state management
  */
 struct DigitShowContext {
+    int RigID;                         // index in the rig table (0 = UI timer rig)
+    RigRunner runner;                  // pipeline thread of rigs > 0; Mutex() guards the rig
+    ControlLoop ctrlLoop;              // control thread (every rig), runs under runner.Mutex()
+
     // Analog input measurement data (post-filter)
     struct {
+        int    channels;               // active channels = 16 × AD boards
         float  raw[AI_MAX_CHANNELS];   // filtered ADC voltages [V]
         double phy[AI_MAX_CHANNELS];   // calibrated physical values
-        double param[AI_MAX_CHANNELS]; // derived stress/strain params
+        double param[AI_NUM_PARAMS];   // derived stress/strain params
         struct {
-            double a[NUM_PARAM_MAX];   // quadratic coefficient
-            double b[NUM_PARAM_MAX];   // linear coefficient
-            double c[NUM_PARAM_MAX];   // offset
+            double a[AI_MAX_CHANNELS]; // quadratic coefficient
+            double b[AI_MAX_CHANNELS]; // linear coefficient
+            double c[AI_MAX_CHANNELS]; // offset
         } cal;
         DspFilter dsp;                 // 20Hz-B MA5×MA6 filter state
+        FilterConfig filterCfg;        // run-time filter configuration (AD rate, MA taps, chains)
+        ChannelFilterChain chain[AI_MAX_CHANNELS];  // per-channel stages after dsp
+        bool      chainActive;         // any chain non-empty
+        ScanRing  ring;                // raw scans queued by the AD event handler
+        FilterHistory history;         // filtered scans, 30 min full rate + decimated tiers
+        uint64_t  scanCount;           // filtered scans since StartAi (index into clock)
+        SampleClock clock;             // scan index -> board time [s], drift vs host clock
+        double    saveTime0;           // clock time of the first logged row [s]
+        AiFaultLog faults;             // AD errors/overflows, counters and data gaps
+        AiBoardWorker worker;          // polls the first AD board on rigs without AD events (rig > 0)
+        RawCaptureWriter capture;      // "capture <dir>": every raw scan of all AD boards (*.dsraw)
+        long      captureCodes[AI_MAX_CHANNELS];   // scan being captured, board b at ch 16b
+        RateDecimator ctrlDec;         // band-limited to the control rate (ControlInterval)
+        RateDecimator saveDec;         // band-limited to the logging rate (SaveInterval)
     } ai;
 
     // Analog output setpoints [V]
@@ -190,10 +225,33 @@ struct DigitShowContext {
     SpecimenData specimen;
     ControlData control[16];
     ControlFileData controlFile;
+    ControlProgram  program;           // controlFile compiled for control mode 15
     ErrorTolerance errTol;
 
     // Digital filter: DspFilter dsp moved into struct ai above
 
+    // PID loops of the motor speed / cell pressure (ai.filterCfg.MotorPid / CellPid)
+    struct {
+        PidController Motor;           // output: signed rpm, > 0 loads the specimen
+        PidController Cell;            // output: cell pressure command [kPa]
+        int Key;                       // ControlID*1000 + control-file step set up for, -1 = none
+    } pid;
+
+    // Waveform step (control file "wave"): amplitude now loaded, q range of the cycle
+    struct {
+        double Amplitude;
+        double QMin, QMax;
+    } wave;
+
+    // Strain-rate step (control file "rate"): motor speed corrected from the measured rate
+    StrainRateControl rate;
+
+    // Hysteresis analysis of cyclic control (modes 5/6, cyclic control-file steps)
+    struct {
+        CycleAnalyzer Analyzer;        // restarts with each control ID / step
+        int Key;                       // ControlID*1000 + step analysed, -1 = none
+    } cycle;
+
     // Control state
     int  ControlID;
     int  NumCyclic;
@@ -208,6 +266,7 @@ struct DigitShowContext {
         bool HasDA;     // DA board (AIO001) successfully opened
         bool SaveData;
         bool Ctrl;
+        bool CtrlRun;   // control switched on (ctrlLoop running)
         bool Cyclic;
     };
     SystemFlags flags;
@@ -220,16 +279,20 @@ struct DigitShowContext {
     CString SNowTime;
     long   SequentTime1;
     double SequentTime2;
-    double CtrlStepTime;
+    double CtrlStepTime;                  // dt of the current control step [s] (whole ctrlLoop periods)
+    struct _timeb StartTime2, NowTime2;   // logging clock without a board
 
     // File handles
     FILE* fpVoltage;   // raw ADC voltage log  (*_v.tsv)
     FILE* fpPhysical;  // calibrated physical values log (*.tsv)
     FILE* fpParam;     // derived parameters log (*_p.tsv)
+    FILE* fpCycle;     // per-cycle hysteresis log (*_c.tsv)
+    DataLogWriter log; // "log binary": *.dslog in place of the three TSV logs
+    TsvLine tsvLine[3];// SaveToFile() records: voltage, physical, param
 
-    // CAIO board configuration (CONTEC AIO)
+    // CAIO board configuration (CONTEC AIO or a simulated backend, see AioDevice.h)
     struct AdBoardConfig {
-        short  Id;
+        std::unique_ptr<IAioDevice> Dev;
         short  Channels;
         short  Range;
         float  RangeMax;
@@ -240,25 +303,48 @@ struct DigitShowContext {
         float  SamplingClock;
         long   SamplingTimes;
         float  ScanClock;
-        long   LastDataCount;           // actual scan count from last AioGetAiSamplingData
+        long   LastDataCount;           // scan count of the last event burst (all of it goes to ai.ring)
+        BurstTuner Tuner;               // SamplingTimes from the latency budget and handler cost
         std::vector<long> Data0;          // raw ADC sample buffer [SamplingTimes * Channels]
+        std::vector<std::unique_ptr<AiAuxBoard>> Aux;   // secondary AD boards
     } ad;
     struct DaBoardConfig {
-        short  Id;
+        std::unique_ptr<IAioDevice> Dev;
         short  Channels;
         short  Range;
         float  RangeMax;
         float  RangeMin;
         short  Resolution;
-        long   Data[AO_MAX_CHANNELS];
+        DaOutputStage Out;              // sole writer of the board (ao.raw -> MultiAo)
     } da;
 };
 
 /**
- * Get the global context instance (singleton)
+ * Context of the rig bound to the calling thread (rig 0 unless BindRig()
+ * was called). The UI thread is bound to the rig selected in the Rig menu;
+ * each rig's runner thread is bound to its own rig.
  */
 DigitShowContext* GetContext();
 
+/**
+ * Rig table: GetRigContext(r) for 0 <= r < MAX_RIGS, nullptr otherwise
+ */
+DigitShowContext* GetRigContext(int rig);
+void BindRig(int rig);
+int  BoundRig();
+
+/**
+ * Binds the calling thread to a rig for the lifetime of the object
+ */
+class RigScope
+{
+public:
+    explicit RigScope(int rig) : m_Prev(BoundRig()) { BindRig(rig); }
+    ~RigScope() { BindRig(m_Prev); }
+private:
+    int m_Prev;
+};
+
 /**
  * Initialize the context with default values
  */
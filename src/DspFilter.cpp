@@ -0,0 +1,388 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "DspFilter.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define DSP_X86_64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define DSP_TARGET_AVX2
+#else
+#define DSP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// DSP_MODE_EXACT: the stage-2 sum of full-scale 16-bit codes at the
+// largest tap counts must fit the int32 lanes
+static_assert(int64_t(DSP_MA_MAX_TAPS) * DSP_MA_MAX_TAPS * 65535 < INT32_MAX,
+              "DSP_MA_MAX_TAPS too large for int32 exact sums");
+
+namespace {
+
+typedef void (*DspKernelFn)(DspFilter& d, const long* scan, float* out);
+
+// `long` is 32-bit on Windows and 64-bit on LP64; the vector kernels
+// load int32 lanes, so narrow the codes first where needed.
+inline const int32_t* CodesAsInt32(const long* scan, int32_t* tmp)
+{
+    if (sizeof(long) == sizeof(int32_t))
+        return reinterpret_cast<const int32_t*>(scan);
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) tmp[ch] = static_cast<int32_t>(scan[ch]);
+    return tmp;
+}
+
+// ── Scalar reference kernel ──────────────────────────────────
+void ProcessScalar(DspFilter& d, const long* scan, float* out)
+{
+    const double inv1 = 1.0 / d.ma1_taps;
+    const double inv2 = 1.0 / d.ma2_taps;
+    double* b1 = d.ma1_buf[d.ma1_pos];
+    double* b2 = d.ma2_buf[d.ma2_pos];
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+        const double v    = double(scan[ch]) * d.scale + d.offset;
+        d.ma1_sum[ch]    += v - b1[ch];
+        b1[ch]            = v;
+        const double out1 = d.ma1_sum[ch] * inv1;
+        d.ma2_sum[ch]    += out1 - b2[ch];
+        b2[ch]            = out1;
+        out[ch]           = float(d.ma2_sum[ch] * inv2);
+    }
+}
+
+void ProcessExactScalar(DspFilter& d, const long* scan, float* out)
+{
+    int* b1 = d.ima1_buf[d.ma1_pos];
+    int* b2 = d.ima2_buf[d.ma2_pos];
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+        const int v    = static_cast<int>(scan[ch]);
+        d.ima1_sum[ch] += v - b1[ch];
+        b1[ch]          = v;
+        const int s1   = d.ima1_sum[ch];
+        d.ima2_sum[ch] += s1 - b2[ch];
+        b2[ch]          = s1;
+        out[ch]         = float(double(d.ima2_sum[ch]) * d.iscale + d.offset);
+    }
+}
+
+#ifdef DSP_X86_64
+// ── SSE2: 2 channels per op (baseline on x64) ────────────────
+void ProcessSse2(DspFilter& d, const long* scan, float* out)
+{
+    int32_t tmp[DSP_AD_CHANNELS];
+    const int32_t* codes = CodesAsInt32(scan, tmp);
+    double* b1 = d.ma1_buf[d.ma1_pos];
+    double* b2 = d.ma2_buf[d.ma2_pos];
+    const __m128d scale  = _mm_set1_pd(d.scale);
+    const __m128d offset = _mm_set1_pd(d.offset);
+    const __m128d inv1   = _mm_set1_pd(1.0 / d.ma1_taps);
+    const __m128d inv2   = _mm_set1_pd(1.0 / d.ma2_taps);
+
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch += 4) {
+        const __m128i c  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + ch));
+        const __m128d vl = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(c), scale), offset);
+        const __m128d vh = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(c, 8)), scale), offset);
+
+        __m128d s1l = _mm_add_pd(_mm_loadu_pd(d.ma1_sum + ch),     _mm_sub_pd(vl, _mm_loadu_pd(b1 + ch)));
+        __m128d s1h = _mm_add_pd(_mm_loadu_pd(d.ma1_sum + ch + 2), _mm_sub_pd(vh, _mm_loadu_pd(b1 + ch + 2)));
+        _mm_storeu_pd(d.ma1_sum + ch,     s1l);
+        _mm_storeu_pd(d.ma1_sum + ch + 2, s1h);
+        _mm_storeu_pd(b1 + ch,     vl);
+        _mm_storeu_pd(b1 + ch + 2, vh);
+
+        const __m128d o1l = _mm_mul_pd(s1l, inv1);
+        const __m128d o1h = _mm_mul_pd(s1h, inv1);
+        __m128d s2l = _mm_add_pd(_mm_loadu_pd(d.ma2_sum + ch),     _mm_sub_pd(o1l, _mm_loadu_pd(b2 + ch)));
+        __m128d s2h = _mm_add_pd(_mm_loadu_pd(d.ma2_sum + ch + 2), _mm_sub_pd(o1h, _mm_loadu_pd(b2 + ch + 2)));
+        _mm_storeu_pd(d.ma2_sum + ch,     s2l);
+        _mm_storeu_pd(d.ma2_sum + ch + 2, s2h);
+        _mm_storeu_pd(b2 + ch,     o1l);
+        _mm_storeu_pd(b2 + ch + 2, o1h);
+
+        const __m128 ol = _mm_cvtpd_ps(_mm_mul_pd(s2l, inv2));
+        const __m128 oh = _mm_cvtpd_ps(_mm_mul_pd(s2h, inv2));
+        _mm_storeu_ps(out + ch, _mm_movelh_ps(ol, oh));
+    }
+}
+
+// Exact mode: 4 int32 channels per op
+void ProcessExactSse2(DspFilter& d, const long* scan, float* out)
+{
+    int32_t tmp[DSP_AD_CHANNELS];
+    const int32_t* codes = CodesAsInt32(scan, tmp);
+    __m128i* b1 = reinterpret_cast<__m128i*>(d.ima1_buf[d.ma1_pos]);
+    __m128i* b2 = reinterpret_cast<__m128i*>(d.ima2_buf[d.ma2_pos]);
+    __m128i* s1 = reinterpret_cast<__m128i*>(d.ima1_sum);
+    __m128i* s2 = reinterpret_cast<__m128i*>(d.ima2_sum);
+    const __m128d iscale = _mm_set1_pd(d.iscale);
+    const __m128d offset = _mm_set1_pd(d.offset);
+
+    for (int i = 0; i < DSP_AD_CHANNELS / 4; i++) {
+        const __m128i v   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes) + i);
+        const __m128i sum1 = _mm_add_epi32(_mm_loadu_si128(s1 + i), _mm_sub_epi32(v, _mm_loadu_si128(b1 + i)));
+        _mm_storeu_si128(s1 + i, sum1);
+        _mm_storeu_si128(b1 + i, v);
+        const __m128i sum2 = _mm_add_epi32(_mm_loadu_si128(s2 + i), _mm_sub_epi32(sum1, _mm_loadu_si128(b2 + i)));
+        _mm_storeu_si128(s2 + i, sum2);
+        _mm_storeu_si128(b2 + i, sum1);
+        const __m128 lo = _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(sum2), iscale), offset));
+        const __m128 hi = _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(sum2, 8)), iscale), offset));
+        _mm_storeu_ps(out + 4 * i, _mm_movelh_ps(lo, hi));
+    }
+}
+
+// ── AVX2: 4 channels per op, 16 channels in 4 iterations ─────
+DSP_TARGET_AVX2
+void ProcessAvx2(DspFilter& d, const long* scan, float* out)
+{
+    int32_t tmp[DSP_AD_CHANNELS];
+    const int32_t* codes = CodesAsInt32(scan, tmp);
+    double* b1 = d.ma1_buf[d.ma1_pos];
+    double* b2 = d.ma2_buf[d.ma2_pos];
+    const __m256d scale  = _mm256_set1_pd(d.scale);
+    const __m256d offset = _mm256_set1_pd(d.offset);
+    const __m256d inv1   = _mm256_set1_pd(1.0 / d.ma1_taps);
+    const __m256d inv2   = _mm256_set1_pd(1.0 / d.ma2_taps);
+
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch += 4) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + ch));
+        const __m256d v = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(c), scale), offset);
+
+        const __m256d s1 = _mm256_add_pd(_mm256_loadu_pd(d.ma1_sum + ch),
+                                         _mm256_sub_pd(v, _mm256_loadu_pd(b1 + ch)));
+        _mm256_storeu_pd(d.ma1_sum + ch, s1);
+        _mm256_storeu_pd(b1 + ch, v);
+
+        const __m256d o1 = _mm256_mul_pd(s1, inv1);
+        const __m256d s2 = _mm256_add_pd(_mm256_loadu_pd(d.ma2_sum + ch),
+                                         _mm256_sub_pd(o1, _mm256_loadu_pd(b2 + ch)));
+        _mm256_storeu_pd(d.ma2_sum + ch, s2);
+        _mm256_storeu_pd(b2 + ch, o1);
+
+        _mm_storeu_ps(out + ch, _mm256_cvtpd_ps(_mm256_mul_pd(s2, inv2)));
+    }
+}
+
+// Exact mode: 8 int32 channels per op, 16 channels in 2 iterations
+DSP_TARGET_AVX2
+void ProcessExactAvx2(DspFilter& d, const long* scan, float* out)
+{
+    int32_t tmp[DSP_AD_CHANNELS];
+    const int32_t* codes = CodesAsInt32(scan, tmp);
+    __m256i* b1 = reinterpret_cast<__m256i*>(d.ima1_buf[d.ma1_pos]);
+    __m256i* b2 = reinterpret_cast<__m256i*>(d.ima2_buf[d.ma2_pos]);
+    __m256i* s1 = reinterpret_cast<__m256i*>(d.ima1_sum);
+    __m256i* s2 = reinterpret_cast<__m256i*>(d.ima2_sum);
+    const __m256d iscale = _mm256_set1_pd(d.iscale);
+    const __m256d offset = _mm256_set1_pd(d.offset);
+
+    for (int i = 0; i < DSP_AD_CHANNELS / 8; i++) {
+        const __m256i v    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes) + i);
+        const __m256i sum1 = _mm256_add_epi32(_mm256_loadu_si256(s1 + i),
+                                              _mm256_sub_epi32(v, _mm256_loadu_si256(b1 + i)));
+        _mm256_storeu_si256(s1 + i, sum1);
+        _mm256_storeu_si256(b1 + i, v);
+        const __m256i sum2 = _mm256_add_epi32(_mm256_loadu_si256(s2 + i),
+                                              _mm256_sub_epi32(sum1, _mm256_loadu_si256(b2 + i)));
+        _mm256_storeu_si256(s2 + i, sum2);
+        _mm256_storeu_si256(b2 + i, sum1);
+        const __m128 lo = _mm256_cvtpd_ps(_mm256_add_pd(
+            _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sum2)), iscale), offset));
+        const __m128 hi = _mm256_cvtpd_ps(_mm256_add_pd(
+            _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sum2, 1)), iscale), offset));
+        _mm_storeu_ps(out + 8 * i,     lo);
+        _mm_storeu_ps(out + 8 * i + 4, hi);
+    }
+}
+
+bool CpuHasAvx2()
+{
+#ifdef _MSC_VER
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    const bool osxsave = (r[2] & (1 << 27)) != 0;
+    const bool avx     = (r[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;   // OS saves YMM state
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif // DSP_X86_64
+
+bool KernelSupported(DspKernel kernel)
+{
+    switch (kernel) {
+    case DSP_KERNEL_SCALAR: return true;
+#ifdef DSP_X86_64
+    case DSP_KERNEL_SSE2:   return true;
+    case DSP_KERNEL_AVX2:   return CpuHasAvx2();
+#endif
+    default:                return false;
+    }
+}
+
+DspKernelFn KernelFunction(DspKernel kernel, int mode)
+{
+    const bool exact = (mode == DSP_MODE_EXACT);
+    switch (kernel) {
+#ifdef DSP_X86_64
+    case DSP_KERNEL_SSE2: return exact ? ProcessExactSse2 : ProcessSse2;
+    case DSP_KERNEL_AVX2: return exact ? ProcessExactAvx2 : ProcessAvx2;
+#endif
+    default:              return exact ? ProcessExactScalar : ProcessScalar;
+    }
+}
+
+DspKernel BestKernel()
+{
+    if (KernelSupported(DSP_KERNEL_AVX2)) return DSP_KERNEL_AVX2;
+    if (KernelSupported(DSP_KERNEL_SSE2)) return DSP_KERNEL_SSE2;
+    return DSP_KERNEL_SCALAR;
+}
+
+DspKernel   g_Kernel = BestKernel();
+DspKernelFn g_KernelFn[2] = {                   // [DspMode]
+    KernelFunction(g_Kernel, DSP_MODE_EXACT),
+    KernelFunction(g_Kernel, DSP_MODE_DOUBLE),
+};
+
+#ifdef _DEBUG
+// Exact mode self-check: the running sums must equal a fresh sum over
+// the tap buffers at any time (no accumulated error, ever).
+// Per thread: rigs and their boards filter concurrently.
+const unsigned        kCheckInterval = 65536;
+thread_local unsigned g_CheckCount   = 0;
+
+void CheckExactSums(const DspFilter& d)
+{
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+        int s1 = 0, s2 = 0;
+        for (int k = 0; k < d.ma1_taps; k++) s1 += d.ima1_buf[k][ch];
+        for (int k = 0; k < d.ma2_taps; k++) s2 += d.ima2_buf[k][ch];
+        assert(s1 == d.ima1_sum[ch]);
+        assert(s2 == d.ima2_sum[ch]);
+    }
+}
+#endif
+
+} // namespace
+
+void DspFilter::Reset()
+{
+    std::memset(ma1_buf, 0, sizeof(ma1_buf));
+    std::memset(ma1_sum, 0, sizeof(ma1_sum));
+    std::memset(ma2_buf, 0, sizeof(ma2_buf));
+    std::memset(ma2_sum, 0, sizeof(ma2_sum));
+    std::memset(ima1_buf, 0, sizeof(ima1_buf));
+    std::memset(ima1_sum, 0, sizeof(ima1_sum));
+    std::memset(ima2_buf, 0, sizeof(ima2_buf));
+    std::memset(ima2_sum, 0, sizeof(ima2_sum));
+    ma1_pos = 0;
+    ma2_pos = 0;
+    primed  = 0;
+}
+
+// Fill every tap with the first scan: stage 1 holds its codes / volts,
+// stage 2 the stage-1 sums / means, as after a long constant input
+void DspFilter::Prime(const long* scan)
+{
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+        const int    code = static_cast<int>(scan[ch]);
+        const double v    = double(code) * scale + offset;
+        for (int k = 0; k < ma1_taps; k++) {
+            ima1_buf[k][ch] = code;
+            ma1_buf[k][ch]  = v;
+        }
+        for (int k = 0; k < ma2_taps; k++) {
+            ima2_buf[k][ch] = code * ma1_taps;
+            ma2_buf[k][ch]  = v;
+        }
+        ima1_sum[ch] = code * ma1_taps;
+        ima2_sum[ch] = code * ma1_taps * ma2_taps;
+        ma1_sum[ch]  = v * ma1_taps;
+        ma2_sum[ch]  = v * ma2_taps;
+    }
+    primed = 1;
+}
+
+void DspFilter::SetMode(DspMode m)
+{
+    mode = m;
+    Reset();
+}
+
+void DspFilter::SetTaps(int taps1, int taps2)
+{
+    ma1_taps = (taps1 < 1) ? 1 : (taps1 > DSP_MA_MAX_TAPS) ? DSP_MA_MAX_TAPS : taps1;
+    ma2_taps = (taps2 < 1) ? 1 : (taps2 > DSP_MA_MAX_TAPS) ? DSP_MA_MAX_TAPS : taps2;
+    iscale   = scale / (ma1_taps * ma2_taps);
+    Reset();
+}
+
+void DspFilter::SetRange(float rangeMax, float rangeMin, short resolution)
+{
+    const double codes = (resolution == 16) ? 65535.0 : 4095.0;
+    scale   = (double(rangeMax) - double(rangeMin)) / codes;
+    offset  = double(rangeMin);
+    iscale  = scale / (ma1_taps * ma2_taps);
+}
+
+void DspFilter::Process(const long* scan, float* out)
+{
+    if (!primed) Prime(scan);
+    g_KernelFn[mode == DSP_MODE_DOUBLE ? 1 : 0](*this, scan, out);
+#ifdef _DEBUG
+    if (mode == DSP_MODE_EXACT && ++g_CheckCount % kCheckInterval == 0) CheckExactSums(*this);
+#endif
+    ma1_pos = (ma1_pos + 1 >= ma1_taps) ? 0 : ma1_pos + 1;
+    ma2_pos = (ma2_pos + 1 >= ma2_taps) ? 0 : ma2_pos + 1;
+}
+
+DspKernel DspFilter::ActiveKernel()
+{
+    return g_Kernel;
+}
+
+const char* DspFilter::KernelName(DspKernel kernel)
+{
+    switch (kernel) {
+    case DSP_KERNEL_SSE2: return "SSE2";
+    case DSP_KERNEL_AVX2: return "AVX2";
+    default:              return "scalar";
+    }
+}
+
+bool DspFilter::UseKernel(DspKernel kernel)
+{
+    if (!KernelSupported(kernel)) return false;
+    g_Kernel      = kernel;
+    g_KernelFn[0] = KernelFunction(kernel, DSP_MODE_EXACT);
+    g_KernelFn[1] = KernelFunction(kernel, DSP_MODE_DOUBLE);
+    return true;
+}
@@ -0,0 +1,118 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DSPFILTER_H_INCLUDE__
+#define __DSPFILTER_H_INCLUDE__
+
+#pragma once
+
+#define DSP_AD_CHANNELS   16     // AD channels per board (one DspFilter)
+#define DSP_MAX_BOARDS     4     // AD boards merged into one scan (AIO000 + 3)
+#define DSP_MAX_CHANNELS  (DSP_AD_CHANNELS * DSP_MAX_BOARDS)
+#define DSP_MA1_TAPS       5     // Stage-1 MA taps  → notch at Fs/5 = 60 Hz (default)
+#define DSP_MA2_TAPS       6     // Stage-2 MA taps  → notch at Fs/6 = 50 Hz (default)
+#define DSP_MA_MAX_TAPS   16     // Upper limit for run-time tap counts
+// Group delay = (MA1_TAPS-1 + MA2_TAPS-1) / (2*Fs) = 15 ms
+// -3dB ~ 18 Hz
+
+/**
+ * Filter kernel implementations, best one selected at runtime
+ */
+enum DspKernel {
+    DSP_KERNEL_SCALAR = 0,
+    DSP_KERNEL_SSE2   = 1,
+    DSP_KERNEL_AVX2   = 2,
+};
+
+/**
+ * Arithmetic of the MA stages
+ *
+ * DSP_MODE_EXACT runs both stages on the raw codes with int32 running
+ * sums: adding and removing a tap is exact, so the sums never drift
+ * however long a test runs. The stage-2 sum reaches ma1_taps × ma2_taps
+ * × the largest code, which must stay below 2^31: with 16-bit codes
+ * (SetRange() knows 12 and 16 bit) that is at most 256 × 65535 < 2^25. Volts are computed once per
+ * output as sum2 × scale/(MA1×MA2) + offset.
+ * DSP_MODE_DOUBLE converts every sample to volts first and keeps double
+ * running sums (the original formulation).
+ */
+enum DspMode {
+    DSP_MODE_EXACT  = 0,    // default (zero-filled state)
+    DSP_MODE_DOUBLE = 1,
+};
+
+/**
+ * Cascaded sliding-window MA filter state (20Hz-B design)
+ * Stage 1: MA(ma1_taps), default DSP_MA1_TAPS — 60 Hz notch
+ * Stage 2: MA(ma2_taps), default DSP_MA2_TAPS — 50 Hz notch
+ *
+ * Structure-of-arrays layout: each tap row holds all channels, and all
+ * channels share one ring position per stage since they advance in
+ * lockstep. Process() filters one whole scan with a few vector ops.
+ * Zero-filled state (memset) followed by SetTaps() is a valid initial state.
+ * The first scan after a reset fills every tap, so the output starts at
+ * that scan instead of ramping up from code 0 (RangeMin) or 0 V.
+ */
+struct DspFilter {
+    // DSP_MODE_DOUBLE state
+    double ma1_buf[DSP_MA_MAX_TAPS][DSP_AD_CHANNELS];  // [tap][ch] volts
+    double ma1_sum[DSP_AD_CHANNELS];
+    double ma2_buf[DSP_MA_MAX_TAPS][DSP_AD_CHANNELS];  // [tap][ch] stage-1 output
+    double ma2_sum[DSP_AD_CHANNELS];
+
+    // DSP_MODE_EXACT state
+    int    ima1_buf[DSP_MA_MAX_TAPS][DSP_AD_CHANNELS]; // [tap][ch] raw codes
+    int    ima1_sum[DSP_AD_CHANNELS];
+    int    ima2_buf[DSP_MA_MAX_TAPS][DSP_AD_CHANNELS]; // [tap][ch] stage-1 sums
+    int    ima2_sum[DSP_AD_CHANNELS];
+
+    int    ma1_taps;
+    int    ma2_taps;
+    int    ma1_pos;                                  // shared ring position
+    int    ma2_pos;
+    int    mode;                                     // DspMode
+    int    primed;                                   // taps hold real scans (0 after Reset)
+
+    double scale;                                    // V per code
+    double offset;                                   // V at code 0
+    double iscale;                                   // V per unit of ima2_sum = scale / (ma1_taps×ma2_taps)
+
+    // Clear the MA history (keeps mode and code→volt scale); the next
+    // scan primes all taps
+    void Reset();
+
+    // Select the arithmetic; clears the history
+    void SetMode(DspMode m);
+
+    // Tap counts (1..DSP_MA_MAX_TAPS); clears the history
+    void SetTaps(int taps1, int taps2);
+
+    // Code→volt conversion, same as BinaryToVolt()
+    void SetRange(float rangeMax, float rangeMin, short resolution);
+
+    // Filter one scan of DSP_AD_CHANNELS raw codes; write filtered volts
+    void Process(const long* scan, float* out);
+    void Prime(const long* scan);
+
+    static DspKernel   ActiveKernel();
+    static const char* KernelName(DspKernel kernel);
+    // Force a kernel (benchmarks/comparison). False if the CPU lacks it.
+    static bool        UseKernel(DspKernel kernel);
+};
+
+#endif // __DSPFILTER_H_INCLUDE__
@@ -0,0 +1,661 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "FilterChain.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// ── Moving average ───────────────────────────────────────────
+// N > 0: compile-time tap count; N == 0: run-time tap count.
+// The double running sum is rebuilt from the taps every 4096 wraps so
+// rounding residue cannot accumulate.
+template <int N>
+struct TapStore {
+    double v[N];
+    void   Init(int)    { std::fill(v, v + N, 0.0); }
+    int    Size() const { return N; }
+};
+
+template <>
+struct TapStore<0> {
+    std::vector<double> v;
+    void   Init(int n)  { v.assign(n, 0.0); }
+    int    Size() const { return int(v.size()); }
+};
+
+template <int N>
+class MovingAverageStage : public IFilterStage
+{
+public:
+    explicit MovingAverageStage(int taps) { m_Buf.Init(taps); Reset(); }
+
+    virtual void Reset()
+    {
+        m_Buf.Init(m_Buf.Size());
+        m_Sum = 0.0; m_Pos = 0; m_Wraps = 0;
+        m_Inv = 1.0 / m_Buf.Size();
+    }
+
+    virtual bool Process(double x, double* y)
+    {
+        m_Sum += x - m_Buf.v[m_Pos];
+        m_Buf.v[m_Pos] = x;
+        if (++m_Pos == m_Buf.Size()) {
+            m_Pos = 0;
+            if ((++m_Wraps & 4095) == 0) {
+                m_Sum = 0.0;
+                for (int k = 0; k < m_Buf.Size(); k++) m_Sum += m_Buf.v[k];
+            }
+        }
+        *y = m_Sum * m_Inv;
+        return true;
+    }
+
+private:
+    TapStore<N> m_Buf;
+    double   m_Sum;
+    double   m_Inv;
+    int      m_Pos;
+    unsigned m_Wraps;
+};
+
+// ── Biquad (transposed direct form II) ───────────────────────
+class BiquadStage : public IFilterStage
+{
+public:
+    BiquadStage(double b0, double b1, double b2, double a1, double a2)
+        : m_b0(b0), m_b1(b1), m_b2(b2), m_a1(a1), m_a2(a2) { Reset(); }
+
+    virtual void Reset() { m_z1 = 0.0; m_z2 = 0.0; }
+
+    virtual bool Process(double x, double* y)
+    {
+        const double out = m_b0 * x + m_z1;
+        m_z1 = m_b1 * x - m_a1 * out + m_z2;
+        m_z2 = m_b2 * x - m_a2 * out;
+        *y = out;
+        return true;
+    }
+
+private:
+    double m_b0, m_b1, m_b2, m_a1, m_a2;
+    double m_z1, m_z2;
+};
+
+// ── FIR low-pass with decimation ─────────────────────────────
+// Only every D-th input computes a dot product (polyphase saving).
+// The history is stored twice (ring + mirror) so the dot product always
+// reads one contiguous block of TAPS values.
+template <int N>
+class FirDecimatorStage : public IFilterStage
+{
+public:
+    FirDecimatorStage(const std::vector<double>& h, int decimation)
+        : m_D(std::max(decimation, 1))
+    {
+        m_Taps = (N > 0) ? N : int(h.size());
+        m_H.assign(h.rbegin(), h.rend());          // reversed: oldest sample first
+        m_Hist.assign(2 * m_Taps, 0.0);
+        Reset();
+    }
+
+    virtual void Reset()
+    {
+        std::fill(m_Hist.begin(), m_Hist.end(), 0.0);
+        m_Pos = 0; m_Phase = 0;
+    }
+
+    virtual bool Process(double x, double* y)
+    {
+        const int taps = (N > 0) ? N : m_Taps;
+        m_Hist[m_Pos] = x;
+        m_Hist[m_Pos + taps] = x;
+        if (++m_Pos == taps) m_Pos = 0;
+        if (++m_Phase < m_D) return false;
+        m_Phase = 0;
+
+        const double* hist = &m_Hist[m_Pos];       // oldest .. newest
+        const double* h    = m_H.data();
+        double acc = 0.0;
+        for (int k = 0; k < taps; k++) acc += h[k] * hist[k];
+        *y = acc;
+        return true;
+    }
+
+private:
+    int m_D;
+    int m_Taps;
+    std::vector<double> m_H;
+    std::vector<double> m_Hist;
+    int m_Pos;
+    int m_Phase;
+};
+
+std::unique_ptr<IFilterStage> CreateMovingAverage(int n)
+{
+    switch (n) {
+    case 2:  return std::unique_ptr<IFilterStage>(new MovingAverageStage<2>(n));
+    case 3:  return std::unique_ptr<IFilterStage>(new MovingAverageStage<3>(n));
+    case 4:  return std::unique_ptr<IFilterStage>(new MovingAverageStage<4>(n));
+    case 5:  return std::unique_ptr<IFilterStage>(new MovingAverageStage<5>(n));
+    case 6:  return std::unique_ptr<IFilterStage>(new MovingAverageStage<6>(n));
+    case 8:  return std::unique_ptr<IFilterStage>(new MovingAverageStage<8>(n));
+    case 10: return std::unique_ptr<IFilterStage>(new MovingAverageStage<10>(n));
+    case 12: return std::unique_ptr<IFilterStage>(new MovingAverageStage<12>(n));
+    case 16: return std::unique_ptr<IFilterStage>(new MovingAverageStage<16>(n));
+    default: return std::unique_ptr<IFilterStage>(new MovingAverageStage<0>(n));
+    }
+}
+
+std::unique_ptr<IFilterStage> CreateFir(const std::vector<double>& h, int decimation)
+{
+    switch (h.size()) {
+    case 15: return std::unique_ptr<IFilterStage>(new FirDecimatorStage<15>(h, decimation));
+    case 31: return std::unique_ptr<IFilterStage>(new FirDecimatorStage<31>(h, decimation));
+    case 63: return std::unique_ptr<IFilterStage>(new FirDecimatorStage<63>(h, decimation));
+    default: return std::unique_ptr<IFilterStage>(new FirDecimatorStage<0>(h, decimation));
+    }
+}
+
+// MA(N) repeated K times, as one stage
+class CascadeStage : public IFilterStage
+{
+public:
+    void Add(std::unique_ptr<IFilterStage> s) { m_Stages.push_back(std::move(s)); }
+    virtual void Reset() { for (auto& s : m_Stages) s->Reset(); }
+    virtual bool Process(double x, double* y)
+    {
+        for (auto& s : m_Stages) s->Process(x, &x);
+        *y = x;
+        return true;
+    }
+private:
+    std::vector<std::unique_ptr<IFilterStage>> m_Stages;
+};
+
+// RBJ audio-EQ-cookbook coefficients, normalised to a0 = 1
+void DesignBiquad(int kind, double fc, double q, double fs, double c[5])
+{
+    const double w0    = 2.0 * kPi * fc / fs;
+    const double cosw  = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    double b0, b1, b2;
+    switch (kind) {
+    case BIQUAD_HIGHPASS: b0 = (1.0 + cosw) / 2.0; b1 = -(1.0 + cosw); b2 = b0; break;
+    case BIQUAD_NOTCH:    b0 = 1.0;                b1 = -2.0 * cosw;    b2 = 1.0; break;
+    default:              b0 = (1.0 - cosw) / 2.0; b1 = 1.0 - cosw;     b2 = b0; break;
+    }
+    const double a0 = 1.0 + alpha;
+    c[0] = b0 / a0;
+    c[1] = b1 / a0;
+    c[2] = b2 / a0;
+    c[3] = -2.0 * cosw / a0;
+    c[4] = (1.0 - alpha) / a0;
+}
+
+// "3", "3-7" or "*" (all of 0..count-1)
+bool ParseRange(const std::string& tok, int count, int* first, int* last)
+{
+    if (tok == "*") { *first = 0; *last = count - 1; return true; }
+    const size_t dash = tok.find('-');
+    char* end = nullptr;
+    *first = int(std::strtol(tok.c_str(), &end, 10));
+    *last  = (dash == std::string::npos) ? *first : int(std::strtol(tok.c_str() + dash + 1, &end, 10));
+    return *first >= 0 && *last < count && *first <= *last;
+}
+
+// key=value gains of a "pid" line
+bool ParsePidParam(const std::string& tok, PidParams* p)
+{
+    const size_t eq = tok.find('=');
+    if (eq == std::string::npos) return false;
+    const std::string key = tok.substr(0, eq);
+    char* end = nullptr;
+    const double v = std::strtod(tok.c_str() + eq + 1, &end);
+    if (end == tok.c_str() + eq + 1 || *end != '\0') return false;
+    if      (key == "kp")   p->Kp = v;
+    else if (key == "ki")   p->Ki = v;
+    else if (key == "kd")   p->Kd = v;
+    else if (key == "tf")   p->Tf = v;
+    else if (key == "ff")   p->Kff = v;
+    else if (key == "slew") p->Slew = v;
+    else if (key == "db")   p->Deadband = v;
+    else if (key == "max")  p->OutMax = v;
+    else return false;
+    return v >= 0.0 || key == "ff";
+}
+
+// key=value limits of a "daout" line
+bool ParseDaLimit(const std::string& tok, DaChannelLimits* lim)
+{
+    const size_t eq = tok.find('=');
+    if (eq == std::string::npos) return false;
+    const std::string key = tok.substr(0, eq);
+    char* end = nullptr;
+    const double v = std::strtod(tok.c_str() + eq + 1, &end);
+    if (end == tok.c_str() + eq + 1 || *end != '\0') return false;
+    if      (key == "min")  lim->Min = float(v);
+    else if (key == "max")  lim->Max = float(v);
+    else if (key == "slew") lim->Slew = float(v);
+    else return false;
+    return v >= 0.0;
+}
+
+// A stage must be realisable at the rate it runs at: biquad corners below
+// Nyquist (at or above it the poles sit on or outside the unit circle),
+// raw biquads with both poles inside it, and decimating FIRs cut off
+// below the output Nyquist frequency so nothing aliases.
+bool CheckStage(const FilterStageSpec& spec, double fs, std::string* why)
+{
+    char buf[96];
+    if (spec.Type == FILTER_STAGE_BIQUAD && spec.Kind == BIQUAD_RAW) {
+        const double a1 = spec.Coef[3], a2 = spec.Coef[4];
+        if (std::fabs(a2) < 1.0 && std::fabs(a1) < 1.0 + a2) return true;
+        *why = "biquad raw: poles not inside the unit circle";
+        return false;
+    }
+    if (spec.Type == FILTER_STAGE_BIQUAD && spec.Fc >= 0.5 * fs) {
+        std::snprintf(buf, sizeof(buf), "biquad fc %g Hz not below fs/2 = %g Hz", spec.Fc, 0.5 * fs);
+        *why = buf;
+        return false;
+    }
+    if (spec.Type == FILTER_STAGE_FIR && spec.Fc > 0.5 * fs / spec.Decimation) {
+        std::snprintf(buf, sizeof(buf), "fir fc %g Hz above fs/(2D) = %g Hz", spec.Fc, 0.5 * fs / spec.Decimation);
+        *why = buf;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void SetDefaultFilterConfig(FilterConfig* cfg, double fsHz)
+{
+    cfg->FsHz    = fsHz;
+    cfg->Ma1Taps = DSP_MA1_TAPS;
+    cfg->Ma2Taps = DSP_MA2_TAPS;
+    cfg->LatencyMs = 0.0;
+    cfg->AutoBurst = true;
+    cfg->ControlMs = 0;
+    cfg->SyncControl = false;
+    cfg->Boards.assign(1, "AIO000");
+    cfg->DaBoard = "AIO001";
+    for (int ch = 0; ch < DSP_MAX_CHANNELS; ch++) cfg->Chain[ch].clear();
+    for (int id = 0; id < PID_CONTROL_IDS; id++) {
+        SetDefaultPidParams(&cfg->MotorPid[id]);
+        SetDefaultPidParams(&cfg->CellPid[id]);
+    }
+    for (int ch = 0; ch < DA_OUT_CHANNELS; ch++) SetDefaultDaLimits(&cfg->DaLimits[ch]);
+    for (int n = 0; n < AO_WAVE_TABLES; n++) cfg->WaveTables[n].clear();
+    cfg->CycleBand = CYCLE_BAND_DEFAULT;
+    cfg->BinaryLog = false;
+    cfg->CaptureDir.clear();
+}
+
+/*
+ * Filter configuration file: one directive per line, '#' starts a comment.
+ *
+ *   fs 300                          AD rate [sps/ch]
+ *   ma 5 6                          front-end MA taps (notches at fs/5, fs/6)
+ *   latency 50 [fixed]              AD event latency budget [ms]; "fixed" keeps
+ *                                   the burst size instead of tuning it
+ *   control 50 [timer|sync]         control period [ms] (default 500); "sync"
+ *                                   runs the control law on every decimated
+ *                                   scan as it is filtered ("control 0 sync":
+ *                                   every scan)
+ *   boards AIO000 AIO002            AD boards, 16 channels each in this order
+ *                                   (ch 16-31 = second board, ...)
+ *   da AIO001                       DA board
+ *   chain <ch> <stage...>           append a stage to channel(s) <ch>:
+ *                                   "3", "3-7" or "*"
+ *   clear <ch>                      remove the stages of channel(s) <ch>
+ *   pid motor|cell <id> key=value.. PID on DA_CH_MOTOR_SPEED [rpm] or DA_CH_EP_CELL
+ *                                   [kPa] for control ID(s) <id> ("2", "1-7", "*"):
+ *                                   kp ki kd, tf (derivative filter [s]), ff
+ *                                   (per setpoint rate), slew [/s], db
+ *                                   (deadband), max (|output| cap); "pid motor 2
+ *                                   off" restores the on/off control
+ *   daout <ch> key=value..          DA channel(s) <ch> ("3", "0-3", "*"): min, max
+ *                                   output [V] (default 0–9.9999), slew [V/s]
+ *                                   (0 = unlimited)
+ *   wave <n> v0 v1 ...              user waveform shape n (0-7) for control-file
+ *                                   "wave" steps: one cycle, equally spaced
+ *                                   points in [-1, 1], linearly interpolated
+ *   cycle 2                         q reversal band [kPa] of the per-cycle
+ *                                   hysteresis analysis (peaks closer than
+ *                                   this are noise, not load reversals)
+ *   log tsv|binary                  data files: the three TSV files written
+ *                                   row by row (default), or one *.dslog
+ *                                   written by a background thread and
+ *                                   converted to the TSV files on Stop Save
+ *   capture D:\raw | off            raw capture: every scan of the first AD
+ *                                   board, delta-coded, to a *.dsraw file in
+ *                                   this directory while the board runs
+ *                                   (off by default)
+ *
+ * Stages: see FilterChain.h. fc must lie below half the rate the stage
+ * runs at (fs, divided by the decimation of earlier fir stages), for fir
+ * below half its output rate; such lines are rejected with their number.
+ * Example: low-pass a noisy LVDT on ch 5
+ *   chain 5 biquad lowpass 2 0.7071
+ */
+bool LoadFilterConfig(const char* path, FilterConfig* cfg, std::string* err)
+{
+    FILE* fp = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&fp, path, "r") != 0) fp = nullptr;
+#else
+    fp = std::fopen(path, "r");
+#endif
+    if (fp == nullptr) return true;   // no file: keep the current configuration
+
+    FilterConfig out;
+    SetDefaultFilterConfig(&out, cfg->FsHz);
+
+    char line[512];
+    int  lineNo = 0;
+    bool ok     = true;
+    while (ok && std::fgets(line, sizeof(line), fp) != nullptr) {
+        lineNo++;
+        if (char* hash = std::strchr(line, '#')) *hash = '\0';
+        std::istringstream in(line);
+        std::string cmd;
+        if (!(in >> cmd)) continue;
+
+        if (cmd == "fs") {
+            ok = (in >> out.FsHz) && out.FsHz > 0.0;
+        }
+        else if (cmd == "ma") {
+            ok = (in >> out.Ma1Taps >> out.Ma2Taps)
+              && out.Ma1Taps >= 1 && out.Ma1Taps <= DSP_MA_MAX_TAPS
+              && out.Ma2Taps >= 1 && out.Ma2Taps <= DSP_MA_MAX_TAPS;
+        }
+        else if (cmd == "latency") {
+            ok = (in >> out.LatencyMs) && out.LatencyMs >= 0.0;
+            std::string mode;
+            if (ok && (in >> mode)) {
+                ok = (mode == "fixed" || mode == "auto");
+                out.AutoBurst = (mode == "auto");
+            }
+        }
+        else if (cmd == "control") {
+            ok = (in >> out.ControlMs) && out.ControlMs >= 0 && out.ControlMs <= 60000;
+            std::string mode;
+            out.SyncControl = false;
+            if (ok && (in >> mode)) {
+                ok = (mode == "timer" || mode == "sync");
+                out.SyncControl = (mode == "sync");
+            }
+            if (ok && out.ControlMs == 0) ok = out.SyncControl;
+        }
+        else if (cmd == "boards") {
+            out.Boards.clear();
+            std::string name;
+            while (in >> name) out.Boards.push_back(name);
+            ok = !out.Boards.empty() && out.Boards.size() <= DSP_MAX_BOARDS;
+        }
+        else if (cmd == "da") {
+            ok = bool(in >> out.DaBoard);
+        }
+        else if (cmd == "pid") {
+            std::string chan, idTok, tok;
+            int first = 0, last = 0;
+            ok = (in >> chan >> idTok) && (chan == "motor" || chan == "cell")
+              && ParseRange(idTok, PID_CONTROL_IDS, &first, &last);
+            if (!ok) break;
+            PidParams* set = (chan == "motor") ? out.MotorPid : out.CellPid;
+            PidParams p = set[first];
+            p.Enabled = true;
+            while (ok && (in >> tok)) {
+                if (tok == "off") SetDefaultPidParams(&p);
+                else ok = ParsePidParam(tok, &p);
+            }
+            for (int id = first; ok && id <= last; id++) set[id] = p;
+        }
+        else if (cmd == "daout") {
+            std::string chTok, tok;
+            int first = 0, last = 0;
+            ok = (in >> chTok) && ParseRange(chTok, DA_OUT_CHANNELS, &first, &last);
+            if (!ok) break;
+            DaChannelLimits lim = out.DaLimits[first];
+            while (ok && (in >> tok)) ok = ParseDaLimit(tok, &lim);
+            ok = ok && lim.Min <= lim.Max && lim.Max <= 10.0f;
+            for (int ch = first; ok && ch <= last; ch++) out.DaLimits[ch] = lim;
+        }
+        else if (cmd == "wave") {
+            int n;
+            double v;
+            ok = (in >> n) && n >= 0 && n < AO_WAVE_TABLES;
+            if (!ok) break;
+            out.WaveTables[n].clear();
+            while (ok && (in >> v)) {
+                ok = v >= -1.0 && v <= 1.0;
+                out.WaveTables[n].push_back(v);
+            }
+            ok = ok && in.eof() && out.WaveTables[n].size() >= 2;
+        }
+        else if (cmd == "log") {
+            std::string mode;
+            ok = (in >> mode) && (mode == "tsv" || mode == "binary");
+            out.BinaryLog = (mode == "binary");
+        }
+        else if (cmd == "capture") {
+            // Rest of the line, so the directory may contain spaces
+            std::string dir;
+            std::getline(in >> std::ws, dir);
+            while (!dir.empty() && std::isspace(static_cast<unsigned char>(dir.back()))) dir.pop_back();
+            ok = !dir.empty();
+            out.CaptureDir = (dir == "off") ? std::string() : dir;
+        }
+        else if (cmd == "cycle") {
+            ok = (in >> out.CycleBand) && out.CycleBand > 0.0;
+        }
+        else if (cmd == "clear" || cmd == "chain") {
+            std::string chTok;
+            int first = 0, last = 0;
+            ok = (in >> chTok) && ParseRange(chTok, DSP_MAX_CHANNELS, &first, &last);
+            if (!ok) break;
+            if (cmd == "clear") {
+                for (int ch = first; ch <= last; ch++) out.Chain[ch].clear();
+                continue;
+            }
+
+            FilterStageSpec spec = {};
+            spec.Repeat = 1;
+            spec.Decimation = 1;
+            spec.Line = lineNo;
+            std::string type;
+            ok = bool(in >> type);
+            if (ok && type == "ma") {
+                spec.Type = FILTER_STAGE_MA;
+                ok = (in >> spec.Taps) && spec.Taps >= 1;
+                int k;
+                if (ok && (in >> k)) spec.Repeat = k;
+                ok = ok && spec.Repeat >= 1 && spec.Repeat <= 8;
+            }
+            else if (ok && type == "biquad") {
+                spec.Type = FILTER_STAGE_BIQUAD;
+                std::string kind;
+                ok = bool(in >> kind);
+                if (ok && kind == "raw") {
+                    spec.Kind = BIQUAD_RAW;
+                    for (int k = 0; k < 5 && ok; k++) ok = bool(in >> spec.Coef[k]);
+                }
+                else if (ok) {
+                    spec.Kind = (kind == "lowpass")  ? BIQUAD_LOWPASS
+                              : (kind == "highpass") ? BIQUAD_HIGHPASS
+                              : (kind == "notch")    ? BIQUAD_NOTCH : -1;
+                    ok = spec.Kind >= 0 && (in >> spec.Fc >> spec.Q) && spec.Fc > 0.0 && spec.Q > 0.0;
+                }
+            }
+            else if (ok && type == "fir") {
+                spec.Type = FILTER_STAGE_FIR;
+                ok = (in >> spec.Taps >> spec.Decimation >> spec.Fc)
+                  && spec.Taps >= 1 && spec.Taps <= 1024 && spec.Decimation >= 1 && spec.Fc > 0.0;
+            }
+            else {
+                ok = false;
+            }
+            if (ok) {
+                for (int ch = first; ch <= last; ch++) out.Chain[ch].push_back(spec);
+            }
+        }
+        else {
+            ok = false;
+        }
+    }
+    std::fclose(fp);
+
+    if (!ok) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%s(%d): ", path, lineNo);
+        *err = std::string(buf) + "invalid directive";
+        return false;
+    }
+
+    // Stage limits depend on the final fs and on the decimation before each stage
+    for (int ch = 0; ch < DSP_MAX_CHANNELS; ch++) {
+        double fs = out.FsHz;
+        for (const FilterStageSpec& spec : out.Chain[ch]) {
+            std::string why;
+            if (!CheckStage(spec, fs, &why)) {
+                char buf[64];
+                std::snprintf(buf, sizeof(buf), "%s(%d): ch %d: ", path, spec.Line, ch);
+                *err = std::string(buf) + why;
+                return false;
+            }
+            if (spec.Type == FILTER_STAGE_FIR) fs /= spec.Decimation;
+        }
+    }
+    *cfg = out;
+    return true;
+}
+
+const char* GetFilterConfigPath(int rig)
+{
+    static std::string rigPath[8];
+    if (rig > 0 && rig < 8) {
+        if (rigPath[rig].empty()) rigPath[rig] = "DigitShowFilter.rig" + std::to_string(rig + 1) + ".cfg";
+        return rigPath[rig].c_str();
+    }
+    static std::string path;
+    if (path.empty()) {
+#ifdef _MSC_VER
+        char*  buf = nullptr;
+        size_t len = 0;
+        if (_dupenv_s(&buf, &len, "DIGITSHOW_FILTER") == 0 && buf != nullptr) {
+            path = buf;
+            free(buf);
+        }
+#else
+        const char* env = std::getenv("DIGITSHOW_FILTER");
+        if (env != nullptr) path = env;
+#endif
+        if (path.empty()) path = "DigitShowFilter.cfg";
+    }
+    return path.c_str();
+}
+
+bool FilterConfigExists(const char* path)
+{
+    FILE* fp = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&fp, path, "r") != 0) fp = nullptr;
+#else
+    fp = std::fopen(path, "r");
+#endif
+    if (fp == nullptr) return false;
+    std::fclose(fp);
+    return true;
+}
+
+std::vector<double> DesignLowpassFir(int taps, double fc, double fs)
+{
+    std::vector<double> h(std::max(taps, 1));
+    const double m  = 0.5 * (h.size() - 1);
+    const double wc = 2.0 * fc / fs;               // normalised cutoff (1 = Nyquist)
+    double sum = 0.0;
+    for (size_t i = 0; i < h.size(); i++) {
+        const double k    = double(i) - m;
+        const double sinc = (k == 0.0) ? wc : std::sin(kPi * wc * k) / (kPi * k);
+        const double win  = (h.size() > 1) ? 0.54 - 0.46 * std::cos(2.0 * kPi * i / (h.size() - 1)) : 1.0;
+        h[i] = sinc * win;
+        sum += h[i];
+    }
+    for (double& v : h) v /= sum;
+    return h;
+}
+
+std::unique_ptr<IFilterStage> CreateFilterStage(const FilterStageSpec& spec, double fsHz)
+{
+    switch (spec.Type) {
+    case FILTER_STAGE_MA:
+        if (spec.Repeat <= 1) return CreateMovingAverage(spec.Taps);
+        else {
+            std::unique_ptr<CascadeStage> cic(new CascadeStage());
+            for (int k = 0; k < spec.Repeat; k++) cic->Add(CreateMovingAverage(spec.Taps));
+            return cic;
+        }
+    case FILTER_STAGE_BIQUAD: {
+        double c[5] = {};
+        if (spec.Kind == BIQUAD_RAW) std::copy(spec.Coef, spec.Coef + 5, c);
+        else                         DesignBiquad(spec.Kind, spec.Fc, spec.Q, fsHz, c);
+        return std::unique_ptr<IFilterStage>(new BiquadStage(c[0], c[1], c[2], c[3], c[4]));
+    }
+    case FILTER_STAGE_FIR:
+        return CreateFir(DesignLowpassFir(spec.Taps, spec.Fc, fsHz), spec.Decimation);
+    }
+    return nullptr;
+}
+
+void ChannelFilterChain::Build(const std::vector<FilterStageSpec>& specs, double fsHz)
+{
+    m_Stages.clear();
+    double fs = fsHz;
+    for (const FilterStageSpec& spec : specs) {
+        std::unique_ptr<IFilterStage> stage = CreateFilterStage(spec, fs);
+        if (!stage) continue;
+        m_Stages.push_back(std::move(stage));
+        if (spec.Type == FILTER_STAGE_FIR) fs /= std::max(spec.Decimation, 1);
+    }
+    m_OutRate = fs;
+}
+
+void ChannelFilterChain::Reset()
+{
+    for (auto& s : m_Stages) s->Reset();
+}
+
+bool ChannelFilterChain::Process(double x, double* y)
+{
+    for (auto& s : m_Stages) {
+        if (!s->Process(x, &x)) return false;
+    }
+    *y = x;
+    return true;
+}
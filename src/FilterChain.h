@@ -0,0 +1,148 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FILTERCHAIN_H_INCLUDE__
+#define __FILTERCHAIN_H_INCLUDE__
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CycleAnalyzer.h"
+#include "DaOutput.h"
+#include "DspFilter.h"
+#include "PidController.h"
+
+/**
+ * Run-time configurable per-channel filter chain.
+ *
+ * The MA1×MA2 front end (DspFilter, all channels at once, SIMD) always
+ * runs first; its tap counts and the AD rate come from FilterConfig.
+ * Each channel may then have its own chain of stages:
+ *
+ *   ma     N [K]           MA(N) cascaded K times (CIC-equivalent, gain 1)
+ *   biquad lowpass  fc Q   RBJ biquad sections (transposed direct form II)
+ *   biquad highpass fc Q
+ *   biquad notch    fc Q
+ *   biquad raw b0 b1 b2 a1 a2
+ *   fir    TAPS D fc       windowed-sinc low-pass FIR, decimate by D
+ *
+ * Stages with common sizes (MA 2–16, FIR 15/31/63 taps) are created from
+ * templates with a compile-time tap count; other sizes use the generic
+ * run-time-sized kernel. An empty chain costs nothing, so the default
+ * 20Hz-B configuration runs exactly the MA5×MA6 path.
+ */
+
+enum FilterStageType {
+    FILTER_STAGE_MA     = 0,
+    FILTER_STAGE_BIQUAD = 1,
+    FILTER_STAGE_FIR    = 2,
+};
+
+enum BiquadKind {
+    BIQUAD_LOWPASS  = 0,
+    BIQUAD_HIGHPASS = 1,
+    BIQUAD_NOTCH    = 2,
+    BIQUAD_RAW      = 3,
+};
+
+struct FilterStageSpec {
+    int    Type;            // FilterStageType
+    int    Taps;            // MA N / FIR taps
+    int    Repeat;          // MA cascade count K
+    int    Decimation;      // FIR decimation D (1 = none)
+    int    Kind;            // BiquadKind
+    double Fc;              // cutoff / centre [Hz]
+    double Q;
+    double Coef[5];         // raw biquad: b0 b1 b2 a1 a2 (a0 = 1)
+    int    Line;            // configuration file line (error messages)
+};
+
+struct FilterConfig {
+    double FsHz;                                        // AD sampling rate [sps/ch]
+    int    Ma1Taps;                                     // front-end MA stage 1
+    int    Ma2Taps;                                     // front-end MA stage 2
+    double LatencyMs;                                   // AD event latency budget, 0 = DisplayInterval
+    bool   AutoBurst;                                   // tune the event burst size at run time
+    int    ControlMs;                                   // control period [ms], 0 = ControlInterval (sync: every scan)
+    bool   SyncControl;                                 // control inside AD_INPUT, per decimated scan
+    std::vector<std::string> Boards;                    // AD device names, first = clock master
+    std::string DaBoard;                                // DA device name
+    std::vector<FilterStageSpec> Chain[DSP_MAX_CHANNELS]; // per-channel stages (board b: 16b..16b+15)
+    PidParams MotorPid[PID_CONTROL_IDS];                // DA_CH_MOTOR_SPEED PID per control ID
+    PidParams CellPid[PID_CONTROL_IDS];                 // DA_CH_EP_CELL PID per control ID
+    DaChannelLimits DaLimits[DA_OUT_CHANNELS];          // DA output range and slew per channel
+    std::vector<double> WaveTables[AO_WAVE_TABLES];     // user waveform shapes, one cycle in [-1, 1]
+    double CycleBand;                                   // q reversal band of the cycle analysis [kPa]
+    bool   BinaryLog;                                   // log to *.dslog on a writer thread (DataLog.h)
+    std::string CaptureDir;                             // raw AD capture directory, empty = off (RawCapture.h)
+};
+
+// 20Hz-B defaults: DSP_FS_HZ-independent part (Fs is set by the caller)
+void SetDefaultFilterConfig(FilterConfig* cfg, double fsHz);
+
+// Parse a filter configuration file (see FilterChain.cpp for the syntax).
+// A missing file leaves *cfg unchanged and returns true. On a syntax
+// error returns false and names the offending line in *err.
+bool LoadFilterConfig(const char* path, FilterConfig* cfg, std::string* err);
+
+// Configuration file of a rig. Rig 0: the DIGITSHOW_FILTER environment
+// variable if set, otherwise "DigitShowFilter.cfg" in the working directory.
+// Rig r > 0: "DigitShowFilter.rig<r+1>.cfg"; the rig exists only if it does.
+const char* GetFilterConfigPath(int rig = 0);
+bool        FilterConfigExists(const char* path);
+
+// Hamming-windowed sinc low-pass, unity DC gain
+std::vector<double> DesignLowpassFir(int taps, double fc, double fs);
+
+/**
+ * One filter stage on a single channel
+ */
+class IFilterStage
+{
+public:
+    virtual ~IFilterStage() {}
+    virtual void Reset() = 0;
+    // Feed one input sample; returns true when an output sample is produced
+    virtual bool Process(double x, double* y) = 0;
+};
+
+std::unique_ptr<IFilterStage> CreateFilterStage(const FilterStageSpec& spec, double fsHz);
+
+/**
+ * Stages of one channel, run in order
+ */
+class ChannelFilterChain
+{
+public:
+    void Build(const std::vector<FilterStageSpec>& specs, double fsHz);
+    void Reset();
+    bool Empty() const { return m_Stages.empty(); }
+    double OutputRate() const { return m_OutRate; }
+
+    // Returns true when the last stage produced a new output in *y
+    bool Process(double x, double* y);
+
+private:
+    std::vector<std::unique_ptr<IFilterStage>> m_Stages;
+    double m_OutRate = 0.0;
+};
+
+#endif // __FILTERCHAIN_H_INCLUDE__
@@ -0,0 +1,168 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "FilterHistory.h"
+
+#include <algorithm>
+
+FilterHistory::FilterHistory()
+    : m_nTiers(0), m_Channels(0)
+{
+    for (int i = 0; i < MAX_TIERS; i++) {
+        m_Tier[i].Decimation = 1;
+        m_Tier[i].Period     = 0.0;
+        m_Tier[i].Capacity   = 0;
+        m_Tier[i].AccTime    = 0.0;
+        m_Tier[i].AccCount   = 0;
+        m_Tier[i].Count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void FilterHistory::Allocate(double sampleRateHz, int channels)
+{
+    static const TierSpec kDefault[] = {
+        {    1,      30.0 * 60.0 },   // full filtered rate, 30 min
+        {   30,  6 * 3600.0      },   // 10 Hz at 300 sps, 6 h
+        { 3000,  7 * 86400.0     },   // 0.1 Hz at 300 sps, 7 days
+    };
+    Allocate(sampleRateHz, channels, kDefault, int(sizeof(kDefault) / sizeof(kDefault[0])));
+}
+
+void FilterHistory::Allocate(double sampleRateHz, int channels, const TierSpec* tiers, int nTiers)
+{
+    m_Channels = (channels > 0) ? channels : 0;
+    m_nTiers   = std::min(std::max(nTiers, 0), int(MAX_TIERS));
+    for (int i = 0; i < m_nTiers; i++) {
+        Tier& tier = m_Tier[i];
+        tier.Decimation = std::max(tiers[i].Decimation, 1u);
+        tier.Period     = (sampleRateHz > 0.0) ? tier.Decimation / sampleRateHz : 0.0;
+        tier.Capacity   = (tier.Period > 0.0)
+                        ? std::max<size_t>(size_t(tiers[i].Seconds / tier.Period), 1) : 0;
+        tier.Value.assign(tier.Capacity * m_Channels, 0.0f);
+        tier.Time.assign(tier.Capacity, 0.0);
+        tier.AccValue.assign(m_Channels, 0.0);
+    }
+    m_Mean.assign(m_Channels, 0.0f);
+    for (int i = m_nTiers; i < MAX_TIERS; i++) {
+        m_Tier[i].Capacity = 0;
+        m_Tier[i].Value.clear();
+        m_Tier[i].Time.clear();
+        m_Tier[i].AccValue.clear();
+    }
+    Reset();
+}
+
+void FilterHistory::Reset()
+{
+    for (int i = 0; i < MAX_TIERS; i++) {
+        Tier& tier = m_Tier[i];
+        std::fill(tier.AccValue.begin(), tier.AccValue.end(), 0.0);
+        tier.AccTime  = 0.0;
+        tier.AccCount = 0;
+        tier.Count.store(0, std::memory_order_release);
+    }
+}
+
+void FilterHistory::Store(Tier& tier, double t, const float* values)
+{
+    const uint64_t n    = tier.Count.load(std::memory_order_relaxed);
+    const size_t   slot = static_cast<size_t>(n % tier.Capacity);
+    std::copy(values, values + m_Channels, &tier.Value[slot * m_Channels]);
+    tier.Time[slot] = t;
+    tier.Count.store(n + 1, std::memory_order_release);
+}
+
+void FilterHistory::Append(double t, const float* values)
+{
+    if (m_nTiers == 0 || m_Tier[0].Capacity == 0) return;
+    Store(m_Tier[0], t, values);
+
+    float* mean = m_Mean.data();
+    for (int i = 1; i < m_nTiers; i++) {
+        Tier& tier = m_Tier[i];
+        for (int ch = 0; ch < m_Channels; ch++) tier.AccValue[ch] += values[ch];
+        tier.AccTime += t;
+        if (++tier.AccCount < tier.Decimation) continue;
+
+        const double inv = 1.0 / tier.AccCount;
+        for (int ch = 0; ch < m_Channels; ch++) {
+            mean[ch] = float(tier.AccValue[ch] * inv);
+            tier.AccValue[ch] = 0.0;
+        }
+        Store(tier, tier.AccTime * inv, mean);   // block centre time
+        tier.AccTime  = 0.0;
+        tier.AccCount = 0;
+    }
+}
+
+uint64_t FilterHistory::Oldest(int tier) const
+{
+    const uint64_t n   = Count(tier);
+    const uint64_t cap = m_Tier[tier].Capacity;
+    return (n > cap) ? n - cap : 0;
+}
+
+size_t FilterHistory::Read(int tier, int ch, uint64_t* first, size_t n, double* t, float* v) const
+{
+    if (tier < 0 || tier >= m_nTiers || ch < 0 || ch >= m_Channels) return 0;
+    const Tier&    tr  = m_Tier[tier];
+    const uint64_t cap = tr.Capacity;
+    if (cap == 0) return 0;
+
+    uint64_t from = std::max(*first, Oldest(tier));
+    const uint64_t end = std::min<uint64_t>(from + n, Count(tier));
+    if (end <= from) { *first = from; return 0; }
+
+    size_t k = 0;
+    for (uint64_t i = from; i < end; i++, k++) {
+        const size_t slot = static_cast<size_t>(i % cap);
+        if (t) t[k] = tr.Time[slot];
+        if (v) v[k] = tr.Value[slot * m_Channels + ch];
+    }
+
+    // Drop the head of the copy if the writer lapped it meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // The slot of index Count() may be being rewritten right now
+    const uint64_t next   = Count(tier) + 1;
+    const uint64_t oldest = (next > cap) ? next - cap : 0;
+    if (oldest > from) {
+        const size_t lost = static_cast<size_t>(std::min<uint64_t>(oldest - from, k));
+        if (t) std::copy(t + lost, t + k, t);
+        if (v) std::copy(v + lost, v + k, v);
+        k    -= lost;
+        from += lost;
+    }
+    *first = from;
+    return k;
+}
+
+size_t FilterHistory::ReadLatest(int tier, int ch, size_t n, double* t, float* v) const
+{
+    if (tier < 0 || tier >= m_nTiers) return 0;
+    const uint64_t count = Count(tier);
+    uint64_t first = (count > n) ? count - n : 0;
+    return Read(tier, ch, &first, n, t, v);
+}
+
+int FilterHistory::TierFor(double age) const
+{
+    for (int i = 0; i < m_nTiers; i++) {
+        if (m_Tier[i].Period * double(m_Tier[i].Capacity) >= age) return i;
+    }
+    return m_nTiers - 1;
+}
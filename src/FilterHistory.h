@@ -0,0 +1,108 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FILTERHISTORY_H_INCLUDE__
+#define __FILTERHISTORY_H_INCLUDE__
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fixed-memory history of the filtered AD channels.
+ *
+ * Writer  : AD_INPUT() appends every filtered scan (one writer only)
+ * Readers : control, logging, display, ... (any number, any thread)
+ *
+ * Tier 0 keeps every filtered scan; each further tier keeps block means of
+ * Decimation tier-0 samples, so old data survives at lower resolution.
+ * Every tier is a ring of [sample][channel] floats plus one timestamp per
+ * sample (seconds on the acquisition clock). Samples are addressed by a
+ * free-running per-tier index; Count(tier) is the index of the next one.
+ *
+ * Reads are lock-free: a reader copies the requested range and then
+ * re-checks the write counter, trimming whatever the writer overwrote in
+ * the meantime. A read therefore never returns torn samples, only fewer.
+ */
+class FilterHistory
+{
+public:
+    enum { MAX_TIERS = 4 };
+
+    struct TierSpec {
+        unsigned Decimation;    // tier-0 samples per stored sample (1 = full rate)
+        double   Seconds;       // time span kept
+    };
+
+    FilterHistory();
+
+    // Not thread-safe: call only while acquisition is stopped.
+    // Default tiers: full rate 30 min, 1/30 rate 6 h, 1/3000 rate 7 days.
+    void Allocate(double sampleRateHz, int channels);
+    void Allocate(double sampleRateHz, int channels, const TierSpec* tiers, int nTiers);
+    void Reset();
+
+    // Writer side: one filtered scan (Channels() values) at time t [s]
+    void Append(double t, const float* values);
+
+    int      Tiers()    const { return m_nTiers; }
+    int      Channels() const { return m_Channels; }
+    size_t   Capacity(int tier) const { return m_Tier[tier].Capacity; }
+    double   Period(int tier)   const { return m_Tier[tier].Period; }   // s per stored sample
+    uint64_t Count(int tier)    const { return m_Tier[tier].Count.load(std::memory_order_acquire); }
+    uint64_t Oldest(int tier)   const;                                  // index of the oldest kept sample
+
+    // Copy up to n samples of one channel starting at index *first
+    // (t or v may be NULL). Samples already overwritten are skipped and
+    // *first is advanced accordingly. Returns the number copied.
+    size_t Read(int tier, int ch, uint64_t* first, size_t n, double* t, float* v) const;
+
+    // Copy the newest n samples of one channel (oldest first)
+    size_t ReadLatest(int tier, int ch, size_t n, double* t, float* v) const;
+
+    // Finest tier still holding data from `age` seconds ago
+    int    TierFor(double age) const;
+
+private:
+    FilterHistory(const FilterHistory&) = delete;
+    FilterHistory& operator=(const FilterHistory&) = delete;
+
+    struct Tier {
+        unsigned              Decimation;
+        double                Period;
+        size_t                Capacity;
+        std::vector<float>    Value;       // [Capacity * Channels]
+        std::vector<double>   Time;        // [Capacity]
+        std::vector<double>   AccValue;    // block sums being built (tiers > 0)
+        double                AccTime;
+        unsigned              AccCount;
+        std::atomic<uint64_t> Count;       // samples written, written by writer only
+    };
+
+    void Store(Tier& tier, double t, const float* values);
+
+    Tier               m_Tier[MAX_TIERS];
+    int                m_nTiers;
+    int                m_Channels;
+    std::vector<float> m_Mean;          // scratch for decimated tiers
+};
+
+#endif // __FILTERHISTORY_H_INCLUDE__
@@ -19,6 +19,7 @@
 #include "stdafx.h"
 #include "DigitShowBasic.h"
 #include "DigitShowBasicDoc.h"
+#include "DigitShowBasicView.h"
 
 #include "MainFrm.h"
 #include "BoardSettings.h"
@@ -50,6 +51,7 @@ IMPLEMENT_DYNCREATE(CMainFrame, CFrameWnd)
 
 BEGIN_MESSAGE_MAP(CMainFrame, CFrameWnd)
     //{{AFX_MSG_MAP(CMainFrame)
+    ON_WM_CREATE()
     ON_COMMAND(ID_BoardSettings, OnBoardSettings)
     ON_COMMAND(ID_Calibration_Factor, OnCalibrationFactor)
     ON_COMMAND(ID_SpecimenData, OnSpecimenData)
@@ -65,9 +67,18 @@ BEGIN_MESSAGE_MAP(CMainFrame, CFrameWnd)
     ON_COMMAND(ID_Control_PreConsolidation, OnControlPreConsolidation)
     ON_COMMAND(ID_TransAdjustment, OnTransAdjustment)
     ON_COMMAND(ID_Control_LinearStressPath, OnControlLinearStressPath)
+    ON_COMMAND_RANGE(ID_Rig_1, ID_Rig_4, OnSelectRig)
+    ON_UPDATE_COMMAND_UI_RANGE(ID_Rig_1, ID_Rig_4, OnUpdateSelectRig)
     //}}AFX_MSG_MAP
 END_MESSAGE_MAP()
 
+// Status bar: pane 0 menu help, pane 1 acquisition status (see CDigitShowBasicView::UpdateAiStatus)
+static UINT indicators[] =
+{
+    ID_SEPARATOR,
+    ID_SEPARATOR,
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // CMainFrame クラスの構築/消滅
 
@@ -80,6 +91,22 @@ CMainFrame::~CMainFrame()
 {
 }
 
+int CMainFrame::OnCreate(LPCREATESTRUCT lpCreateStruct)
+{
+    if (CFrameWnd::OnCreate(lpCreateStruct) == -1)
+        return -1;
+    if (!m_wndStatusBar.Create(this) ||
+        !m_wndStatusBar.SetIndicators(indicators, sizeof(indicators) / sizeof(UINT)))
+        return -1;
+    m_wndStatusBar.SetPaneInfo(1, ID_SEPARATOR, SBPS_NORMAL, 900);
+    return 0;
+}
+
+void CMainFrame::SetAiStatus(LPCTSTR text)
+{
+    if (m_wndStatusBar.GetSafeHwnd()) m_wndStatusBar.SetPaneText(1, text);
+}
+
 BOOL CMainFrame::PreCreateWindow(CREATESTRUCT& cs)
 {
 
@@ -233,3 +260,17 @@ void CMainFrame::OnControlFile()
     CControl_File Control_File;
     nResult = Control_File.DoModal();    
 }
+
+// Rig menu: rig 1 always, rigs 2..4 when their configuration opened a board
+void CMainFrame::OnSelectRig(UINT nID)
+{
+    CDigitShowBasicView* pView = static_cast<CDigitShowBasicView*>(GetActiveView());
+    if (pView) pView->SelectRig(int(nID - ID_Rig_1));
+}
+
+void CMainFrame::OnUpdateSelectRig(CCmdUI* pCmdUI)
+{
+    const int rig = int(pCmdUI->m_nID - ID_Rig_1);
+    pCmdUI->Enable(rig == 0 || GetRigContext(rig)->runner.Running());
+    pCmdUI->SetCheck(rig == BoundRig());
+}
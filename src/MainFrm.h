@@ -32,6 +32,7 @@ public:
 
 public:
     virtual ~CMainFrame();
+    void SetAiStatus(LPCTSTR text);
 
 #ifdef _DEBUG
     virtual void AssertValid() const;
@@ -40,8 +41,10 @@ public:
 
 private:
     int nResult;
+    CStatusBar m_wndStatusBar;
 
 protected:
+    afx_msg int  OnCreate(LPCREATESTRUCT lpCreateStruct);
     afx_msg void OnBoardSettings();
     afx_msg void OnCalibrationFactor();
     afx_msg void OnSpecimenData();
@@ -57,6 +60,8 @@ protected:
     afx_msg void OnControlPreConsolidation();
     afx_msg void OnTransAdjustment();
     afx_msg void OnControlLinearStressPath();
+    afx_msg void OnSelectRig(UINT nID);
+    afx_msg void OnUpdateSelectRig(CCmdUI* pCmdUI);
     DECLARE_MESSAGE_MAP()
 };
 
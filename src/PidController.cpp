@@ -0,0 +1,111 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PidController.h"
+
+#include <algorithm>
+#include <cmath>
+
+void SetDefaultPidParams(PidParams* p)
+{
+    p->Enabled  = false;
+    p->Kp       = 0.0;
+    p->Ki       = 0.0;
+    p->Kd       = 0.0;
+    p->Tf       = 0.0;
+    p->Kff      = 0.0;
+    p->Slew     = 0.0;
+    p->Deadband = 0.0;
+    p->OutMax   = 0.0;
+}
+
+PidController::PidController()
+    : m_Lo(-HUGE_VAL), m_Hi(HUGE_VAL)
+    , m_Sp(0.0), m_I(0.0), m_Y(0.0), m_dY(0.0), m_Out(0.0), m_Fresh(true)
+{
+    SetDefaultPidParams(&m_P);
+}
+
+void PidController::Configure(const PidParams& p)
+{
+    m_P = p;
+}
+
+void PidController::SetLimits(double lo, double hi)
+{
+    m_Lo = lo;
+    m_Hi = hi;
+    if (m_P.OutMax > 0.0) {
+        m_Lo = std::max(m_Lo, -m_P.OutMax);
+        m_Hi = std::min(m_Hi,  m_P.OutMax);
+    }
+}
+
+double PidController::Error(double measurement) const
+{
+    const double e = m_Sp - measurement;
+    if (std::fabs(e) <= m_P.Deadband) return 0.0;
+    return (e > 0.0) ? e - m_P.Deadband : e + m_P.Deadband;
+}
+
+void PidController::Reset(double output)
+{
+    m_Out   = output;
+    m_Fresh = true;
+}
+
+double PidController::Update(double target, double rate, double measurement, double dt)
+{
+    if (m_Fresh) {
+        // Ramps start where the specimen is; the integral holds the output
+        m_Fresh = false;
+        m_Sp = (rate > 0.0) ? measurement : target;
+        m_Y  = measurement;
+        m_dY = 0.0;
+        m_I  = m_Out - m_P.Kp * Error(measurement);
+    }
+    if (dt <= 0.0) return m_Out;
+
+    // Setpoint generator: ramp toward the target; its velocity is fed forward
+    const double sp0  = m_Sp;
+    const double diff = target - m_Sp;
+    if (rate > 0.0 && std::fabs(diff) > rate * dt) m_Sp += (diff > 0.0) ? rate * dt : -rate * dt;
+    else                                           m_Sp  = target;
+    const double ffRate = (m_Sp - sp0) / dt;
+
+    const double e = Error(measurement);
+
+    // Derivative of the measurement through a first-order low-pass
+    const double dy    = (measurement - m_Y) / dt;
+    const double alpha = (m_P.Tf > 0.0) ? dt / (m_P.Tf + dt) : 1.0;
+    m_dY += alpha * (dy - m_dY);
+    m_Y   = measurement;
+
+    m_I += m_P.Ki * e * dt;
+    const double u = m_P.Kff * ffRate + m_P.Kp * e + m_I - m_P.Kd * m_dY;
+
+    double out = std::min(std::max(u, m_Lo), m_Hi);
+    if (m_P.Slew > 0.0) {
+        const double step = m_P.Slew * dt;
+        out = std::min(std::max(out, m_Out - step), m_Out + step);
+    }
+    // Back-calculation: keep the unclamped output equal to the applied one
+    if (m_P.Ki != 0.0) m_I += out - u;
+    m_Out = out;
+    return m_Out;
+}
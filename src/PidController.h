@@ -0,0 +1,93 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PIDCONTROLLER_H_INCLUDE__
+#define __PIDCONTROLLER_H_INCLUDE__
+
+#pragma once
+
+#define PID_CONTROL_IDS 16   // one parameter set per control ID (ControlID 0..15)
+
+/**
+ * PID gains and limits of one actuator channel.
+ *
+ * Units follow the channel: motor output in rpm (signed, > 0 loads the
+ * specimen), cell output in kPa of cell pressure. Measurement and
+ * setpoint in kPa (or % strain).
+ */
+struct PidParams {
+    bool   Enabled;    // false: the control law keeps its legacy on/off logic
+    double Kp;         // output per unit error
+    double Ki;         // output per unit error·s
+    double Kd;         // output per unit (measurement/s)
+    double Tf;         // s, first-order filter on the measurement derivative
+    double Kff;        // output per unit (setpoint/s): feedforward of the setpoint ramp
+    double Slew;       // output units/s, 0 = unlimited
+    double Deadband;   // |error| below this counts as zero
+    double OutMax;     // |output| cap (0 = channel limit only)
+};
+
+void SetDefaultPidParams(PidParams* p);
+
+/**
+ * Positional PID with
+ *  - setpoint ramp: the setpoint moves toward the target at a given rate
+ *    (e.g. sigmaRate); the setpoint velocity is the feedforward input, so
+ *    ramps and moving targets (stress paths) are followed without lag,
+ *  - derivative on the filtered measurement (no kick on setpoint steps),
+ *  - output clamp and slew limit with back-calculation anti-windup: the
+ *    integral absorbs whatever the limits cut off, so it never winds up,
+ *  - bumpless Reset() to the output currently applied.
+ */
+class PidController
+{
+public:
+    PidController();
+
+    void Configure(const PidParams& p);
+    const PidParams& Params() const { return m_P; }
+    bool Enabled() const            { return m_P.Enabled; }
+
+    // Output range of the actuator, narrowed further by Params().OutMax
+    void SetLimits(double lo, double hi);
+
+    // Bumpless restart from the output now applied; the next Update()
+    // takes its measurement as the start of the setpoint ramp
+    void Reset(double output);
+
+    // target: final setpoint; rate: ramp speed toward it [units/s], 0 = step.
+    // Returns the new output.
+    double Update(double target, double rate, double measurement, double dt);
+
+    double Output() const   { return m_Out; }
+    double Setpoint() const { return m_Sp; }
+
+private:
+    double Error(double measurement) const;
+
+    PidParams m_P;
+    double m_Lo, m_Hi;
+    double m_Sp;        // ramped setpoint
+    double m_I;         // integral term (output units)
+    double m_Y;         // previous measurement
+    double m_dY;        // filtered measurement derivative
+    double m_Out;
+    bool   m_Fresh;     // Reset() pending
+};
+
+#endif // __PIDCONTROLLER_H_INCLUDE__
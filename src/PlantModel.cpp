@@ -0,0 +1,311 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PlantModel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+const double kPi      = 3.14159265358979323846;
+const double kMaxStep = 1e-3;   // s, integration sub-step
+
+} // namespace
+
+void SetDefaultPlantConfig(PlantConfig* cfg)
+{
+    cfg->Height   = 100.0;
+    cfg->Diameter = 50.0;
+    cfg->Ldt      = 0.0;
+    cfg->Lead     = 2e-4;       // 300 rpm -> 0.06 mm/min
+    cfg->MotorA   = 0.01;       // 1000 rpm = 10 V
+    cfg->MotorB   = 0.0;
+    cfg->MotorTau = 0.2;
+    cfg->CellA    = 0.01;       // 1000 kPa = 10 V
+    cfg->CellB    = 0.0;
+    cfg->CellTau  = 2.0;
+    cfg->Back     = 0.0;
+    cfg->E        = 100000.0;
+    cfg->K        = 50000.0;
+    cfg->Qy       = 50.0;
+    cfg->H        = 10000.0;
+    cfg->M        = 1.2;
+    cfg->Beta     = 0.2;
+    cfg->P0       = 0.0;
+    cfg->NoiseMv  = 0.5;
+    for (int ch = 0; ch < PLANT_AI_CHANNELS; ch++) {
+        cfg->SensorB[ch] = 0.0;
+        cfg->SensorC[ch] = 0.0;
+    }
+    cfg->SensorB[0] = 1000.0;   // N/V
+    cfg->SensorB[1] = 4.0;      // mm/V
+    cfg->SensorB[4] = 200.0;    // kPa/V
+    cfg->SensorB[8] = 200.0;    // kPa/V
+    cfg->SensorB[9] = 5000.0;   // mm³/V
+}
+
+/*
+ * Plant configuration file: one directive per line, '#' starts a comment.
+ *
+ *   specimen H D [LDT]        initial height, diameter, LDT gauge length [mm]
+ *                             (LDT > 0 also sets sensors 2 and 3 to 0.5 mm/V)
+ *   lead L                    platen travel per motor revolution [mm]
+ *   motor a b [tau]           DA ch 2 calibration (V = a·rpm + b), speed lag [s]
+ *   cell a b [tau]            DA ch 3 calibration (V = a·kPa + b), servo lag [s]
+ *   back U                    back pressure [kPa]
+ *   soil key=value ...        E K qy H M beta p0 (kPa; M, beta dimensionless)
+ *   sensor ch b [c]           channel output v = (value − c) / b; b = 0: unused
+ *   noise mV                  white noise on every channel
+ */
+bool LoadPlantConfig(const char* path, PlantConfig* cfg, std::string* err)
+{
+    FILE* fp = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&fp, path, "r") != 0) fp = nullptr;
+#else
+    fp = std::fopen(path, "r");
+#endif
+    if (fp == nullptr) return true;
+
+    PlantConfig out = *cfg;
+    char line[512];
+    int  lineNo = 0;
+    bool ok     = true;
+    while (ok && std::fgets(line, sizeof(line), fp) != nullptr) {
+        lineNo++;
+        if (char* hash = std::strchr(line, '#')) *hash = '\0';
+        std::istringstream in(line);
+        std::string cmd;
+        if (!(in >> cmd)) continue;
+
+        if (cmd == "specimen") {
+            ok = (in >> out.Height >> out.Diameter) && out.Height > 0.0 && out.Diameter > 0.0;
+            double ldt;
+            if (ok && (in >> ldt) && ldt > 0.0) {
+                // LDTs read 0.5 mm/V around the gauge length ("sensor" overrides)
+                out.Ldt = ldt;
+                out.SensorB[2] = out.SensorB[3] = 0.5;
+                out.SensorC[2] = out.SensorC[3] = ldt;
+            }
+        }
+        else if (cmd == "lead") {
+            ok = (in >> out.Lead) && out.Lead > 0.0;
+        }
+        else if (cmd == "motor" || cmd == "cell") {
+            double a, b, tau;
+            ok = (in >> a >> b) && a != 0.0;
+            if (ok && !(in >> tau)) tau = (cmd == "motor") ? out.MotorTau : out.CellTau;
+            ok = ok && tau >= 0.0;
+            if (ok && cmd == "motor") { out.MotorA = a; out.MotorB = b; out.MotorTau = tau; }
+            if (ok && cmd == "cell")  { out.CellA  = a; out.CellB  = b; out.CellTau  = tau; }
+        }
+        else if (cmd == "back") {
+            ok = bool(in >> out.Back);
+        }
+        else if (cmd == "soil") {
+            std::string tok;
+            while (ok && (in >> tok)) {
+                const size_t eq = tok.find('=');
+                char* end = nullptr;
+                const double v = (eq == std::string::npos) ? 0.0 : std::strtod(tok.c_str() + eq + 1, &end);
+                ok = eq != std::string::npos && end != tok.c_str() + eq + 1 && *end == '\0' && v >= 0.0;
+                if (!ok) break;
+                const std::string key = tok.substr(0, eq);
+                if      (key == "E")    ok = (out.E = v) > 0.0;
+                else if (key == "K")    ok = (out.K = v) > 0.0;
+                else if (key == "qy")   out.Qy = v;
+                else if (key == "H")    out.H = v;
+                else if (key == "M")    out.M = v;
+                else if (key == "beta") out.Beta = v;
+                else if (key == "p0")   out.P0 = v;
+                else ok = false;
+            }
+        }
+        else if (cmd == "sensor") {
+            int ch;
+            double b, c = 0.0;
+            ok = (in >> ch >> b) && ch >= 0 && ch < PLANT_AI_CHANNELS;
+            if (ok && (in >> c)) {}
+            if (ok) { out.SensorB[ch] = b; out.SensorC[ch] = c; }
+        }
+        else if (cmd == "noise") {
+            ok = (in >> out.NoiseMv) && out.NoiseMv >= 0.0;
+        }
+        else {
+            ok = false;
+        }
+    }
+    std::fclose(fp);
+
+    if (!ok) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%s(%d): ", path, lineNo);
+        *err = std::string(buf) + "invalid directive";
+        return false;
+    }
+    *cfg = out;
+    return true;
+}
+
+const char* GetPlantConfigPath()
+{
+    static std::string path;
+    if (path.empty()) {
+#ifdef _MSC_VER
+        char*  buf = nullptr;
+        size_t len = 0;
+        if (_dupenv_s(&buf, &len, "DIGITSHOW_PLANT") == 0 && buf != nullptr) {
+            path = buf;
+            free(buf);
+        }
+#else
+        const char* env = std::getenv("DIGITSHOW_PLANT");
+        if (env != nullptr) path = env;
+#endif
+        if (path.empty()) path = "DigitShowPlant.cfg";
+    }
+    return path.c_str();
+}
+
+// ── PlantModel ──────────────────────────────────────────────
+
+PlantModel::PlantModel()
+    : m_Noise(0x9E3779B9u)
+{
+    PlantConfig cfg;
+    SetDefaultPlantConfig(&cfg);
+    Configure(cfg);
+}
+
+void PlantModel::Configure(const PlantConfig& cfg)
+{
+    m_Cfg = cfg;
+    Reset();
+}
+
+void PlantModel::Reset()
+{
+    for (int j = 0; j < PLANT_AO_CHANNELS; j++) m_Ao[j] = 0.0;
+    m_T     = 0.0;
+    m_Rpm   = 0.0;
+    m_D     = 0.0;
+    m_Sr    = m_Cfg.P0 + m_Cfg.Back;
+    m_Q     = 0.0;
+    m_Ep    = 0.0;
+    m_Alpha = 0.0;
+    m_EpSum = 0.0;
+    m_Ev    = 0.0;
+}
+
+void PlantModel::SetAo(const double* volts, int channels)
+{
+    for (int j = 0; j < channels && j < PLANT_AO_CHANNELS; j++) m_Ao[j] = volts[j];
+}
+
+double PlantModel::AxialStrain() const
+{
+    return -std::log((m_Cfg.Height - m_D) / m_Cfg.Height) * 100.0;
+}
+
+void PlantModel::AdvanceTo(double t)
+{
+    while (m_T < t) {
+        const double dt = (t - m_T < kMaxStep) ? t - m_T : kMaxStep;
+        Step(dt);
+        m_T += dt;
+    }
+}
+
+void PlantModel::Step(double dt)
+{
+    const PlantConfig& c = m_Cfg;
+
+    // Frame: clutch up (> 2.5 V) unloads; speed 0 V means stopped
+    double target = 0.0;
+    if (m_Ao[0] > 2.5 && m_Ao[2] > 0.0) {
+        const double rpm = (m_Ao[2] - c.MotorB) / c.MotorA;
+        target = (rpm > 0.0 ? rpm : 0.0) * (m_Ao[1] > 2.5 ? -1.0 : 1.0);
+    }
+    m_Rpm += (c.MotorTau > 0.0) ? (target - m_Rpm) * (1.0 - std::exp(-dt / c.MotorTau)) : target - m_Rpm;
+    m_D += m_Rpm / 60.0 * c.Lead * dt;
+    if (m_D > 0.5 * c.Height) m_D = 0.5 * c.Height;
+    const double ea = -std::log((c.Height - m_D) / c.Height);
+
+    // Cell pressure servo
+    const double cmd = (m_Ao[3] - c.CellB) / c.CellA;
+    m_Sr += (c.CellTau > 0.0) ? (cmd - m_Sr) * (1.0 - std::exp(-dt / c.CellTau)) : cmd - m_Sr;
+    const double esr = m_Sr - c.Back;
+
+    // Soil: elastic trial, kinematic hardening, then the M·p' bound
+    double q = c.E * (ea - m_Ep);
+    const double f = std::fabs(q - m_Alpha) - c.Qy;
+    if (f > 0.0) {
+        const double dep = f / (c.E + c.H) * (q > m_Alpha ? 1.0 : -1.0);
+        m_Ep    += dep;
+        m_Alpha += c.H * dep;
+        m_EpSum += std::fabs(dep);
+        q = c.E * (ea - m_Ep);
+    }
+    // |q| <= M·p', p' = esr + q/3  ->  q <= 3M·esr/(3 − M) (compression), q >= −3M·esr/(3 + M)
+    const double pq = (esr > 0.0) ? esr : 0.0;
+    const double qMax = (c.M < 3.0) ? 3.0 * c.M * pq / (3.0 - c.M) : 1e12;
+    const double qMin = -3.0 * c.M * pq / (3.0 + c.M);
+    if (q > qMax || q < qMin) {
+        const double qc = (q > qMax) ? qMax : qMin;
+        m_EpSum += std::fabs((q - qc) / c.E);
+        m_Ep     = ea - qc / c.E;
+        q = qc;
+    }
+    m_Q = q;
+
+    // Drained volume change: elastic p' plus compaction
+    const double pe = esr + q / 3.0;
+    m_Ev = (pe - c.P0) / c.K + c.Beta * m_EpSum;
+}
+
+void PlantModel::Sensors(double volts[PLANT_AI_CHANNELS])
+{
+    const PlantConfig& c = m_Cfg;
+    const double v0   = kPi / 4.0 * c.Diameter * c.Diameter * c.Height;
+    const double h    = c.Height - m_D;
+    const double vol  = v0 * std::exp(-m_Ev);
+    const double area = vol / h;
+    const double ea   = AxialStrain() / 100.0;
+
+    double value[PLANT_AI_CHANNELS] = {};
+    value[0] = m_Q * area / 1000.0;
+    value[1] = m_D;
+    value[2] = c.Ldt * std::exp(-ea);
+    value[3] = c.Ldt * std::exp(-ea);
+    value[4] = m_Sr;
+    value[8] = m_Sr - c.Back;
+    value[9] = v0 - vol;
+
+    for (int ch = 0; ch < PLANT_AI_CHANNELS; ch++) {
+        double v = (c.SensorB[ch] != 0.0) ? (value[ch] - c.SensorC[ch]) / c.SensorB[ch] : 0.0;
+        m_Noise ^= m_Noise << 13;
+        m_Noise ^= m_Noise >> 17;
+        m_Noise ^= m_Noise << 5;
+        v += 2e-3 * c.NoiseMv * (double(m_Noise) / 4294967295.0 - 0.5);
+        volts[ch] = v;
+    }
+}
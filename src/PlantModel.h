@@ -0,0 +1,122 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLANTMODEL_H_INCLUDE__
+#define __PLANTMODEL_H_INCLUDE__
+
+#pragma once
+
+#include <string>
+
+#define PLANT_AI_CHANNELS 16
+#define PLANT_AO_CHANNELS  8
+
+/**
+ * Triaxial test rig model for the "plant" device backend.
+ *
+ *  - Loading frame: motor on/off (DA ch 0), clutch up/down (DA ch 1) and
+ *    speed (DA ch 2) with a first-order speed lag; the platen moves by
+ *    Lead mm per motor revolution.
+ *  - Cell pressure servo (DA ch 3): first-order lag to the commanded
+ *    pressure; constant back pressure, drained specimen.
+ *  - Soil: axial q–ea elastic-plastic with linear kinematic hardening,
+ *    bounded by |q| <= M·p'; volumetric strain from p'/K plus compaction
+ *    proportional to plastic axial strain.
+ *
+ * Sensors follow the channel use of Cal_Param(): ch 0 load [N], 1 axial
+ * displacement [mm], 2/3 LDT lengths [mm], 4 cell pressure [kPa],
+ * 8 effective cell pressure [kPa], 9 volume change [mm³]. A sensor with
+ * "sensor ch b c" outputs v = (value − c) / b, i.e. a calibration file
+ * with a = 0, b, c reads the value back. The DA inputs are decoded with
+ * the same numbers as the DA calibration (v = a·x + b).
+ */
+struct PlantConfig {
+    double Height;          // mm, initial specimen height
+    double Diameter;        // mm
+    double Ldt;             // mm, LDT gauge length (0 = no LDT)
+    double Lead;            // mm of platen travel per motor revolution
+    double MotorA, MotorB;  // DA ch 2: V = A·rpm + B
+    double MotorTau;        // s
+    double CellA, CellB;    // DA ch 3: V = A·kPa + B
+    double CellTau;         // s
+    double Back;            // kPa, back (pore) pressure
+    double E;               // kPa, Young's modulus (axial)
+    double K;               // kPa, bulk modulus
+    double Qy;              // kPa, initial yield deviator stress
+    double H;               // kPa, kinematic hardening modulus
+    double M;               // q/p' at failure
+    double Beta;            // volumetric / plastic axial strain (compaction)
+    double P0;              // kPa, initial effective cell pressure
+    double NoiseMv;         // mV rms-ish white noise on every channel
+    double SensorB[PLANT_AI_CHANNELS];   // value per volt (0 = channel unused)
+    double SensorC[PLANT_AI_CHANNELS];   // value at 0 V
+};
+
+void SetDefaultPlantConfig(PlantConfig* cfg);
+
+// Parse a plant configuration file (see PlantModel.cpp for the syntax).
+// A missing file leaves the defaults; a syntax error returns false and
+// names the offending line in *err.
+bool LoadPlantConfig(const char* path, PlantConfig* cfg, std::string* err);
+
+// DIGITSHOW_PLANT if set, otherwise "DigitShowPlant.cfg"
+const char* GetPlantConfigPath();
+
+class PlantModel
+{
+public:
+    PlantModel();
+
+    void Configure(const PlantConfig& cfg);
+    void Reset();
+
+    // DA outputs [V] of channels 0..channels-1 in effect from now on
+    void SetAo(const double* volts, int channels = PLANT_AO_CHANNELS);
+
+    // Integrate up to time t [s] (no-op for t <= Time())
+    void AdvanceTo(double t);
+    double Time() const { return m_T; }
+
+    // Sensor voltages at the present state
+    void Sensors(double volts[PLANT_AI_CHANNELS]);
+
+    // State (for diagnostics)
+    double Displacement() const { return m_D; }         // mm, compression +
+    double Deviator() const { return m_Q; }              // kPa
+    double CellPressure() const { return m_Sr; }         // kPa
+    double AxialStrain() const;                          // %, log strain
+    double VolumetricStrain() const { return m_Ev * 100.0; }   // %
+
+private:
+    void Step(double dt);
+
+    PlantConfig m_Cfg;
+    double   m_Ao[PLANT_AO_CHANNELS];
+    double   m_T;
+    double   m_Rpm;      // actual motor speed (signed, + = loading)
+    double   m_D;        // platen displacement [mm]
+    double   m_Sr;       // cell pressure [kPa]
+    double   m_Q;        // deviator stress [kPa]
+    double   m_Ep;       // plastic axial strain
+    double   m_Alpha;    // back stress [kPa]
+    double   m_EpSum;    // accumulated |plastic axial strain|
+    double   m_Ev;       // volumetric strain (compression +)
+    unsigned m_Noise;    // xorshift32 state
+};
+
+#endif // __PLANTMODEL_H_INCLUDE__
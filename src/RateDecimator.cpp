@@ -0,0 +1,93 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "RateDecimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FilterChain.h"
+
+RateDecimator::RateDecimator()
+    : m_Fs(0.0), m_Interval(0.0), m_Channels(0), m_Windows(0), m_M(1)
+    , m_OutTime(0.0), m_Phase(0), m_Block(0), m_Inputs(0)
+{
+}
+
+void RateDecimator::Configure(double fsHz, double intervalSec, int channels, int windows)
+{
+    if (fsHz == m_Fs && intervalSec == m_Interval && channels == m_Channels && windows == m_Windows)
+        return;
+    m_Fs       = fsHz;
+    m_Interval = intervalSec;
+    m_Channels = std::max(channels, 0);
+    m_Windows  = std::max(windows, 1);
+    m_M        = std::max(int(std::floor(fsHz * intervalSec + 0.5)), 1);
+
+    const int taps = m_Windows * m_M;
+    if (m_Windows == 1) m_H.assign(taps, 1.0 / taps);                   // block mean
+    else                m_H = DesignLowpassFir(taps, 0.5 * fsHz / m_M, fsHz);
+
+    m_Acc.assign(size_t(m_Windows) * m_Channels, 0.0);
+    m_Out.assign(m_Channels, 0.0f);
+    Reset();
+}
+
+void RateDecimator::Reset()
+{
+    std::fill(m_Acc.begin(), m_Acc.end(), 0.0);
+    m_OutTime = 0.0;
+    m_Phase   = 0;
+    m_Block   = 0;
+    m_Inputs  = 0;
+}
+
+double RateDecimator::Delay() const
+{
+    return (m_Fs > 0.0) ? 0.5 * double(m_H.size() - 1) / m_Fs : 0.0;
+}
+
+bool RateDecimator::Push(double t, const float* in)
+{
+    if (m_Channels == 0) return false;
+
+    // Input at phase p of block b feeds the outputs ending blocks b .. b+W-1;
+    // for the output ending k blocks later it lies d = k·M + (M-1-p) samples back.
+    const int back = m_M - 1 - m_Phase;
+    for (int k = 0; k < m_Windows; k++) {
+        const double h   = m_H[size_t(k) * m_M + back];
+        double*      acc = &m_Acc[size_t((m_Block + k) % m_Windows) * m_Channels];
+        for (int ch = 0; ch < m_Channels; ch++) acc[ch] += h * in[ch];
+    }
+    m_Inputs++;
+
+    if (!Ready()) std::copy(in, in + m_Channels, m_Out.begin());
+
+    if (++m_Phase < m_M) return false;
+    m_Phase = 0;
+
+    // Block complete: its accumulator now holds a full output
+    double* acc = &m_Acc[size_t(m_Block) * m_Channels];
+    if (Ready()) {
+        for (int ch = 0; ch < m_Channels; ch++) m_Out[ch] = float(acc[ch]);
+        m_OutTime = t - Delay();
+    }
+    std::fill(acc, acc + m_Channels, 0.0);
+    m_Block = (m_Block + 1) % m_Windows;
+    return Ready();
+}
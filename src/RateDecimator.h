@@ -0,0 +1,79 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RATEDECIMATOR_H_INCLUDE__
+#define __RATEDECIMATOR_H_INCLUDE__
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Multi-channel polyphase decimator from the filtered scan rate down to a
+ * consumer rate (control: ControlInterval, logging: SaveInterval).
+ *
+ * Decimation M = round(Fs × interval); the anti-alias low-pass is a
+ * windowed-sinc FIR of L = Windows × M taps with cutoff Fs/(2M). Instead
+ * of keeping L samples of history, every input is multiplied into the
+ * Windows partial outputs it contributes to (one accumulator per pending
+ * output), so a scan costs Windows × Channels multiply-adds and an
+ * output is ready the moment its last input arrives.
+ *
+ * Group delay is (L-1)/2 input samples; OutputTime() is the time of the
+ * window centre. Until the first L inputs have been seen, Output() simply
+ * follows the latest input.
+ */
+class RateDecimator
+{
+public:
+    RateDecimator();
+
+    // (Re)configure; does nothing if the parameters are unchanged.
+    // windows = filter length in output periods (1 = plain block mean).
+    void Configure(double fsHz, double intervalSec, int channels, int windows);
+    void Reset();
+
+    // Feed one filtered scan taken at time t [s].
+    // Returns true when a new decimated output was produced.
+    bool Push(double t, const float* in);
+
+    bool         Configured() const { return m_Channels > 0; }
+    const float* Output() const     { return m_Out.data(); }
+    double       OutputTime() const { return m_OutTime; }
+    bool         Ready() const      { return m_Inputs >= m_H.size(); }
+    int          Factor() const     { return m_M; }
+    double       Delay() const;     // group delay [s]
+
+private:
+    double m_Fs;
+    double m_Interval;
+    int    m_Channels;
+    int    m_Windows;
+    int    m_M;
+
+    std::vector<double> m_H;        // L taps, h[d] weights the input d samples before the output
+    std::vector<double> m_Acc;      // [Windows][Channels] partial outputs
+    std::vector<float>  m_Out;
+    double m_OutTime;
+    int    m_Phase;                 // input index within the current block
+    int    m_Block;                 // accumulator slot of the block being completed
+    size_t m_Inputs;
+};
+
+#endif // __RATEDECIMATOR_H_INCLUDE__
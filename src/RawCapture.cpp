@@ -0,0 +1,369 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "RawCapture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const size_t kNone      = size_t(-1);
+const size_t kFileHead  = 4 + 4 + 4 + 8 + 4 + 4 + 4;
+const size_t kBlockHead = 4 + 4 + 8 + 8 + 4;    // tag, bytes, first, time, scans
+const size_t kMaxVarint = 5;                    // bytes of a 32-bit LEB128
+
+FILE* OpenFile(const char* path, const char* mode)
+{
+    FILE* fp = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&fp, path, mode) != 0) fp = nullptr;
+#else
+    fp = std::fopen(path, mode);
+#endif
+    return fp;
+}
+
+int FileSeek(FILE* fp, long long offset, int origin)
+{
+#ifdef _MSC_VER
+    return _fseeki64(fp, offset, origin);
+#else
+    return fseeko(fp, static_cast<off_t>(offset), origin);
+#endif
+}
+
+long long FileTell(FILE* fp)
+{
+#ifdef _MSC_VER
+    return _ftelli64(fp);
+#else
+    return static_cast<long long>(ftello(fp));
+#endif
+}
+
+template <typename T>
+void Put(uint8_t* p, T v) { std::memcpy(p, &v, sizeof(v)); }
+
+template <typename T>
+T Get(const uint8_t* p) { T v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+// Small changes of either sign -> small unsigned values
+inline uint32_t ZigZag(int32_t d)   { return (uint32_t(d) << 1) ^ uint32_t(d >> 31); }
+inline int32_t  UnZigZag(uint32_t u) { return int32_t(u >> 1) ^ -int32_t(u & 1); }
+
+} // namespace
+
+// ============================================================
+// RawCaptureWriter
+// ============================================================
+
+RawCaptureWriter::RawCaptureWriter()
+    : m_File(nullptr), m_Channels(0), m_Active(false),
+      m_First(0), m_Time0(0.0), m_Period(0.0), m_BlockScans(0), m_MaxScans(1), m_Scans(0),
+      m_Stop(false), m_Bytes(0), m_Dropped(0)
+{
+}
+
+RawCaptureWriter::~RawCaptureWriter()
+{
+    if (m_Active) Close();
+    Wait();
+}
+
+bool RawCaptureWriter::Open(const char* path, const RawCaptureHeader& header, std::string* err)
+{
+    if (m_Active) Close();
+    Wait();
+    if (header.Channels <= 0 || header.ScanPeriod <= 0.0) {
+        if (err) *err = "no AD channels to capture";
+        return false;
+    }
+    m_File = OpenFile(path, "wb");
+    if (m_File == nullptr) {
+        if (err) *err = std::string("cannot create ") + path;
+        return false;
+    }
+    uint8_t head[kFileHead];
+    std::memcpy(head, "DSRW", 4);
+    Put<uint32_t>(head + 4,  RAW_FILE_VERSION);
+    Put<uint32_t>(head + 8,  uint32_t(header.Channels));
+    Put<double>  (head + 12, header.ScanPeriod);
+    Put<float>   (head + 20, header.RangeMax);
+    Put<float>   (head + 24, header.RangeMin);
+    Put<uint32_t>(head + 28, uint32_t(header.Resolution));
+    if (std::fwrite(head, 1, kFileHead, m_File) != kFileHead || std::fflush(m_File) != 0) {
+        std::fclose(m_File);
+        m_File = nullptr;
+        if (err) *err = std::string("cannot write ") + path;
+        return false;
+    }
+
+    m_Path       = path;
+    m_Channels   = header.Channels;
+    m_Period     = header.ScanPeriod;
+    m_MaxScans   = uint32_t(std::max(1.0, RAW_BLOCK_SECONDS / header.ScanPeriod));
+    m_Prev.assign(m_Channels, 0);
+    m_Block.clear();
+    m_Block.reserve(RAW_BLOCK_BYTES + kBlockHead + kMaxVarint * m_Channels);
+    m_Free.assign(1, std::vector<uint8_t>());
+    m_Free[0].reserve(m_Block.capacity());
+    m_Full.clear();
+    m_BlockScans = 0;
+    m_Scans = 0;
+    m_Stop  = false;
+    m_Bytes.store(kFileHead);
+    m_Dropped.store(0);
+    m_Active = true;
+    m_Thread = std::thread(&RawCaptureWriter::Loop, this);
+    return true;
+}
+
+void RawCaptureWriter::Push(uint64_t scan, double t, const long* codes)
+{
+    if (!m_Active) return;
+    // A gap in the index or in time (restart) starts a new block
+    if (m_BlockScans > 0
+     && (scan != m_First + m_BlockScans
+      || std::fabs(t - m_Time0 - double(m_BlockScans) * m_Period) > 0.5 * m_Period)) Submit();
+    if (m_BlockScans == 0) {
+        m_Block.resize(kBlockHead);
+        std::memcpy(&m_Block[0], "SCNS", 4);
+        Put<uint64_t>(&m_Block[8],  scan);
+        Put<double>  (&m_Block[16], t);
+        std::fill(m_Prev.begin(), m_Prev.end(), 0);
+        m_First = scan;
+        m_Time0 = t;
+    }
+
+    // Reserve the worst case once; the loop then writes without checks
+    size_t pos = m_Block.size();
+    m_Block.resize(pos + kMaxVarint * m_Channels);
+    uint8_t* out = m_Block.data();
+    for (int ch = 0; ch < m_Channels; ch++) {
+        const int32_t code = int32_t(codes[ch]);
+        uint32_t u = ZigZag(code - m_Prev[ch]);
+        m_Prev[ch] = code;
+        while (u >= 0x80) {
+            out[pos++] = uint8_t(u | 0x80);
+            u >>= 7;
+        }
+        out[pos++] = uint8_t(u);
+    }
+    m_Block.resize(pos);
+
+    m_BlockScans++;
+    m_Scans++;
+    if (pos >= RAW_BLOCK_BYTES + kBlockHead || m_BlockScans >= m_MaxScans) Submit();
+}
+
+// Completes the block header and queues the block for the writer
+void RawCaptureWriter::Submit()
+{
+    if (m_BlockScans == 0) return;
+    Put<uint32_t>(&m_Block[4],  uint32_t(m_Block.size() - kBlockHead));
+    Put<uint32_t>(&m_Block[24], m_BlockScans);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Full.size() >= RAW_QUEUE_BLOCKS) {
+            m_Dropped.fetch_add(m_BlockScans, std::memory_order_relaxed);
+            m_Block.clear();
+        }
+        else {
+            m_Full.push_back(std::move(m_Block));
+            m_Block.clear();
+            if (!m_Free.empty()) {
+                m_Block.swap(m_Free.back());
+                m_Free.pop_back();
+            }
+        }
+    }
+    m_Wake.notify_one();
+    m_BlockScans = 0;
+}
+
+void RawCaptureWriter::Close()
+{
+    if (!m_Active) return;
+    Submit();
+    m_Active = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wake.notify_one();
+}
+
+void RawCaptureWriter::Wait()
+{
+    if (m_Thread.joinable()) m_Thread.join();
+}
+
+void RawCaptureWriter::Loop()
+{
+    std::vector<uint8_t> block;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (block.capacity() > 0) {
+                block.clear();
+                m_Free.push_back(std::move(block));     // back to the pipeline
+            }
+            m_Wake.wait(lock, [this]() { return m_Stop || !m_Full.empty(); });
+            if (m_Full.empty()) break;              // stopped and drained
+            block = std::move(m_Full.front());
+            m_Full.pop_front();
+        }
+        if (m_File && std::fwrite(block.data(), 1, block.size(), m_File) == block.size()) {
+            std::fflush(m_File);
+            m_Bytes.fetch_add(block.size(), std::memory_order_relaxed);
+        }
+        else {
+            m_Dropped.fetch_add(Get<uint32_t>(&block[24]), std::memory_order_relaxed);
+        }
+    }
+    if (m_File) std::fclose(m_File);
+    m_File = nullptr;
+}
+
+// ============================================================
+// RawCaptureReader
+// ============================================================
+
+RawCaptureReader::RawCaptureReader()
+    : m_File(nullptr), m_Header(), m_Total(0), m_Loaded(kNone)
+{
+}
+
+RawCaptureReader::~RawCaptureReader()
+{
+    Close();
+}
+
+bool RawCaptureReader::IsCapture(FILE* fp)
+{
+    char magic[4] = {};
+    const bool ok = FileSeek(fp, 0, SEEK_SET) == 0
+                 && std::fread(magic, 1, 4, fp) == 4
+                 && std::memcmp(magic, "DSRW", 4) == 0;
+    FileSeek(fp, 0, SEEK_SET);
+    return ok;
+}
+
+bool RawCaptureReader::Open(const char* path, std::string* err)
+{
+    Close();
+    m_File = OpenFile(path, "rb");
+    if (m_File == nullptr) {
+        if (err) *err = std::string("cannot open ") + path;
+        return false;
+    }
+    uint8_t head[kFileHead];
+    if (std::fread(head, 1, kFileHead, m_File) != kFileHead || std::memcmp(head, "DSRW", 4) != 0
+     || Get<uint32_t>(head + 4) != RAW_FILE_VERSION) {
+        if (err) *err = std::string(path) + " is not a raw capture file";
+        Close();
+        return false;
+    }
+    m_Header.Channels   = int(Get<uint32_t>(head + 8));
+    m_Header.ScanPeriod = Get<double>(head + 12);
+    m_Header.RangeMax   = Get<float>(head + 20);
+    m_Header.RangeMin   = Get<float>(head + 24);
+    m_Header.Resolution = int(Get<uint32_t>(head + 28));
+    if (m_Header.Channels <= 0) {
+        if (err) *err = std::string(path) + ": no channels";
+        Close();
+        return false;
+    }
+
+    // Index the blocks; a block cut short by a crash ends the file
+    long long size = 0;
+    if (FileSeek(m_File, 0, SEEK_END) == 0) size = FileTell(m_File);
+    long long offset = kFileHead;
+    uint8_t b[kBlockHead];
+    while (FileSeek(m_File, offset, SEEK_SET) == 0
+        && std::fread(b, 1, kBlockHead, m_File) == kBlockHead && std::memcmp(b, "SCNS", 4) == 0) {
+        BlockIndex x;
+        x.Offset = offset + kBlockHead;
+        x.Bytes  = Get<uint32_t>(b + 4);
+        x.First  = m_Total;
+        x.Scans  = Get<uint32_t>(b + 24);
+        if (x.Offset + x.Bytes > size) break;
+        m_Index.push_back(x);
+        m_Total += x.Scans;
+        offset = x.Offset + x.Bytes;
+    }
+    return true;
+}
+
+void RawCaptureReader::Close()
+{
+    if (m_File != nullptr) std::fclose(m_File);
+    m_File = nullptr;
+    m_Index.clear();
+    m_Total  = 0;
+    m_Loaded = kNone;
+}
+
+bool RawCaptureReader::Load(size_t block)
+{
+    const BlockIndex& x = m_Index[block];
+    m_Payload.resize(x.Bytes);
+    if (FileSeek(m_File, x.Offset, SEEK_SET) != 0
+     || std::fread(m_Payload.data(), 1, x.Bytes, m_File) != x.Bytes) return false;
+
+    const size_t nch = size_t(m_Header.Channels);
+    m_Codes.resize(size_t(x.Scans) * nch);
+    const uint8_t* p   = m_Payload.data();
+    const uint8_t* end = p + m_Payload.size();
+    for (size_t i = 0; i < m_Codes.size(); i++) {
+        uint32_t u = 0;
+        int shift = 0;
+        for (;;) {
+            if (p == end || shift > 28) return false;
+            const uint8_t c = *p++;
+            u |= uint32_t(c & 0x7f) << shift;
+            if ((c & 0x80) == 0) break;
+            shift += 7;
+        }
+        const int32_t prev = (i >= nch) ? m_Codes[i - nch] : 0;
+        m_Codes[i] = prev + UnZigZag(u);
+    }
+    m_Loaded = block;
+    return true;
+}
+
+bool RawCaptureReader::Read(uint64_t n, int32_t* codes)
+{
+    if (m_File == nullptr || n >= m_Total) return false;
+    if (m_Loaded == kNone || n < m_Index[m_Loaded].First
+     || n >= m_Index[m_Loaded].First + m_Index[m_Loaded].Scans) {
+        const auto it = std::upper_bound(m_Index.begin(), m_Index.end(), n,
+            [](uint64_t s, const BlockIndex& x) { return s < x.First; });
+        if (!Load(size_t(it - m_Index.begin()) - 1)) {
+            m_Loaded = kNone;
+            return false;
+        }
+    }
+    const size_t nch = size_t(m_Header.Channels);
+    const int32_t* src = &m_Codes[size_t(n - m_Index[m_Loaded].First) * nch];
+    std::copy(src, src + nch, codes);
+    return true;
+}
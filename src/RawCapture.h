@@ -0,0 +1,176 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __RAWCAPTURE_H_INCLUDE__
+#define __RAWCAPTURE_H_INCLUDE__
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define RAW_BLOCK_BYTES     (256 * 1024)    // a block is handed to the writer at this size
+#define RAW_BLOCK_SECONDS   30.0            // ... or after this much scan time
+#define RAW_QUEUE_BLOCKS    16              // blocks waiting for the disk before drops
+#define RAW_FILE_VERSION    1
+
+/**
+ * Continuous raw AD capture (*.dsraw): every scan of every AD board, as
+ * the codes GetAiSamplingData() put in Data0, before any filtering. The
+ * secondary boards follow the first at ch 16b, paired with its scans as
+ * the pipeline pairs them (a board without a partner scan repeats its
+ * last codes); the header range is the first board's.
+ *
+ * The pipeline Push()es each scan; the codes are stored as the change
+ * from the previous scan (zigzag + LEB128 varint), so a quiet 16-bit
+ * channel costs about one byte per sample: 300 sps × 16 ch is roughly
+ * 0.3 MB/min. Scans are collected in blocks of up to RAW_BLOCK_BYTES or
+ * RAW_BLOCK_SECONDS; a full block goes to a writer thread, which owns
+ * the file, so the disk never stalls the pipeline. If the disk falls
+ * RAW_QUEUE_BLOCKS behind, the block is dropped and counted.
+ *
+ * File layout (little endian):
+ *   "DSRW" u32 version, u32 channels, f64 scan period [s],
+ *   f32 range max [V], f32 range min [V], u32 resolution [bits]
+ *   blocks: "SCNS" u32 payload bytes, u64 first scan index,
+ *           f64 first scan time [s], u32 scans, payload
+ * The first scan of a block is coded against zero, so each block decodes
+ * on its own. A block ends where the scans stop following each other at
+ * the scan period (board restart, dropped block); the index and time of
+ * the next block show the gap.
+ * Replay with DIGITSHOW_AIO=replay:<file> to re-run filters offline.
+ */
+
+struct RawCaptureHeader {
+    int    Channels;
+    double ScanPeriod;                  // s/scan
+    float  RangeMax, RangeMin;          // code 0 .. 2^Resolution - 1 spans this range
+    int    Resolution;
+};
+
+class RawCaptureWriter
+{
+public:
+    RawCaptureWriter();
+    ~RawCaptureWriter();
+
+    // Creates the file, writes the header and starts the writer thread
+    bool Open(const char* path, const RawCaptureHeader& header, std::string* err);
+
+    // Pipeline side: encodes one scan of header.Channels codes. scan is the
+    // running scan index, t its board time. Never blocks on the disk.
+    void Push(uint64_t scan, double t, const long* codes);
+
+    // Hands over the open block and closes the file on the writer thread.
+    // Returns at once.
+    void Close();
+    // Waits for the writer thread to finish
+    void Wait();
+
+    bool     Active() const  { return m_Active; }
+    const std::string& Path() const { return m_Path; }
+    uint64_t Scans() const   { return m_Scans; }                                        // pipeline side
+    uint64_t Bytes() const   { return m_Bytes.load(std::memory_order_relaxed); }        // on disk
+    uint64_t Dropped() const { return m_Dropped.load(std::memory_order_relaxed); }      // scans
+
+private:
+    RawCaptureWriter(const RawCaptureWriter&) = delete;
+    RawCaptureWriter& operator=(const RawCaptureWriter&) = delete;
+
+    void Submit();
+    void Loop();
+
+    FILE*       m_File;
+    std::string m_Path;
+    int         m_Channels;
+    bool        m_Active;               // between Open() and Close() (pipeline side)
+
+    // Block being encoded (pipeline side)
+    std::vector<uint8_t> m_Block;
+    std::vector<int32_t> m_Prev;        // codes of the previous scan
+    uint64_t    m_First;                // first scan index of the block
+    double      m_Time0, m_Period;      // its time, s/scan
+    uint32_t    m_BlockScans, m_MaxScans;
+    uint64_t    m_Scans;
+
+    std::deque<std::vector<uint8_t>> m_Full;    // blocks for the writer
+    std::vector<std::vector<uint8_t>> m_Free;   // written blocks, reused
+    bool        m_Stop;
+    std::thread             m_Thread;
+    std::mutex              m_Mutex;
+    std::condition_variable m_Wake;
+
+    std::atomic<uint64_t> m_Bytes;
+    std::atomic<uint64_t> m_Dropped;
+};
+
+/**
+ * Random access to a *.dsraw file: an index of its blocks is built on
+ * Open(), and Read() decodes the block holding the requested scan.
+ * Scans are numbered 0 .. TotalScans() - 1 across all blocks, so gaps
+ * are closed up.
+ */
+class RawCaptureReader
+{
+public:
+    RawCaptureReader();
+    ~RawCaptureReader();
+
+    // True if the file starts with the *.dsraw magic
+    static bool IsCapture(FILE* fp);
+
+    bool Open(const char* path, std::string* err);
+    void Close();
+
+    const RawCaptureHeader& Header() const { return m_Header; }
+    uint64_t TotalScans() const { return m_Total; }
+
+    // Copies the Header().Channels codes of scan n
+    bool Read(uint64_t n, int32_t* codes);
+
+private:
+    RawCaptureReader(const RawCaptureReader&) = delete;
+    RawCaptureReader& operator=(const RawCaptureReader&) = delete;
+
+    struct BlockIndex {
+        long long Offset;               // file offset of the payload
+        uint32_t  Bytes;
+        uint64_t  First;                // first scan, in the numbering of Read()
+        uint32_t  Scans;
+    };
+
+    bool Load(size_t block);
+
+    FILE*             m_File;
+    RawCaptureHeader  m_Header;
+    std::vector<BlockIndex> m_Index;
+    uint64_t          m_Total;
+    size_t            m_Loaded;         // block decoded in m_Codes, or npos
+    std::vector<uint8_t> m_Payload;
+    std::vector<int32_t> m_Codes;       // [scan][channel] of the loaded block
+};
+
+#endif // __RAWCAPTURE_H_INCLUDE__
@@ -0,0 +1,98 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "RigRunner.h"
+
+namespace {
+
+const unsigned int kPausedPollMs = 100;   // re-check interval of a paused task
+
+} // namespace
+
+RigRunner::RigRunner()
+    : m_Stop(false)
+{
+}
+
+RigRunner::~RigRunner()
+{
+    Stop();
+}
+
+void RigRunner::Add(IntervalFn interval, TaskFn task)
+{
+    Task t;
+    t.Interval = interval;
+    t.Run      = task;
+    t.Next     = Clock::now();
+    m_Tasks.push_back(t);
+}
+
+void RigRunner::Start(TaskFn threadInit)
+{
+    Stop();
+    m_Stop = false;
+    const Clock::time_point now = Clock::now();
+    for (Task& t : m_Tasks) t.Next = now;
+    m_Thread = std::thread(&RigRunner::Loop, this, threadInit);
+}
+
+void RigRunner::Stop()
+{
+    if (!m_Thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+    m_Thread.join();
+}
+
+void RigRunner::Loop(TaskFn threadInit)
+{
+    if (threadInit) threadInit();
+    std::unique_lock<std::mutex> wake(m_WakeMutex);
+    while (!m_Stop) {
+        Clock::time_point next = Clock::time_point::max();
+        for (const Task& t : m_Tasks) if (t.Next < next) next = t.Next;
+        if (next > Clock::now()) m_Wake.wait_until(wake, next);
+        if (m_Stop) break;
+        wake.unlock();
+
+        const Clock::time_point now = Clock::now();
+        for (Task& t : m_Tasks) {
+            if (t.Next > now) continue;
+            // The interval is read under the lock so that a task switched
+            // off from the UI (e.g. logging stopped, files closed) never runs
+            unsigned int ms;
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                ms = t.Interval();
+                if (ms != 0) t.Run();
+            }
+            if (ms == 0) {
+                t.Next = now + std::chrono::milliseconds(kPausedPollMs);
+                continue;
+            }
+            // Fixed rate like WM_TIMER, without catching up on missed ticks
+            t.Next += std::chrono::milliseconds(ms);
+            if (t.Next < now) t.Next = now + std::chrono::milliseconds(ms);
+        }
+        wake.lock();
+    }
+}
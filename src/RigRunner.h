@@ -0,0 +1,80 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RIGRUNNER_H_INCLUDE__
+#define __RIGRUNNER_H_INCLUDE__
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Pipeline thread of a rig that is not driven by the UI timers.
+ *
+ * Runs a fixed set of periodic tasks (acquire/display and logging: the
+ * work of WM_TIMER 1/3 for rig 0; control has its own ControlLoop). Intervals are read back before
+ * every run, so changes made from the UI take effect at the next tick.
+ * Intervals are read and tasks run with Mutex() held; the UI takes the
+ * same mutex while it starts/stops control or logging on this rig.
+ */
+class RigRunner
+{
+public:
+    typedef std::function<unsigned int()> IntervalFn;   // ms, 0 = paused
+    typedef std::function<void()>         TaskFn;
+
+    RigRunner();
+    ~RigRunner();
+
+    // Before Start()
+    void Add(IntervalFn interval, TaskFn task);
+
+    // threadInit runs first on the new thread (binds the rig context)
+    void Start(TaskFn threadInit);
+    void Stop();
+
+    bool        Running() const { return m_Thread.joinable(); }
+    std::mutex& Mutex()         { return m_Lock; }
+
+private:
+    RigRunner(const RigRunner&) = delete;
+    RigRunner& operator=(const RigRunner&) = delete;
+
+    typedef std::chrono::steady_clock Clock;
+    struct Task {
+        IntervalFn        Interval;
+        TaskFn            Run;
+        Clock::time_point Next;
+    };
+
+    void Loop(TaskFn threadInit);
+
+    std::vector<Task>       m_Tasks;
+    std::thread             m_Thread;
+    std::mutex              m_Lock;       // held while a task runs
+    std::mutex              m_WakeMutex;
+    std::condition_variable m_Wake;
+    bool                    m_Stop;
+};
+
+#endif // __RIGRUNNER_H_INCLUDE__
@@ -0,0 +1,151 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SampleClock.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+const size_t kMaxSegments = 64;
+const double kMinFitSpan  = 10.0;   // s of observations before a drift is reported
+
+long long NowTicks()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+SampleClock::SampleClock()
+    : m_Period(0.0), m_StartTicks(NowTicks())
+    , m_n(0.0), m_Sx(0.0), m_Sy(0.0), m_Sxx(0.0), m_Sxy(0.0)
+    , m_FirstHost(0.0), m_LastHost(0.0)
+{
+    m_Segments.push_back(Segment{0, 0.0});
+}
+
+void SampleClock::Start(double scanPeriodSec)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Period     = scanPeriodSec;
+    m_StartTicks = NowTicks();
+    m_Segments.assign(1, Segment{0, 0.0});
+    m_n = m_Sx = m_Sy = m_Sxx = m_Sxy = 0.0;
+    m_FirstHost = m_LastHost = 0.0;
+}
+
+void SampleClock::StartFrom(const SampleClock& master, double scanPeriodSec)
+{
+    long long ticks;
+    {
+        std::lock_guard<std::mutex> lock(master.m_Mutex);
+        ticks = master.m_StartTicks;
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Period     = scanPeriodSec;
+    m_StartTicks = ticks;
+    m_Segments.assign(1, Segment{0, double(NowTicks() - ticks) * 1e-9});
+    m_n = m_Sx = m_Sy = m_Sxx = m_Sxy = 0.0;
+    m_FirstHost = m_LastHost = 0.0;
+}
+
+double SampleClock::HostNow() const
+{
+    return double(NowTicks() - m_StartTicks) * 1e-9;
+}
+
+void SampleClock::Restart(uint64_t nextScan)
+{
+    const double now = HostNow();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // Never step back behind scans already stamped
+    const double t = std::max(now, SegmentTime(nextScan));
+    if (m_Segments.size() >= kMaxSegments) m_Segments.erase(m_Segments.begin());
+    m_Segments.push_back(Segment{nextScan, t});
+    // The fit relates board to host time within one run only
+    m_n = m_Sx = m_Sy = m_Sxx = m_Sxy = 0.0;
+}
+
+void SampleClock::Skip(uint64_t nextScan, uint64_t lost)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const double t = SegmentTime(nextScan) + double(lost) * m_Period;
+    if (m_Segments.size() >= kMaxSegments) m_Segments.erase(m_Segments.begin());
+    m_Segments.push_back(Segment{nextScan, t});
+}
+
+void SampleClock::Observe(uint64_t delivered)
+{
+    const double host = HostNow();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (delivered == 0) return;
+    // Board time at which the newest delivered scan completed
+    const double board = SegmentTime(delivered - 1) + m_Period;
+    if (m_n == 0.0) m_FirstHost = host;
+    m_LastHost = host;
+    m_n   += 1.0;
+    m_Sx  += board;
+    m_Sy  += host;
+    m_Sxx += board * board;
+    m_Sxy += board * host;
+}
+
+double SampleClock::SegmentTime(uint64_t scan) const
+{
+    for (size_t i = m_Segments.size(); i-- > 0; ) {
+        const Segment& s = m_Segments[i];
+        if (scan >= s.Scan0 || i == 0)
+            return s.Time0 + (double(scan) - double(s.Scan0)) * m_Period;
+    }
+    return double(scan) * m_Period;
+}
+
+double SampleClock::ScanTime(uint64_t scan) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return SegmentTime(scan);
+}
+
+double SampleClock::DriftPpm() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_LastHost - m_FirstHost < kMinFitSpan || m_n < 3.0) return 0.0;
+    const double den = m_n * m_Sxx - m_Sx * m_Sx;
+    if (den <= 0.0) return 0.0;
+    const double slope = (m_n * m_Sxy - m_Sx * m_Sy) / den;
+    return (slope - 1.0) * 1e6;
+}
+
+double SampleClock::HostTime(uint64_t scan) const
+{
+    const double drift = DriftPpm() * 1e-6;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Segment& cur = m_Segments.back();
+    const double t = SegmentTime(scan);
+    // Stretch board time by the drift, measured from the current segment start
+    return cur.Time0 + (t - cur.Time0) * (1.0 + drift);
+}
+
+double SampleClock::ObservedSpan() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_LastHost - m_FirstHost;
+}
@@ -0,0 +1,89 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SAMPLECLOCK_H_INCLUDE__
+#define __SAMPLECLOCK_H_INCLUDE__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Scan timestamps derived from the board's sample clock.
+ *
+ * Scan n (index in ai.ring order) is stamped
+ *     t(n) = T0 + (n - N0) × ScanPeriod          [s since Start()]
+ * where the segment (N0, T0) starts at Start() and is re-anchored when
+ * the scan sequence breaks: scans dropped by the ring (Skip) or an AI
+ * restart (Restart, anchored to the host monotonic clock). Times are
+ * therefore exact multiples of the scan period, free of WM_TIMER jitter.
+ *
+ * Each AD event reports (scans delivered, host time) through Observe();
+ * a least-squares fit of host time against board time gives the drift of
+ * the board oscillator relative to the host clock (DriftPpm) and lets
+ * HostTime() map a scan onto the host monotonic clock.
+ */
+class SampleClock
+{
+public:
+    SampleClock();
+
+    // At AioStartAi: scan index 0 is acquired "now" on the host clock
+    void Start(double scanPeriodSec);
+
+    // Secondary board started now: same host time origin as `master`
+    void StartFrom(const SampleClock& master, double scanPeriodSec);
+
+    // AI restarted (overflow recovery): scan `nextScan` is acquired now
+    void Restart(uint64_t nextScan);
+
+    // `lost` scans were discarded before scan `nextScan`
+    void Skip(uint64_t nextScan, uint64_t lost);
+
+    // Producer: `delivered` scans are now available (called per AD event)
+    void Observe(uint64_t delivered);
+
+    double   ScanPeriod() const { return m_Period; }
+    double   ScanTime(uint64_t scan) const;     // board clock [s]
+    double   HostTime(uint64_t scan) const;     // host monotonic clock, drift-corrected [s since Start]
+    double   HostNow() const;                   // host monotonic clock [s since Start]
+    double   DriftPpm() const;                  // (host/board - 1) × 1e6, 0 until enough data
+    double   ObservedSpan() const;              // host seconds covered by the drift fit
+
+private:
+    struct Segment {
+        uint64_t Scan0;
+        double   Time0;
+    };
+
+    double   SegmentTime(uint64_t scan) const;  // caller holds m_Mutex
+
+    mutable std::mutex   m_Mutex;
+    double               m_Period;
+    long long            m_StartTicks;          // steady_clock at Start()
+    std::vector<Segment> m_Segments;            // newest last, at most kMaxSegments
+
+    // Least-squares fit host = a + b × board over all observations
+    double   m_n, m_Sx, m_Sy, m_Sxx, m_Sxy;
+    double   m_FirstHost, m_LastHost;
+};
+
+#endif // __SAMPLECLOCK_H_INCLUDE__
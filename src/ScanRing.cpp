@@ -0,0 +1,85 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ScanRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+ScanRing::ScanRing()
+    : m_Capacity(0), m_Channels(0), m_Head(0), m_Tail(0), m_Dropped(0)
+{
+}
+
+void ScanRing::Allocate(size_t capacityScans, int channels)
+{
+    m_Capacity = capacityScans;
+    m_Channels = channels;
+    m_Buf.assign(capacityScans * static_cast<size_t>(channels), 0L);
+    Reset();
+}
+
+void ScanRing::Reset()
+{
+    m_Head.store(0, std::memory_order_relaxed);
+    m_Tail.store(0, std::memory_order_relaxed);
+    m_Dropped.store(0, std::memory_order_relaxed);
+}
+
+size_t ScanRing::Pending() const
+{
+    return static_cast<size_t>(m_Head.load(std::memory_order_acquire)
+                             - m_Tail.load(std::memory_order_acquire));
+}
+
+const long* ScanRing::Peek(size_t i) const
+{
+    const uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+    return &m_Buf[static_cast<size_t>((tail + i) % m_Capacity) * m_Channels];
+}
+
+void ScanRing::Release(size_t n)
+{
+    const uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+    m_Tail.store(tail + n, std::memory_order_release);
+}
+
+size_t ScanRing::Push(const long* scans, size_t nScans)
+{
+    if (m_Capacity == 0 || nScans == 0) return 0;
+
+    const uint64_t head = m_Head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_Tail.load(std::memory_order_acquire);
+    const size_t   room = m_Capacity - static_cast<size_t>(head - tail);
+    const size_t   n    = std::min(nScans, room);
+
+    // Copy in at most two segments (wrap-around)
+    const size_t slot  = static_cast<size_t>(head % m_Capacity);
+    const size_t first = std::min(n, m_Capacity - slot);
+    const size_t width = static_cast<size_t>(m_Channels);
+    memcpy(&m_Buf[slot * width], scans, first * width * sizeof(long));
+    if (n > first) {
+        memcpy(&m_Buf[0], scans + first * width, (n - first) * width * sizeof(long));
+    }
+    m_Head.store(head + n, std::memory_order_release);
+
+    if (n < nScans) {
+        m_Dropped.fetch_add(nScans - n, std::memory_order_relaxed);
+    }
+    return n;
+}
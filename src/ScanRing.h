@@ -0,0 +1,101 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SCANRING_H_INCLUDE__
+#define __SCANRING_H_INCLUDE__
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Single-producer / single-consumer lock-free ring of raw AD scans.
+ *
+ * Producer : AIOM_AIE_DATA_NUM handler (appends every event burst)
+ * Consumer : AD_INPUT() (drains every pending scan into the MA5×MA6 filter)
+ *
+ * One slot holds one scan = Channels raw codes, laid out exactly like Data0.
+ * Head/Tail are free-running scan counters, so Head == scans written and
+ * Tail == scans consumed.  When the ring is full the newest scans are
+ * discarded and counted in Dropped(); the consumer never sees torn data.
+ */
+class ScanRing
+{
+public:
+    ScanRing();
+
+    // Not thread-safe: call only while acquisition is stopped.
+    void Allocate(size_t capacityScans, int channels);
+    void Reset();
+
+    // Producer side. Returns the number of scans actually stored.
+    size_t Push(const long* scans, size_t nScans);
+
+    // Consumer side. Calls fn(const long* scan) for every pending scan in
+    // arrival order, then releases the slots. Returns the number drained.
+    template <class Fn>
+    size_t Drain(Fn&& fn);
+
+    // Consumer side, one scan at a time: Peek(i) is the i-th pending scan
+    // (i < Pending()); Release(n) frees the n oldest.
+    const long* Peek(size_t i) const;
+    void        Release(size_t n);
+
+    size_t   Capacity() const { return m_Capacity; }
+    int      Channels() const { return m_Channels; }
+    size_t   Pending()  const;
+
+    uint64_t Produced() const { return Written() + Dropped(); }   // scans delivered by the board
+    uint64_t Written()  const { return m_Head.load(std::memory_order_acquire); }
+    uint64_t Consumed() const { return m_Tail.load(std::memory_order_acquire); }
+    uint64_t Dropped()  const { return m_Dropped.load(std::memory_order_relaxed); }
+
+private:
+    ScanRing(const ScanRing&) = delete;
+    ScanRing& operator=(const ScanRing&) = delete;
+
+    std::vector<long>     m_Buf;       // [Capacity * Channels]
+    size_t                m_Capacity;  // scans
+    int                   m_Channels;
+    std::atomic<uint64_t> m_Head;      // written by producer only
+    std::atomic<uint64_t> m_Tail;      // written by consumer only
+    std::atomic<uint64_t> m_Dropped;   // scans lost because the ring was full
+};
+
+template <class Fn>
+size_t ScanRing::Drain(Fn&& fn)
+{
+    if (m_Capacity == 0) return 0;
+
+    const uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+    const uint64_t head = m_Head.load(std::memory_order_acquire);
+    const size_t   n    = static_cast<size_t>(head - tail);
+
+    size_t slot = static_cast<size_t>(tail % m_Capacity);
+    for (size_t i = 0; i < n; i++) {
+        fn(&m_Buf[slot * m_Channels]);
+        if (++slot == m_Capacity) slot = 0;
+    }
+    m_Tail.store(head, std::memory_order_release);
+    return n;
+}
+
+#endif // __SCANRING_H_INCLUDE__
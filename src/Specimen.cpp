@@ -179,6 +179,8 @@ void CSpecimen::OnBUTTONUpdate()
     m_Volume2 = m_Area2*m_Height2;
     m_Volume3 = m_Area3*m_Height3;
 
+    // Cal_Param() on the control thread reads the specimen under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     SpecimenData->Area[0]   = m_Area0;
     SpecimenData->Area[1]   = m_Area1;
     SpecimenData->Area[2]   = m_Area2;
@@ -275,18 +277,21 @@ void CSpecimen::OnBUTTONBeConsol()
     DigitShowContext* ctx = GetContext();
     auto SpecimenData = &ctx->specimen;
 
-    SpecimenData->Height[2] = SpecimenData->Height[1]-ctx->ai.phy[1];    
-    SpecimenData->Volume[2] = SpecimenData->Volume[1]-SpecimenData->Area[1]*ctx->ai.phy[1];
-    SpecimenData->Area[2]   = SpecimenData->Area[1];
-    SpecimenData->Diameter[2] = SpecimenData->Diameter[1]*sqrt(SpecimenData->Area[2]/SpecimenData->Area[1]) ;
-    SpecimenData->Depth[2]  = SpecimenData->Depth[1]*sqrt(SpecimenData->Area[2]/SpecimenData->Area[1]);
-    SpecimenData->Width[2]  = SpecimenData->Width[1]*sqrt(SpecimenData->Area[2]/SpecimenData->Area[1]);
-    SpecimenData->VLDT1[2] = ctx->ai.phy[2];
-    SpecimenData->VLDT2[2] = ctx->ai.phy[3];
-    ctx->ai.cal.c[1] = ctx->ai.cal.c[1]- ctx->ai.phy[1];
-    //---0-adjustment of Displacement transducer---
-    ctx->ai.cal.c[9] = ctx->ai.cal.c[9]- ctx->ai.phy[9];
-    //---0-adjustment of Volume Change ---
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        SpecimenData->Height[2] = SpecimenData->Height[1]-ctx->ai.phy[1];    
+        SpecimenData->Volume[2] = SpecimenData->Volume[1]-SpecimenData->Area[1]*ctx->ai.phy[1];
+        SpecimenData->Area[2]   = SpecimenData->Area[1];
+        SpecimenData->Diameter[2] = SpecimenData->Diameter[1]*sqrt(SpecimenData->Area[2]/SpecimenData->Area[1]) ;
+        SpecimenData->Depth[2]  = SpecimenData->Depth[1]*sqrt(SpecimenData->Area[2]/SpecimenData->Area[1]);
+        SpecimenData->Width[2]  = SpecimenData->Width[1]*sqrt(SpecimenData->Area[2]/SpecimenData->Area[1]);
+        SpecimenData->VLDT1[2] = ctx->ai.phy[2];
+        SpecimenData->VLDT2[2] = ctx->ai.phy[3];
+        ctx->ai.cal.c[1] = ctx->ai.cal.c[1]- ctx->ai.phy[1];
+        //---0-adjustment of Displacement transducer---
+        ctx->ai.cal.c[9] = ctx->ai.cal.c[9]- ctx->ai.phy[9];
+        //---0-adjustment of Volume Change ---
+    }
     Reflesh();
     OnBUTTONToPresent2();
 }
@@ -296,18 +301,21 @@ void CSpecimen::OnBUTTONAfConsolidation()
     DigitShowContext* ctx = GetContext();
     auto SpecimenData = &ctx->specimen;
 
-    SpecimenData->Height[3] = SpecimenData->Height[2]-ctx->ai.phy[1];    
-    SpecimenData->Volume[3] = SpecimenData->Volume[2]-ctx->ai.phy[9];
-    SpecimenData->Area[3]   = SpecimenData->Volume[3]/SpecimenData->Height[3];
-    SpecimenData->Diameter[3] = SpecimenData->Diameter[2]*sqrt(SpecimenData->Area[3]/SpecimenData->Area[2]);
-    SpecimenData->Depth[3] = SpecimenData->Depth[2]*sqrt(SpecimenData->Area[3]/SpecimenData->Area[2]);
-    SpecimenData->Width[3] = SpecimenData->Width[2]*sqrt(SpecimenData->Area[3]/SpecimenData->Area[2]);    
-    SpecimenData->VLDT1[3] = ctx->ai.phy[2];
-    SpecimenData->VLDT2[3] = ctx->ai.phy[3];
-    ctx->ai.cal.c[1] = ctx->ai.cal.c[1]- ctx->ai.phy[1];
-    //---0-adjustment of Displacement transducer---
-    ctx->ai.cal.c[9] = ctx->ai.cal.c[9]- ctx->ai.phy[9];
-    //---0-adjustment of Volume Change ---
+    {
+        std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
+        SpecimenData->Height[3] = SpecimenData->Height[2]-ctx->ai.phy[1];    
+        SpecimenData->Volume[3] = SpecimenData->Volume[2]-ctx->ai.phy[9];
+        SpecimenData->Area[3]   = SpecimenData->Volume[3]/SpecimenData->Height[3];
+        SpecimenData->Diameter[3] = SpecimenData->Diameter[2]*sqrt(SpecimenData->Area[3]/SpecimenData->Area[2]);
+        SpecimenData->Depth[3] = SpecimenData->Depth[2]*sqrt(SpecimenData->Area[3]/SpecimenData->Area[2]);
+        SpecimenData->Width[3] = SpecimenData->Width[2]*sqrt(SpecimenData->Area[3]/SpecimenData->Area[2]);    
+        SpecimenData->VLDT1[3] = ctx->ai.phy[2];
+        SpecimenData->VLDT2[3] = ctx->ai.phy[3];
+        ctx->ai.cal.c[1] = ctx->ai.cal.c[1]- ctx->ai.phy[1];
+        //---0-adjustment of Displacement transducer---
+        ctx->ai.cal.c[9] = ctx->ai.cal.c[9]- ctx->ai.phy[9];
+        //---0-adjustment of Volume Change ---
+    }
     Reflesh();
     OnBUTTONToPresent3();
 }
@@ -325,6 +333,7 @@ void CSpecimen::OnBUTTONToPresent1()
     }    
     else    m_Area1 = m_Depth1*m_Width1;
     m_Volume1 = m_Area1*m_Height1;
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     SpecimenData->Diameter[1] = m_Diameter1;
     SpecimenData->Width[1] = m_Width1;
     SpecimenData->Depth[1] = m_Depth1;
@@ -358,6 +367,7 @@ void CSpecimen::OnBUTTONToPresent2()
     }    
     else    m_Area2 = m_Depth2*m_Width2;
     m_Volume2 = m_Area2*m_Height2;
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     SpecimenData->Diameter[2] = m_Diameter2;
     SpecimenData->Width[2] = m_Width2;
     SpecimenData->Depth[2] = m_Depth2;
@@ -391,6 +401,7 @@ void CSpecimen::OnBUTTONToPresent3()
     }    
     else    m_Area3 = m_Depth3*m_Width3;
     m_Volume3 = m_Area3*m_Height3;
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     SpecimenData->Diameter[3] = m_Diameter3;
     SpecimenData->Width[3] = m_Width3;
     SpecimenData->Depth[3] = m_Depth3;
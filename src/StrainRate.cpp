@@ -0,0 +1,88 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "StrainRate.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool RobustSlope(const double* t, const double* y, size_t n, int bins, double* slope)
+{
+    if (bins > STRAIN_RATE_BINS) bins = STRAIN_RATE_BINS;
+    const size_t m = (n < size_t(bins)) ? n : size_t(bins);
+    if (m < 3) return false;
+
+    double bt[STRAIN_RATE_BINS], by[STRAIN_RATE_BINS];
+    for (size_t b = 0; b < m; b++) {
+        const size_t i0 = n * b / m, i1 = n * (b + 1) / m;
+        double st = 0.0, sy = 0.0;
+        for (size_t i = i0; i < i1; i++) {
+            st += t[i];
+            sy += y[i];
+        }
+        bt[b] = st / double(i1 - i0);
+        by[b] = sy / double(i1 - i0);
+    }
+
+    double s[STRAIN_RATE_BINS * (STRAIN_RATE_BINS - 1) / 2];
+    size_t k = 0;
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = i + 1; j < m; j++) {
+            if (bt[j] > bt[i]) s[k++] = (by[j] - by[i]) / (bt[j] - bt[i]);
+        }
+    }
+    if (k == 0) return false;
+    const size_t mid = k / 2;
+    std::nth_element(s, s + mid, s + k);
+    double med = s[mid];
+    if (k % 2 == 0) med = 0.5 * (med + *std::max_element(s, s + mid));
+    *slope = med;
+    return true;
+}
+
+StrainRateControl::StrainRateControl()
+    : m_Rpm(0.0), m_RpmMax(0.0), m_Window(STRAIN_RATE_WINDOW), m_Age(0.0), m_Measured(0.0)
+{
+}
+
+void StrainRateControl::Start(double rpm, double rpmMax, double window)
+{
+    m_RpmMax   = rpmMax;
+    m_Rpm      = (rpm < rpmMax) ? rpm : rpmMax;
+    m_Window   = (window > 0.0) ? window : STRAIN_RATE_WINDOW;
+    m_Age      = 0.0;
+    m_Measured = 0.0;
+}
+
+double StrainRateControl::Update(double target, double measured, bool valid, double dt)
+{
+    m_Age += dt;
+    if (!valid) return m_Rpm;
+    m_Measured = measured;
+    if (m_Age < m_Window || target <= 0.0 || m_Rpm <= 0.0) return m_Rpm;
+
+    // Not moving yet (slack, seating): speed up at the largest step
+    double ratio = (measured > 0.0) ? target / measured : STRAIN_RATE_MAX_GAIN;
+    if (ratio > STRAIN_RATE_MAX_GAIN)       ratio = STRAIN_RATE_MAX_GAIN;
+    if (ratio < 1.0 / STRAIN_RATE_MAX_GAIN) ratio = 1.0 / STRAIN_RATE_MAX_GAIN;
+    m_Rpm *= std::pow(ratio, dt / m_Window);
+    if (m_Rpm > m_RpmMax)         m_Rpm = m_RpmMax;
+    if (m_Rpm < m_RpmMax * 1e-4)  m_Rpm = m_RpmMax * 1e-4;
+    return m_Rpm;
+}
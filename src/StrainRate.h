@@ -0,0 +1,72 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __STRAINRATE_H_INCLUDE__
+#define __STRAINRATE_H_INCLUDE__
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#define STRAIN_RATE_BINS     32     // block means the slope is fitted to
+#define STRAIN_RATE_WINDOW   30.0   // s, default regression window
+#define STRAIN_RATE_MAX_GAIN  2.0   // largest speed correction per window
+
+// Theil–Sen slope dy/dt: the n samples are reduced to at most `bins` block
+// means and the median of their pairwise slopes is returned, so spikes and
+// steps in a few blocks do not move it. False with fewer than 3 blocks.
+bool RobustSlope(const double* t, const double* y, size_t n, int bins, double* slope);
+
+/**
+ * Motor speed of a constant strain-rate step (control file "rate").
+ *
+ * The speed starts at the step's rpm and is then corrected continuously
+ * from the measured rate (RobustSlope over the last Window seconds of
+ * axial strain): each control step multiplies it by
+ *   (target / measured) ^ (dt / Window),  the ratio clamped to
+ *   1/STRAIN_RATE_MAX_GAIN .. STRAIN_RATE_MAX_GAIN,
+ * i.e. an integral law on log(rpm) with the window as time constant,
+ * twice the lag of the estimate. Frame compliance and slack only change
+ * the rpm the loop settles at. No correction before a full window has
+ * passed at the starting speed.
+ */
+class StrainRateControl
+{
+public:
+    StrainRateControl();
+
+    void Start(double rpm, double rpmMax, double window);
+
+    // One control step of dt [s]; measured [%/min] only if valid
+    double Update(double target, double measured, bool valid, double dt);
+
+    double Rpm() const      { return m_Rpm; }
+    double Window() const   { return m_Window; }
+    double Measured() const { return m_Measured; }
+
+    // Scratch for the window samples (control thread only)
+    std::vector<double> T, Ea;
+    std::vector<float>  V;
+
+private:
+    double m_Rpm, m_RpmMax, m_Window, m_Age, m_Measured;
+};
+
+#endif // __STRAINRATE_H_INCLUDE__
@@ -77,6 +77,8 @@ void CTransAdjustment::OnBUTTONUpdateDisp()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    // Cal_Physical() on the control thread reads ai.cal under the same lock
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->ai.cal.c[1] = ctx->ai.cal.c[1] + (m_InitialDisp - m_FinalDisp);
     CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_UpdateDisp);
     myBTN1->EnableWindow(FALSE);
@@ -104,6 +106,7 @@ void CTransAdjustment::OnBUTTONUpdateBullet()
 {
     UpdateData(TRUE);
     DigitShowContext* ctx = GetContext();
+    std::lock_guard<std::mutex> lock(ctx->runner.Mutex());
     ctx->ai.cal.c[4] = ctx->ai.cal.c[4] + (m_InitialBullet - m_FinalBullet);
     CButton* myBTN1 = (CButton*)GetDlgItem(IDC_BUTTON_UpdateBullet);
     myBTN1->EnableWindow(FALSE);
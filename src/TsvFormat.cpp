@@ -0,0 +1,73 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "TsvFormat.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+// Longest fixed-notation double before the decimals: sign, 309 digits, point
+const size_t kMaxFixed = 1 + 309 + 1;
+const size_t kMaxU64   = 20;
+
+} // namespace
+
+TsvLine::TsvLine()
+    : m_Buf(TSV_LINE_BYTES), m_Len(0)
+{
+}
+
+char* TsvLine::Reserve(size_t n)
+{
+    if (m_Len + n > m_Buf.size()) m_Buf.resize(2 * (m_Len + n));
+    return m_Buf.data() + m_Len;
+}
+
+void TsvLine::Fixed(double v, int decimals)
+{
+    const size_t n = kMaxFixed + size_t(decimals);
+    char* p = Reserve(n);
+    const std::to_chars_result r = std::to_chars(p, p + n, v, std::chars_format::fixed, decimals);
+    m_Len = size_t(r.ptr - m_Buf.data());
+}
+
+void TsvLine::Unsigned(uint64_t v)
+{
+    char* p = Reserve(kMaxU64);
+    const std::to_chars_result r = std::to_chars(p, p + kMaxU64, v);
+    m_Len = size_t(r.ptr - m_Buf.data());
+}
+
+void TsvLine::Text(const char* s)
+{
+    Text(s, std::strlen(s));
+}
+
+void TsvLine::Text(const char* s, size_t n)
+{
+    std::memcpy(Reserve(n), s, n);
+    m_Len += n;
+}
+
+bool TsvLine::Write(FILE* fp) const
+{
+    return fp != nullptr && std::fwrite(m_Buf.data(), 1, m_Len, fp) == m_Len;
+}
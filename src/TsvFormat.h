@@ -0,0 +1,77 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __TSVFORMAT_H_INCLUDE__
+#define __TSVFORMAT_H_INCLUDE__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#define TSV_LINE_BYTES      16384   // preallocated record buffer (grows only for huge values)
+#define TSV_TIME_DECIMALS   3       // "%.3lf"
+#define TSV_VALUE_DECIMALS  6       // "%lf"
+
+/**
+ * One TSV record built in a preallocated buffer and written with a
+ * single fwrite().
+ *
+ * Numbers are rendered with std::to_chars in fixed notation, which is
+ * correctly rounded like printf("%.*f") but skips the format-string
+ * parsing and locale handling, so the files are byte-for-byte those the
+ * fprintf() path wrote. A row of *.tsv is
+ *   line.Clear(); line.Field(t, TSV_TIME_DECIMALS);
+ *   for (...) line.Field(v); line.End(); line.Write(fp);
+ */
+class TsvLine
+{
+public:
+    TsvLine();
+
+    void Clear() { m_Len = 0; }
+
+    void Fixed(double v, int decimals = TSV_VALUE_DECIMALS);     // value only
+    void Field(double v, int decimals = TSV_VALUE_DECIMALS)      // value + TAB
+    {
+        Fixed(v, decimals);
+        Char('\t');
+    }
+    void Unsigned(uint64_t v);
+    void Text(const char* s);
+    void Text(const char* s, size_t n);
+    void Char(char c) { *Reserve(1) = c; m_Len++; }
+    void End()        { Char('\n'); }
+
+    const char* Data() const { return m_Buf.data(); }
+    size_t      Size() const { return m_Len; }
+
+    // The whole record in one call; false on a short write
+    bool Write(FILE* fp) const;
+
+private:
+    char* Reserve(size_t n);
+
+    std::vector<char> m_Buf;
+    size_t            m_Len;
+};
+
+#endif // __TSVFORMAT_H_INCLUDE__
@@ -465,6 +465,10 @@
 #define ID_Control_PreConsolidation     32796
 #define ID_TransAdjustment              32797
 #define ID_Control_LinearStressPath     32798
+#define ID_Rig_1                        32799
+#define ID_Rig_2                        32800
+#define ID_Rig_3                        32801
+#define ID_Rig_4                        32802
 
 // Next default values for new objects
 // 
@@ -472,7 +476,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_3D_CONTROLS                     1
 #define _APS_NEXT_RESOURCE_VALUE        150
-#define _APS_NEXT_COMMAND_VALUE         32799
+#define _APS_NEXT_COMMAND_VALUE         32803
 #define _APS_NEXT_CONTROL_VALUE         1832
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
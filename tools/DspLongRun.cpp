@@ -0,0 +1,118 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Long-run check of the exact-mode MA1×MA2 filter (DspFilter.h).
+ *
+ * Feeds pseudo-random 16-bit code streams (random walks with occasional
+ * full-range jumps) through DspFilter in DSP_MODE_EXACT and compares
+ * every output value with a reference recomputed from scratch for that
+ * scan: fresh stage-1 sums over the last MA1 codes, fresh stage-2 sum
+ * over the last MA2 stage-1 sums. Running sums that drifted by even one
+ * code would show up as a mismatch.
+ *
+ *   DspLongRun [samples=1e9] [scalar|sse2|avx2]
+ *
+ * Prints the number of outputs that differed and exits with 1 if any.
+ */
+
+#include "DspFilter.h"
+#include "ToolCommon.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using tools::Next;
+
+int main(int argc, char** argv)
+{
+    const double samples = (argc > 1) ? std::atof(argv[1]) : 1e9;
+    if (argc > 2) {
+        const DspKernel k = (std::strcmp(argv[2], "avx2") == 0) ? DSP_KERNEL_AVX2
+                          : (std::strcmp(argv[2], "sse2") == 0) ? DSP_KERNEL_SSE2 : DSP_KERNEL_SCALAR;
+        if (!DspFilter::UseKernel(k)) {
+            std::printf("kernel %s not supported on this CPU\n", argv[2]);
+            return 2;
+        }
+    }
+    const uint64_t scans = uint64_t(samples / DSP_AD_CHANNELS);
+
+    DspFilter d;
+    std::memset(&d, 0, sizeof(d));
+    d.SetMode(DSP_MODE_EXACT);
+    d.SetTaps(DSP_MA1_TAPS, DSP_MA2_TAPS);
+    d.SetRange(10.0f, -10.0f, 16);
+    const int t1 = d.ma1_taps, t2 = d.ma2_taps;
+
+    // Reference history: last t1 codes and last t2 stage-1 sums per channel
+    std::vector<int> codes(size_t(t1) * DSP_AD_CHANNELS), sums1(size_t(t2) * DSP_AD_CHANNELS);
+    long  scan[DSP_AD_CHANNELS];
+    float out[DSP_AD_CHANNELS];
+    int   level[DSP_AD_CHANNELS];
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) level[ch] = int(Next() & 0xffff);
+
+    uint64_t mismatch = 0;
+    for (uint64_t n = 0; n < scans; n++) {
+        for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+            const uint32_t r = Next();
+            if ((r & 0xfff) == 0) level[ch] = int(r >> 16);        // full-range jump
+            else level[ch] += int(r >> 28) - 8;                     // random walk
+            if (level[ch] < 0) level[ch] = 0;
+            if (level[ch] > 0xffff) level[ch] = 0xffff;
+            scan[ch] = level[ch];
+        }
+        d.Process(scan, out);
+
+        // The first scan primes every tap, like DspFilter::Prime()
+        const int i1 = int(n % t1), i2 = int(n % t2);
+        for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+            if (n == 0) {
+                for (int k = 0; k < t1; k++) codes[k * DSP_AD_CHANNELS + ch] = level[ch];
+            }
+            codes[i1 * DSP_AD_CHANNELS + ch] = level[ch];
+            int s1 = 0;
+            for (int k = 0; k < t1; k++) s1 += codes[k * DSP_AD_CHANNELS + ch];
+            if (n == 0) {
+                for (int k = 0; k < t2; k++) sums1[k * DSP_AD_CHANNELS + ch] = s1;
+            }
+            sums1[i2 * DSP_AD_CHANNELS + ch] = s1;
+            int s2 = 0;
+            for (int k = 0; k < t2; k++) s2 += sums1[k * DSP_AD_CHANNELS + ch];
+            const float ref = float(double(s2) * d.iscale + d.offset);
+            if (ref != out[ch]) {
+                if (mismatch < 10) {
+                    std::printf("scan %llu ch %d: %.9g != %.9g\n",
+                                (unsigned long long)n, ch, out[ch], ref);
+                }
+                mismatch++;
+            }
+        }
+        if ((n & ((1u << 24) - 1)) == 0 && n > 0) {
+            std::printf("%llu samples...\n", (unsigned long long)(n * DSP_AD_CHANNELS));
+            std::fflush(stdout);
+        }
+    }
+    std::printf("kernel %s, %llu samples, mismatch %llu\n",
+                DspFilter::KernelName(DspFilter::ActiveKernel()),
+                (unsigned long long)(scans * DSP_AD_CHANNELS), (unsigned long long)mismatch);
+    return mismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * The acquisition pipeline of a rig without MFC, a window or a board:
+ * the steps AD_INPUT() and SaveToFile() take, driven by scan time.
+ *
+ * Scans come from an IAioDevice backend (AioDevice.h, default sim-fast)
+ * and go through DspFilter, the per-channel chains of the filter config,
+ * the control-rate and logging-rate RateDecimators and the calibration;
+ * every logging output becomes a voltage and a physical TSV row written
+ * with TsvLine. With a "-fast" backend the device never waits, so the
+ * run measures the pipeline itself and prints how many times real time
+ * it went.
+ *
+ * With a plant backend the loop is closed as on a rig in sync control:
+ * a DA device shares the PlantModel, and on every control-rate output
+ * the cell pressure is ramped to kCellKpa and held, then the specimen is
+ * compressed at kStrainRate, each by a PidController; the DA setpoints
+ * go through a DaOutputStage with the step's dt. Everything runs on
+ * plant (scan) time, so plant-fast replays a whole test in seconds. The
+ * control laws of the control modes themselves live in the MFC document
+ * and are not run here. The calibration is the sensor scaling of the
+ * plant configuration.
+ *
+ *   HeadlessRun [seconds=3600] [backend=sim-fast] [filter.cfg|-] [out]
+ *
+ * seconds is scan time; out is a file name prefix for <out>_vlt.tsv and
+ * <out>_phy.tsv (temporary files if omitted).
+ */
+
+#include "AioDevice.h"
+#include "AioSimDevice.h"
+#include "DaOutput.h"
+#include "DspFilter.h"
+#include "FilterChain.h"
+#include "PidController.h"
+#include "RateDecimator.h"
+#include "TsvFormat.h"
+#include "ToolCommon.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const double kFsHz          = 300.0;    // DSP_FS_HZ
+const double kControlSec    = 0.5;      // ControlInterval default
+const double kSaveSec       = 1.0;      // SaveInterval default
+const int    kCtrlWindows   = 1;        // DSP_CTRL_DEC_WINDOWS
+const int    kSaveWindows   = 4;        // DSP_SAVE_DEC_WINDOWS
+const long   kChunk         = 1000;     // scans per GetAiSamplingData()
+const double kCellKpa       = 100.0;    // plant: cell pressure target
+const double kCellRate      = 5.0;      // kPa/s ramp to it
+const double kLoadStart     = 30.0;     // s, compression starts after the cell ramp
+const double kStrainRate    = 0.1 / 60.0;   // %/s
+const double kPi            = 3.14159265358979323846;
+
+// Closed loop of a plant backend: sensor scaling, DA device, two PIDs
+struct PlantLoop {
+    PlantConfig   Cfg;
+    CAioPlantDevice* Da = nullptr;      // nullptr: open loop
+    std::unique_ptr<CAioPlantDevice> DaDev;
+    DaOutputStage Out;
+    PidController Cell, Axial;
+    uint64_t      Steps = 0;
+    double        Ea = 0.0, Sr = 0.0, Q = 0.0;
+
+    bool Attach(CAioPlantDevice* ad, std::string* err)
+    {
+        SetDefaultPlantConfig(&Cfg);
+        if (!LoadPlantConfig(GetPlantConfigPath(), &Cfg, err)) return false;
+        DaDev.reset(new CAioPlantDevice(ad->Plant(), ad->Speed()));
+        if (DaDev->Init("AIO001") != 0) return false;
+        Da = DaDev.get();
+        Out.Attach(Da, DA_OUT_CHANNELS, 10.0f, 0.0f, 16);
+
+        PidParams p;
+        SetDefaultPidParams(&p);
+        p.Enabled = true;
+        p.Kp  = 0.5;                    // kPa per kPa
+        p.Ki  = 0.2;
+        p.Kff = 1.0;
+        Cell.Configure(p);
+        Cell.SetLimits(0.0, 1000.0);
+        Cell.Reset(0.0);
+        // rpm per %/s of strain: the platen moves Lead mm per revolution
+        const double rpmPerRate = 60.0 * (Cfg.Height / 100.0) / Cfg.Lead;
+        SetDefaultPidParams(&p);
+        p.Enabled = true;
+        p.Kp  = 0.2 * rpmPerRate;       // closes a strain error in ~5 s
+        p.Kff = rpmPerRate;
+        Axial.Configure(p);
+        Axial.SetLimits(0.0, 1000.0);
+        Axial.Reset(0.0);
+        return true;
+    }
+
+    // One control step on the calibrated values phy[] at plant time t
+    void Step(double t, double dt, const double* phy)
+    {
+        const double h0 = Cfg.Height;
+        Ea = -std::log((h0 - phy[1]) / h0) * 100.0;
+        Sr = phy[4];
+        const double area = kPi * Cfg.Diameter * Cfg.Diameter / 4.0;
+        Q  = phy[0] / area * 1000.0;
+        const double cell = Cell.Update(kCellKpa, kCellRate, Sr, dt);
+        const double rpm  = (t < kLoadStart) ? Axial.Output()
+                          : Axial.Update(100.0, kStrainRate, Ea, dt);
+        float volts[DA_OUT_CHANNELS] = {};
+        volts[0] = (t < kLoadStart) ? 0.0f : 5.0f;    // motor on
+        volts[1] = 0.0f;                                // clutch down: loading
+        volts[2] = float(Cfg.MotorA * rpm + Cfg.MotorB);
+        volts[3] = float(Cfg.CellA * cell + Cfg.CellB);
+        Out.Request(volts);
+        Out.Service(dt);
+        Steps++;
+    }
+};
+
+FILE* OpenOutput(const char* prefix, const char* suffix)
+{
+    if (prefix == nullptr) return std::tmpfile();
+    const std::string path = std::string(prefix) + suffix;
+    return std::fopen(path.c_str(), "wb");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const double seconds = (argc > 1) ? std::atof(argv[1]) : 3600.0;
+    const char*  backend = (argc > 2) ? argv[2] : "sim-fast";
+    const char*  out     = (argc > 4) ? argv[4] : nullptr;
+
+    FilterConfig cfg;
+    SetDefaultFilterConfig(&cfg, kFsHz);
+    if (argc > 3 && std::strcmp(argv[3], "-") != 0) {
+        std::string err;
+        if (!LoadFilterConfig(argv[3], &cfg, &err)) {
+            std::printf("%s: %s\n", argv[3], err.c_str());
+            return 2;
+        }
+    }
+
+    std::unique_ptr<IAioDevice> dev = CreateAioDevice(backend);
+    if (!dev) {
+        std::printf("unknown backend \"%s\"\n", backend);
+        return 2;
+    }
+    short resolution = 16;
+    long ret = dev->Init("AIO000");
+    if (ret == 0) ret = dev->ResetDevice();
+    if (ret == 0) ret = dev->SetAiChannels(DSP_AD_CHANNELS);
+    if (ret == 0) ret = dev->SetAiRangeAll(1);      // ±5 V
+    if (ret == 0) ret = dev->GetAiResolution(&resolution);
+    // Same clocks as StartAcquisition()
+    const float scanClock_us = std::floor(1000000.0f / (float(cfg.FsHz) * float(DSP_AD_CHANNELS)));
+    float samplingClock = 0.0f;
+    if (ret == 0) ret = dev->SetAiSamplingClock(scanClock_us * DSP_AD_CHANNELS);
+    if (ret == 0) ret = dev->GetAiSamplingClock(&samplingClock);
+    if (ret == 0) ret = dev->SetAiScanClock(scanClock_us);
+    if (ret == 0) ret = dev->SetAiStopTrigger(4);
+    if (ret == 0) ret = dev->ResetAiMemory();
+    if (ret == 0) ret = dev->StartAi();
+    if (ret != 0) {
+        char msg[256] = "";
+        dev->GetErrorString(ret, msg);
+        std::printf("%s: error %ld %s\n", backend, ret, msg);
+        return 2;
+    }
+    const double scanPeriod = samplingClock * 1e-6;
+
+    DspFilter dsp;
+    std::memset(&dsp, 0, sizeof(dsp));
+    dsp.SetMode(DSP_MODE_EXACT);
+    dsp.SetTaps(cfg.Ma1Taps, cfg.Ma2Taps);
+    dsp.SetRange(5.0f, -5.0f, resolution);
+    ChannelFilterChain chain[DSP_AD_CHANNELS];
+    bool chainActive = false;
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+        chain[ch].Build(cfg.Chain[ch], cfg.FsHz);
+        if (!chain[ch].Empty()) chainActive = true;
+    }
+    const double ctrlSec = (cfg.ControlMs > 0) ? cfg.ControlMs / 1000.0 : kControlSec;
+    RateDecimator ctrlDec, saveDec;
+    ctrlDec.Configure(1.0 / scanPeriod, (ctrlSec > scanPeriod) ? ctrlSec : scanPeriod,
+                      DSP_AD_CHANNELS, kCtrlWindows);
+    saveDec.Configure(1.0 / scanPeriod, kSaveSec, DSP_AD_CHANNELS, kSaveWindows);
+
+    // Plant backends: DA device on the same model and the control loop
+    PlantLoop loop;
+    if (CAioPlantDevice* plant = dynamic_cast<CAioPlantDevice*>(dev.get())) {
+        std::string err;
+        if (!loop.Attach(plant, &err)) {
+            std::printf("%s: cannot open the DA side %s\n", backend, err.c_str());
+            return 2;
+        }
+    }
+
+    // Calibration as Cal_Physical() evaluates it: identity, or the plant's
+    // sensor scaling (a = 0, b, c)
+    double calA[DSP_AD_CHANNELS], calB[DSP_AD_CHANNELS], calC[DSP_AD_CHANNELS];
+    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+        calA[ch] = 0.0;
+        calB[ch] = (loop.Da != nullptr) ? loop.Cfg.SensorB[ch] : 1.0;
+        calC[ch] = (loop.Da != nullptr) ? loop.Cfg.SensorC[ch] : 0.0;
+    }
+
+    FILE* fpVlt = OpenOutput(out, "_vlt.tsv");
+    FILE* fpPhy = OpenOutput(out, "_phy.tsv");
+    if (fpVlt == nullptr || fpPhy == nullptr) {
+        std::printf("cannot create the output files\n");
+        return 2;
+    }
+
+    const uint64_t total = uint64_t(seconds / scanPeriod);
+    std::vector<long> data(size_t(kChunk) * DSP_AD_CHANNELS);
+    float raw[DSP_AD_CHANNELS];
+    double phy[DSP_AD_CHANNELS];
+    // Closed loop: read one control period at a time, so a DA write takes
+    // effect within a period of the scans it was computed from
+    const long chunk = (loop.Da != nullptr && ctrlDec.Factor() < kChunk) ? long(ctrlDec.Factor()) : kChunk;
+    TsvLine voltage, physical;
+    uint64_t scans = 0, ctrlOutputs = 0, rows = 0;
+    double pipeSec = 0.0;                   // filters, decimators, calibration, rows
+
+    const auto t0 = std::chrono::steady_clock::now();
+    while (scans < total) {
+        long n = (total - scans < uint64_t(chunk)) ? long(total - scans) : chunk;
+        ret = dev->GetAiSamplingData(&n, data.data());
+        if (ret != 0) break;                // replay at its end
+        if (n <= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));  // paced backend
+            continue;
+        }
+        const auto tp = std::chrono::steady_clock::now();
+        for (long i = 0; i < n; i++, scans++) {
+            dsp.Process(&data[size_t(i) * DSP_AD_CHANNELS], raw);
+            if (chainActive) {
+                for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+                    double y;
+                    if (!chain[ch].Empty() && chain[ch].Process(raw[ch], &y)) raw[ch] = float(y);
+                }
+            }
+            const double t = scans * scanPeriod;
+            if (ctrlDec.Push(t, raw)) {
+                ctrlOutputs++;
+                if (loop.Da != nullptr) {
+                    const float* v = ctrlDec.Output();
+                    double c[DSP_AD_CHANNELS];
+                    for (int ch = 0; ch < DSP_AD_CHANNELS; ch++)
+                        c[ch] = calA[ch] * v[ch] * v[ch] + calB[ch] * v[ch] + calC[ch];
+                    loop.Step(t, ctrlDec.Factor() * scanPeriod, c);
+                }
+            }
+            if (!saveDec.Push(t, raw)) continue;
+
+            const float* v = saveDec.Output();
+            for (int ch = 0; ch < DSP_AD_CHANNELS; ch++)
+                phy[ch] = calA[ch] * v[ch] * v[ch] + calB[ch] * v[ch] + calC[ch];
+            voltage.Clear();
+            physical.Clear();
+            voltage.Field(saveDec.OutputTime(), TSV_TIME_DECIMALS);
+            physical.Field(saveDec.OutputTime(), TSV_TIME_DECIMALS);
+            for (int ch = 0; ch < DSP_AD_CHANNELS; ch++) {
+                voltage.Field(v[ch]);
+                physical.Field(phy[ch]);
+            }
+            voltage.End();
+            physical.End();
+            voltage.Write(fpVlt);
+            physical.Write(fpPhy);
+            rows++;
+        }
+        pipeSec += tools::Seconds(tp);
+    }
+    const double wall = tools::Seconds(t0);
+    dev->StopAi();
+    dev->Exit();
+    if (loop.Da != nullptr) loop.Da->Exit();
+    std::fclose(fpVlt);
+    std::fclose(fpPhy);
+
+    const double scanSec = scans * scanPeriod;
+    std::printf("%s: %llu scans (%.0f s at %.0f sps), %llu control outputs, %llu rows\n",
+                dev->BackendName(), (unsigned long long)scans, scanSec, 1.0 / scanPeriod,
+                (unsigned long long)ctrlOutputs, (unsigned long long)rows);
+    std::printf("%.3f s wall: %.0f scans/s, x%.0f real time; pipeline %.3f s, %.2f us/scan\n",
+                wall, scans / wall, scanSec / wall, pipeSec, pipeSec / (scans > 0 ? scans : 1) * 1e6);
+    if (loop.Da != nullptr) {
+        const DaOutputStage::Stats st = loop.Out.GetStats();
+        std::printf("plant: %llu control steps, %llu DA writes; at the end ea %.3f %%, sr %.1f kPa, q %.1f kPa\n",
+                    (unsigned long long)loop.Steps, (unsigned long long)st.Writes, loop.Ea, loop.Sr, loop.Q);
+    }
+    return scans > 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef __TOOLCOMMON_H_INCLUDE__
+#define __TOOLCOMMON_H_INCLUDE__
+
+#pragma once
+
+/*
+ * Shared pieces of the stand-alone programs in tools/ (see Makefile).
+ */
+
+#include <chrono>
+#include <cstdint>
+
+namespace tools {
+
+// xorshift64: fast, and the same sequence on every platform, so a run
+// that found a mismatch can be repeated
+inline uint32_t Next()
+{
+    static uint64_t s_Rng = 0x9E3779B97F4A7C15ull;
+    s_Rng ^= s_Rng << 13;
+    s_Rng ^= s_Rng >> 7;
+    s_Rng ^= s_Rng << 17;
+    return uint32_t(s_Rng >> 32);
+}
+
+// Seconds since t0 on the steady clock
+inline double Seconds(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace tools
+
+#endif // __TOOLCOMMON_H_INCLUDE__
@@ -0,0 +1,152 @@
+﻿/*
+ * DigitShowBasic - Triaxial Test Machine Control Software
+ * Copyright (C) 2025 Makoto KUNO
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Microbenchmark of the TSV record formatting (TsvFormat.h).
+ *
+ * First checks that TsvLine::Fixed() gives the same bytes as "%lf" and
+ * "%.3lf" for a few million values (random magnitudes, tiny values and
+ * near-halfway cases). Then writes the same records the way SaveToFile()
+ * does, 16 voltages, 16 physical values and 16 parameters plus the time
+ * to three temporary files, once with fprintf() per value and once with
+ * TsvLine, and prints the time per record.
+ *
+ *   TsvBench [records=20000]
+ *
+ * Exits with 1 if any value was formatted differently from printf.
+ */
+
+#include "TsvFormat.h"
+#include "ToolCommon.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+using tools::Next;
+using tools::Seconds;
+
+// Uniform in [-2000, 2000)
+double Value()
+{
+    return (double(Next()) / 4294967296.0 - 0.5) * 4000.0;
+}
+
+uint64_t Compare(TsvLine* line, double v, int decimals)
+{
+    char ref[512];
+    std::snprintf(ref, sizeof(ref), "%.*lf", decimals, v);
+    line->Clear();
+    line->Fixed(v, decimals);
+    line->Char('\0');
+    if (std::strcmp(ref, line->Data()) == 0) return 0;
+    std::printf("%.17g: printf \"%s\", TsvLine \"%s\"\n", v, ref, line->Data());
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int records = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+    // ── Equivalence with printf ─────────────────────────────
+    TsvLine line;
+    uint64_t mismatch = 0;
+    for (int i = 0; i < 2000000 && mismatch < 10; i++) {
+        double v;
+        switch (i % 3) {
+        case 0:  v = Value(); break;
+        case 1:  v = Value() * 1e-5; break;
+        default: v = std::ldexp(Value(), int(Next() % 80) - 40); break;
+        }
+        if (i % 1000 == 0) v = (i / 1000) * 0.0000005;      // on the rounding halfway points
+        mismatch += Compare(&line, v, TSV_VALUE_DECIMALS);
+        mismatch += Compare(&line, v, TSV_TIME_DECIMALS);
+    }
+    std::printf("mismatch %llu\n", (unsigned long long)mismatch);
+
+    // ── Timing: one row to each of the three files ──────────
+    float  raw[16];
+    double phy[16], param[16];
+    for (int j = 0; j < 16; j++) {
+        raw[j]   = float(Value() / 400.0);
+        phy[j]   = Value();
+        param[j] = Value() / 7.0;
+    }
+    FILE* fp[3];
+    for (int k = 0; k < 3; k++) {
+        fp[k] = std::tmpfile();
+        if (fp[k] == nullptr) {
+            std::printf("cannot create a temporary file\n");
+            return 2;
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < records; r++) {
+        const double t = r * 0.1;
+        std::fprintf(fp[0], "%.3lf\t", t);
+        std::fprintf(fp[1], "%.3lf\t", t);
+        for (int j = 0; j < 16; j++) {
+            std::fprintf(fp[0], "%lf\t", raw[j]);
+            std::fprintf(fp[1], "%lf\t", phy[j]);
+        }
+        std::fprintf(fp[0], "\n");
+        std::fprintf(fp[1], "\n");
+        std::fprintf(fp[2], "%.3lf\t", t);
+        for (int j = 0; j < 16; j++) std::fprintf(fp[2], "%lf\t", param[j]);
+        std::fprintf(fp[2], "\n");
+    }
+    const double usPrintf = Seconds(t0) / records * 1e6;
+
+    TsvLine voltage, physical, params;
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < records; r++) {
+        const double t = r * 0.1;
+        voltage.Clear();
+        physical.Clear();
+        voltage.Field(t, TSV_TIME_DECIMALS);
+        physical.Field(t, TSV_TIME_DECIMALS);
+        for (int j = 0; j < 16; j++) {
+            voltage.Field(raw[j]);
+            physical.Field(phy[j]);
+        }
+        voltage.End();
+        physical.End();
+        voltage.Write(fp[0]);
+        physical.Write(fp[1]);
+        params.Clear();
+        params.Field(t, TSV_TIME_DECIMALS);
+        for (int j = 0; j < 16; j++) params.Field(param[j]);
+        params.End();
+        params.Write(fp[2]);
+    }
+    const double usTsv = Seconds(t0) / records * 1e6;
+    for (int k = 0; k < 3; k++) std::fclose(fp[k]);
+
+    std::printf("%d records: fprintf %.2f us/record, TsvLine %.2f us/record (x%.1f)\n",
+                records, usPrintf, usTsv, usPrintf / usTsv);
+    return mismatch == 0 ? 0 : 1;
+}